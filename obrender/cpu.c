@@ -0,0 +1,38 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   cpu.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "cpu.h"
+
+RrCpuFeatures RrCpuDetect(void)
+{
+    static gboolean done = FALSE;
+    static RrCpuFeatures features = 0;
+
+    if (done) return features;
+    done = TRUE;
+
+#ifdef RR_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        features |= RR_CPU_SSE2;
+    if (__builtin_cpu_supports("avx2"))
+        features |= RR_CPU_AVX2;
+#endif
+
+    return features;
+}
@@ -0,0 +1,41 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   cpu.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __cpu_h
+#define __cpu_h
+
+#include <glib.h>
+
+/* The SIMD code paths need a compiler which can build them for a specific
+   instruction set with the target attribute, so that the rest of the library
+   does not depend on it and they can be chosen while running */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define RR_SIMD_X86 1
+#endif
+
+typedef enum {
+    RR_CPU_SSE2 = 1 << 0,
+    RR_CPU_AVX2 = 1 << 1
+} RrCpuFeatures;
+
+/*! Returns the SIMD instruction sets that the processor supports and that
+  were compiled in */
+RrCpuFeatures RrCpuDetect(void);
+
+#endif
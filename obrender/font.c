@@ -19,6 +19,7 @@
 */
 
 #include "font.h"
+#include "fontcache.h"
 #include "color.h"
 #include "mask.h"
 #include "theme.h"
@@ -31,6 +32,9 @@
 #include <stdlib.h>
 #include <locale.h>
 
+/*! How many laid out strings each font keeps */
+#define FONT_CACHE_SIZE 256
+
 static void measure_font(const RrInstance *inst, RrFont *f)
 {
     PangoFontMetrics *metrics;
@@ -66,23 +70,12 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     RrFont *out;
     PangoWeight pweight;
     PangoStyle pstyle;
-    PangoAttrList *attrlist;
 
     out = g_slice_new(RrFont);
     out->inst = inst;
     out->ref = 1;
     out->font_desc = pango_font_description_new();
-    out->layout = pango_layout_new(inst->pango);
-    out->shortcut_underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
-    out->shortcut_underline->start_index = 0;
-    out->shortcut_underline->end_index = 0;
-
-    attrlist = pango_attr_list_new();
-    /* shortcut_underline is owned by the attrlist */
-    pango_attr_list_insert(attrlist, out->shortcut_underline);
-    /* the attributes are owned by the layout */
-    pango_layout_set_attributes(out->layout, attrlist);
-    pango_attr_list_unref(attrlist);
+    out->cache = RrFontCacheNew(FONT_CACHE_SIZE);
 
     switch (weight) {
     case RR_FONTWEIGHT_LIGHT:     pweight = PANGO_WEIGHT_LIGHT;     break;
@@ -106,10 +99,6 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     pango_font_description_set_style(out->font_desc, pstyle);
     pango_font_description_set_size(out->font_desc, size * PANGO_SCALE);
 
-    /* setup the layout */
-    pango_layout_set_font_description(out->layout, out->font_desc);
-    pango_layout_set_wrap(out->layout, PANGO_WRAP_WORD_CHAR);
-
     /* get the ascent and descent */
     measure_font(inst, out);
 
@@ -131,7 +120,7 @@ void RrFontClose(RrFont *f)
 {
     if (f) {
         if (--f->ref < 1) {
-            g_object_unref(f->layout);
+            RrFontCacheFree(f->cache);
             pango_font_description_free(f->font_desc);
             g_slice_free(RrFont, f);
         }
@@ -143,23 +132,19 @@ static void font_measure_full(const RrFont *f, const gchar *str,
                               gboolean flow, gint maxwidth)
 {
     PangoRectangle rect;
+    RrFontShape *s;
 
-    pango_layout_set_text(f->layout, str, -1);
-    if (flow) {
-        pango_layout_set_single_paragraph_mode(f->layout, FALSE);
-        pango_layout_set_width(f->layout, maxwidth * PANGO_SCALE);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_NONE);
-    }
-    else {
+    if (flow)
+        s = RrFontCacheLookup(f->cache, f, str, TRUE, maxwidth,
+                              PANGO_ELLIPSIZE_NONE, -1);
+    else
         /* single line mode */
-        pango_layout_set_single_paragraph_mode(f->layout, TRUE);
-        pango_layout_set_width(f->layout, -1);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_MIDDLE);
-    }
+        s = RrFontCacheLookup(f->cache, f, str, FALSE, -1,
+                              PANGO_ELLIPSIZE_MIDDLE, -1);
 
     /* pango_layout_get_pixel_extents lies! this is the right way to get the
        size of the text's area */
-    pango_layout_get_extents(f->layout, NULL, &rect);
+    rect = s->logical;
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
     /* pass the logical rect as the ink rect, this is on purpose so we get the
@@ -187,6 +172,12 @@ RrSize *RrFontMeasureString(const RrFont *f, const gchar *str,
     return size;
 }
 
+void RrFontCacheStats(const RrFont *f, gulong *hits, gulong *misses)
+{
+    *hits = f->cache->hits;
+    *misses = f->cache->misses;
+}
+
 gint RrFontHeight(const RrFont *f, gint shadow_y)
 {
     return (f->ascent + f->descent) / PANGO_SCALE + ABS(shadow_y);
@@ -221,8 +212,8 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     XftColor c;
     gint mw;
     PangoRectangle rect;
-    PangoAttrList *attrlist;
     PangoEllipsizeMode ell;
+    PangoLayout *layout, *shadow;
 
     g_assert(!t->flow || t->maxwidth > 0);
 
@@ -263,14 +254,15 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
         }
     }
 
-    pango_layout_set_text(t->font->layout, t->string, -1);
-    pango_layout_set_width(t->font->layout, w * PANGO_SCALE);
-    pango_layout_set_ellipsize(t->font->layout, ell);
-    pango_layout_set_single_paragraph_mode(t->font->layout, !t->flow);
+    /* the layout belongs to the cache, and is only ours until the next
+       lookup */
+    layout = RrFontCacheLookup(t->font->cache, t->font, t->string, t->flow,
+                               w, ell,
+                               t->shortcut ? t->shortcut_pos : -1)->layout;
 
     /* * * end of setting up the layout * * */
 
-    pango_layout_get_pixel_extents(t->font->layout, NULL, &rect);
+    pango_layout_get_pixel_extents(layout, NULL, &rect);
     mw = rect.width;
 
     /* pango_layout_set_alignment doesn't work with
@@ -289,6 +281,14 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     }
 
     if (t->shadow_offset_x || t->shadow_offset_y) {
+        /* the shadow doesn't get the shortcut underlined. looking it up
+           leaves the main layout second in the cache, so it stays valid */
+        if (t->shortcut)
+            shadow = RrFontCacheLookup(t->font->cache, t->font, t->string,
+                                       t->flow, w, ell, -1)->layout;
+        else
+            shadow = layout;
+
         /* From nvidia's readme (chapter 23):
 
            When rendering to a 32-bit window, keep in mind that the X RENDER
@@ -312,15 +312,15 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
                 (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-                 pango_layout_get_line_readonly(t->font->layout, 0),
+                 pango_layout_get_line_readonly(shadow, 0),
 #else
-                 pango_layout_get_line(t->font->layout, 0),
+                 pango_layout_get_line(shadow, 0),
 #endif
                  (x + t->shadow_offset_x) * PANGO_SCALE,
                  (y + t->shadow_offset_y) * PANGO_SCALE);
         }
         else {
-            pango_xft_render_layout(d, &c, t->font->layout,
+            pango_xft_render_layout(d, &c, shadow,
                                     (x + t->shadow_offset_x) * PANGO_SCALE,
                                     (y + t->shadow_offset_y) * PANGO_SCALE);
         }
@@ -332,22 +332,6 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     c.color.alpha = 0xff | 0xff << 8; /* fully opaque text */
     c.pixel = t->color->pixel;
 
-    if (t->shortcut) {
-        const gchar *s = t->string + t->shortcut_pos;
-
-        t->font->shortcut_underline->start_index = t->shortcut_pos;
-        t->font->shortcut_underline->end_index = t->shortcut_pos +
-            (g_utf8_next_char(s) - s);
-
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
-
     /* layout_line() uses y to specify the baseline
        The line doesn't need to be freed, it's a part of the layout */
     if (!t->flow) {
@@ -355,28 +339,16 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
             (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-             pango_layout_get_line_readonly(t->font->layout, 0),
+             pango_layout_get_line_readonly(layout, 0),
 #else
-             pango_layout_get_line(t->font->layout, 0),
+             pango_layout_get_line(layout, 0),
 #endif
              x * PANGO_SCALE,
              y * PANGO_SCALE);
     }
     else {
-        pango_xft_render_layout(d, &c, t->font->layout,
+        pango_xft_render_layout(d, &c, layout,
                                 x * PANGO_SCALE,
                                 y * PANGO_SCALE);
     }
-
-    if (t->shortcut) {
-        t->font->shortcut_underline->start_index = 0;
-        t->font->shortcut_underline->end_index = 0;
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
 }
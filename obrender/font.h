@@ -27,8 +27,8 @@ struct _RrFont {
     const RrInstance *inst;
     gint ref;
     PangoFontDescription *font_desc;
-    PangoLayout *layout; /*!< Used for measuring and rendering strings */
-    PangoAttribute *shortcut_underline; /*< For underlining the shortcut key */
+    /*! The strings that have been laid out for measuring and rendering */
+    struct _RrFontCache *cache;
     gint ascent; /*!< The font's ascent in pango-units */
     gint descent; /*!< The font's descent in pango-units */
 };
@@ -0,0 +1,167 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   fontcache.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "fontcache.h"
+#include "font.h"
+#include "instance.h"
+
+#include <string.h>
+
+static guint shape_hash(const RrFontShape *s)
+{
+    return s->hash;
+}
+
+static gboolean shape_equal(const RrFontShape *s1, const RrFontShape *s2)
+{
+    return s1->hash == s2->hash && s1->len == s2->len &&
+        memcmp(s1->key, s2->key, s1->len) == 0;
+}
+
+static void shape_remove(RrFontCache *self, RrFontShape *s)
+{
+    g_hash_table_remove(self->table, s);
+    g_queue_delete_link(&self->lru, s->link);
+    g_object_unref(s->layout);
+    g_free(s->key);
+    g_slice_free(RrFontShape, s);
+}
+
+static guint key_hash(const gchar *k, gsize len)
+{
+    /* FNV-1a */
+    guint32 h = 2166136261u;
+    gsize i;
+
+    for (i = 0; i < len; ++i) {
+        h ^= (guchar)k[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#define KEY_ADD(k, v) g_string_append_len((k), (const gchar*)&(v), sizeof(v))
+
+RrFontCache* RrFontCacheNew(guint max_entries)
+{
+    RrFontCache *self;
+
+    g_assert(max_entries >= 2);
+
+    self = g_slice_new0(RrFontCache);
+    self->max_entries = max_entries;
+    self->table = g_hash_table_new((GHashFunc)shape_hash,
+                                   (GEqualFunc)shape_equal);
+    g_queue_init(&self->lru);
+    return self;
+}
+
+void RrFontCacheFree(RrFontCache *self)
+{
+    if (self) {
+        while (self->lru.tail)
+            shape_remove(self, self->lru.tail->data);
+        g_hash_table_destroy(self->table);
+        g_slice_free(RrFontCache, self);
+    }
+}
+
+static PangoLayout* shape_layout(const RrFont *f, const gchar *str,
+                                 gboolean flow, gint width,
+                                 PangoEllipsizeMode ellipsize,
+                                 gint shortcut_pos)
+{
+    PangoLayout *l;
+
+    l = pango_layout_new(f->inst->pango);
+    pango_layout_set_font_description(l, f->font_desc);
+    pango_layout_set_wrap(l, PANGO_WRAP_WORD_CHAR);
+    pango_layout_set_single_paragraph_mode(l, !flow);
+    pango_layout_set_width(l, width < 0 ? -1 : width * PANGO_SCALE);
+    pango_layout_set_ellipsize(l, ellipsize);
+
+    if (shortcut_pos >= 0) {
+        PangoAttrList *attrlist;
+        PangoAttribute *a;
+        const gchar *s = str + shortcut_pos;
+
+        a = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
+        a->start_index = shortcut_pos;
+        a->end_index = shortcut_pos + (g_utf8_next_char(s) - s);
+
+        attrlist = pango_attr_list_new();
+        /* the attribute is owned by the attrlist */
+        pango_attr_list_insert(attrlist, a);
+        /* the attributes are owned by the layout */
+        pango_layout_set_attributes(l, attrlist);
+        pango_attr_list_unref(attrlist);
+    }
+
+    pango_layout_set_text(l, str, -1);
+    return l;
+}
+
+RrFontShape* RrFontCacheLookup(RrFontCache *self, const RrFont *f,
+                               const gchar *str, gboolean flow, gint width,
+                               PangoEllipsizeMode ellipsize,
+                               gint shortcut_pos)
+{
+    RrFontShape look, *s;
+    GString *key;
+    guint8 fl = !!flow;
+    guint8 ell = ellipsize;
+
+    key = g_string_sized_new(64);
+    KEY_ADD(key, fl);
+    KEY_ADD(key, ell);
+    KEY_ADD(key, width);
+    KEY_ADD(key, shortcut_pos);
+    g_string_append(key, str);
+
+    look.key = key->str;
+    look.len = key->len;
+    look.hash = key_hash(key->str, key->len);
+
+    if ((s = g_hash_table_lookup(self->table, &look))) {
+        g_string_free(key, TRUE);
+        ++self->hits;
+
+        g_queue_unlink(&self->lru, s->link);
+        g_queue_push_head_link(&self->lru, s->link);
+        return s;
+    }
+
+    ++self->misses;
+
+    s = g_slice_new(RrFontShape);
+    s->len = look.len;
+    s->hash = look.hash;
+    s->key = g_string_free(key, FALSE);
+    s->layout = shape_layout(f, str, flow, width, ellipsize, shortcut_pos);
+    /* this is where the string gets shaped */
+    pango_layout_get_extents(s->layout, NULL, &s->logical);
+
+    g_queue_push_head(&self->lru, s);
+    s->link = self->lru.head;
+    g_hash_table_insert(self->table, s, s);
+
+    while (self->lru.length > self->max_entries)
+        shape_remove(self, self->lru.tail->data);
+
+    return s;
+}
@@ -0,0 +1,81 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   fontcache.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __fontcache_h
+#define __fontcache_h
+
+#include "render.h"
+
+#include <glib.h>
+#include <pango/pango.h>
+
+typedef struct _RrFontCache RrFontCache;
+typedef struct _RrFontShape RrFontShape;
+
+/*! A string which has been laid out in a font */
+struct _RrFontShape {
+    /* the key, see RrFontCacheLookup() */
+    gchar *key;
+    gsize len;
+    guint hash;
+
+    /*! The string laid out, ready to be measured or drawn */
+    PangoLayout *layout;
+    /*! The layout's logical extents, in pango units */
+    PangoRectangle logical;
+    /*! The shape's position in the cache's lru queue */
+    GList *link;
+};
+
+/*! A cache of the strings that have been laid out in one font.
+
+  Each entry is found by a key made from the string and everything that
+  changes how it is laid out: the width it is fit into, whether it may flow
+  onto multiple lines, how it is ellipsized, and the character that is
+  underlined as a shortcut.  When the cache is full, the least recently used
+  entry is thrown away.
+*/
+struct _RrFontCache {
+    /*! The most entries the cache holds */
+    guint max_entries;
+    /*! How many lookups found their string already laid out */
+    gulong hits;
+    /*! How many lookups had to lay out their string */
+    gulong misses;
+
+    /*! RrFontShape -> RrFontShape */
+    GHashTable *table;
+    /*! The entries in the cache, the most recently used at the head */
+    GQueue lru;
+};
+
+RrFontCache* RrFontCacheNew(guint max_entries);
+void         RrFontCacheFree(RrFontCache *self);
+
+/*! Returns the string laid out in the font, laying it out if it is not in
+  the cache yet.  The shape belongs to the cache and is only valid until the
+  next lookup.
+  @param width The width to fit the string into in pixels, or -1 for no limit
+  @param shortcut_pos The byte index of the character to underline, or -1
+*/
+RrFontShape* RrFontCacheLookup(RrFontCache *self, const RrFont *f,
+                               const gchar *str, gboolean flow, gint width,
+                               PangoEllipsizeMode ellipsize,
+                               gint shortcut_pos);
+
+#endif
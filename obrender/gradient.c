@@ -21,9 +21,14 @@
 #include "render.h"
 #include "gradient.h"
 #include "color.h"
+#include "cpu.h"
 #include <glib.h>
 #include <string.h>
 
+#ifdef RR_SIMD_X86
+#include <immintrin.h>
+#endif
+
 static void highlight(RrSurface *s, RrPixel32 *x, RrPixel32 *y,
                       gboolean raised);
 static void gradient_parentrelative(RrAppearance *a, gint w, gint h);
@@ -491,6 +496,237 @@ static void gradient_solid(RrAppearance *l, gint w, gint h)
     }                                                     \
 }
 
+/*! Fills a row of pixels with a gradient from one color to another.  This is
+  the reference that the SIMD versions below must match exactly. */
+static void gradient_row_scalar(RrPixel32 *data, const RrColor *from,
+                                const RrColor *to, gint w)
+{
+    register gint x;
+
+    VARS(x);
+    SETUP(x, from, to, w);
+
+    for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
+        *(data++) = COLOR(x);
+
+        NEXT(x);
+    }
+    *data = COLOR(x);
+}
+
+#ifdef RR_SIMD_X86
+
+/* The stepping done by NEXT() has a closed form.  After p steps a color
+   channel has moved n(p) = floor((a * p + b) / d) away from where it started,
+   where d = 2 * len, a = 2 * delta, and b = len when the slope is small
+   (delta <= len), or b = d - 1 - delta when it is big.  For big slopes this
+   only holds for p > 0, the first pixel always gets the starting color.
+
+   The SIMD versions work on several pixels at once, each lane starting from
+   n(p) and the remainder of the division, and stepping ahead by the same
+   amount with integer adds and compares, so that their output is exactly
+   the same as the scalar version. */
+
+typedef struct {
+    gint start[3];
+    gint inc[3];
+    gint a[3];
+    gint b[3];
+    gint d;
+} GradientRamp;
+
+static void ramp_setup(GradientRamp *g, const RrColor *from,
+                       const RrColor *to, gint len)
+{
+    const gint f[3] = { from->r, from->g, from->b };
+    const gint t[3] = { to->r, to->g, to->b };
+    gint i;
+
+    g->d = 2 * len;
+    for (i = 0; i < 3; ++i) {
+        gint delta = ABS(t[i] - f[i]);
+
+        g->start[i] = f[i];
+        g->inc[i] = t[i] < f[i] ? -1 : 1;
+        g->a[i] = 2 * delta;
+        g->b[i] = delta > len ? g->d - 1 - delta : len;
+    }
+}
+
+/*! Finds n(p) and its remainder for a channel, rounding towards negative
+  infinity */
+static inline void ramp_at(const GradientRamp *g, gint i, gint p,
+                           gint *n, gint *r)
+{
+    gint t = g->a[i] * p + g->b[i];
+
+    *n = t / g->d;
+    *r = t % g->d;
+    if (*r < 0) {
+        --*n;
+        *r += g->d;
+    }
+}
+
+static inline RrPixel32 ramp_pixel(const GradientRamp *g, gint p)
+{
+    gint c[3], i, n, r;
+
+    for (i = 0; i < 3; ++i) {
+        if (p) {
+            ramp_at(g, i, p, &n, &r);
+            c[i] = g->start[i] + g->inc[i] * n;
+        }
+        else
+            c[i] = g->start[i];
+    }
+    return ((c[0] << RrDefaultRedOffset) +
+            (c[1] << RrDefaultGreenOffset) +
+            (c[2] << RrDefaultBlueOffset));
+}
+
+/*! Sets up the lanes of a SIMD register for a channel, for pixels 0 through
+  @lanes - 1, and how far they each move for @lanes pixels */
+static void ramp_lanes(const GradientRamp *g, gint i, gint lanes,
+                       gint *color, gint *rem, gint *step, gint *rstep)
+{
+    gint j, n;
+
+    for (j = 0; j < lanes; ++j) {
+        ramp_at(g, i, j, &n, &rem[j]);
+        color[j] = g->start[i] + g->inc[i] * n;
+    }
+    *step = g->inc[i] * (g->a[i] * lanes / g->d);
+    *rstep = g->a[i] * lanes % g->d;
+}
+
+__attribute__((target("sse2")))
+static void gradient_row_sse2(RrPixel32 *data, const RrColor *from,
+                              const RrColor *to, gint w)
+{
+    GradientRamp g;
+    __m128i color[3], rem[3], inc[3], step[3], rstep[3], d, dmax;
+    gint x, i;
+
+    ramp_setup(&g, from, to, w);
+
+    for (i = 0; i < 3; ++i) {
+        gint c[4], r[4], s, rs;
+
+        ramp_lanes(&g, i, 4, c, r, &s, &rs);
+        color[i] = _mm_setr_epi32(c[0], c[1], c[2], c[3]);
+        rem[i] = _mm_setr_epi32(r[0], r[1], r[2], r[3]);
+        inc[i] = _mm_set1_epi32(g.inc[i]);
+        step[i] = _mm_set1_epi32(s);
+        rstep[i] = _mm_set1_epi32(rs);
+    }
+    d = _mm_set1_epi32(g.d);
+    dmax = _mm_set1_epi32(g.d - 1);
+
+    for (x = 0; x + 4 <= w; x += 4) {
+        __m128i px;
+
+        px = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(color[0], RrDefaultRedOffset),
+                         _mm_slli_epi32(color[1], RrDefaultGreenOffset)),
+            _mm_slli_epi32(color[2], RrDefaultBlueOffset));
+        _mm_storeu_si128((__m128i*)(data + x), px);
+
+        for (i = 0; i < 3; ++i) {
+            __m128i carry;
+
+            color[i] = _mm_add_epi32(color[i], step[i]);
+            rem[i] = _mm_add_epi32(rem[i], rstep[i]);
+            carry = _mm_cmpgt_epi32(rem[i], dmax);
+            color[i] = _mm_add_epi32(color[i], _mm_and_si128(carry, inc[i]));
+            rem[i] = _mm_sub_epi32(rem[i], _mm_and_si128(carry, d));
+        }
+    }
+    for (; x < w; ++x)
+        data[x] = ramp_pixel(&g, x);
+
+    /* this one does not follow the formula for big slopes */
+    data[0] = ramp_pixel(&g, 0);
+}
+
+__attribute__((target("avx2")))
+static void gradient_row_avx2(RrPixel32 *data, const RrColor *from,
+                              const RrColor *to, gint w)
+{
+    GradientRamp g;
+    __m256i color[3], rem[3], inc[3], step[3], rstep[3], d, dmax;
+    gint x, i;
+
+    ramp_setup(&g, from, to, w);
+
+    for (i = 0; i < 3; ++i) {
+        gint c[8], r[8], s, rs;
+
+        ramp_lanes(&g, i, 8, c, r, &s, &rs);
+        color[i] = _mm256_setr_epi32(c[0], c[1], c[2], c[3],
+                                     c[4], c[5], c[6], c[7]);
+        rem[i] = _mm256_setr_epi32(r[0], r[1], r[2], r[3],
+                                   r[4], r[5], r[6], r[7]);
+        inc[i] = _mm256_set1_epi32(g.inc[i]);
+        step[i] = _mm256_set1_epi32(s);
+        rstep[i] = _mm256_set1_epi32(rs);
+    }
+    d = _mm256_set1_epi32(g.d);
+    dmax = _mm256_set1_epi32(g.d - 1);
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        __m256i px;
+
+        px = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi32(color[0], RrDefaultRedOffset),
+                            _mm256_slli_epi32(color[1],
+                                              RrDefaultGreenOffset)),
+            _mm256_slli_epi32(color[2], RrDefaultBlueOffset));
+        _mm256_storeu_si256((__m256i*)(data + x), px);
+
+        for (i = 0; i < 3; ++i) {
+            __m256i carry;
+
+            color[i] = _mm256_add_epi32(color[i], step[i]);
+            rem[i] = _mm256_add_epi32(rem[i], rstep[i]);
+            carry = _mm256_cmpgt_epi32(rem[i], dmax);
+            color[i] = _mm256_add_epi32(color[i],
+                                        _mm256_and_si256(carry, inc[i]));
+            rem[i] = _mm256_sub_epi32(rem[i], _mm256_and_si256(carry, d));
+        }
+    }
+    for (; x < w; ++x)
+        data[x] = ramp_pixel(&g, x);
+
+    /* this one does not follow the formula for big slopes */
+    data[0] = ramp_pixel(&g, 0);
+}
+
+#endif
+
+typedef void (*GradientRowFunc)(RrPixel32 *data, const RrColor *from,
+                                const RrColor *to, gint w);
+
+static void gradient_row_pick(RrPixel32 *data, const RrColor *from,
+                              const RrColor *to, gint w);
+
+/*! The fastest gradient_row_* that the processor can run, picked the first
+  time it is used */
+static GradientRowFunc gradient_row = gradient_row_pick;
+
+static void gradient_row_pick(RrPixel32 *data, const RrColor *from,
+                              const RrColor *to, gint w)
+{
+    gradient_row = gradient_row_scalar;
+#ifdef RR_SIMD_X86
+    if (RrCpuDetect() & RR_CPU_AVX2)
+        gradient_row = gradient_row_avx2;
+    else if (RrCpuDetect() & RR_CPU_SSE2)
+        gradient_row = gradient_row_sse2;
+#endif
+    gradient_row(data, from, to, w);
+}
+
 static void gradient_splitvertical(RrAppearance *a, gint w, gint h)
 {
     register gint y1, y2, y3;
@@ -562,22 +798,13 @@ static void gradient_splitvertical(RrAppearance *a, gint w, gint h)
 
 static void gradient_horizontal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y, cpbytes;
+    register gint y, cpbytes;
     RrPixel32 *data = sf->pixel_data, *datav;
     gchar *datac;
 
-    VARS(x);
-    SETUP(x, sf->primary, sf->secondary, w);
-
     /* set the color values for the first row */
-    datav = data;
-    for (x = w - 1; x > 0; --x) {  /* 0 -> w - 1 */
-        *datav = COLOR(x);
-        ++datav;
-        NEXT(x);
-    }
-    *datav = COLOR(x);
-    ++datav;
+    gradient_row(data, sf->primary, sf->secondary, w);
+    datav = data + w;
 
     /* copy the first row to the rest in O(logn) copies */
     datac = (gchar*)datav;
@@ -594,37 +821,18 @@ static void gradient_horizontal(RrSurface *sf, gint w, gint h)
 
 static void gradient_mirrorhorizontal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y, half1, half2, cpbytes;
+    register gint y, half1, half2, cpbytes;
     RrPixel32 *data = sf->pixel_data, *datav;
     gchar *datac;
 
-    VARS(x);
-
     half1 = (w + 1) / 2;
     half2 = w / 2;
 
     /* set the color values for the first row */
-
-    SETUP(x, sf->primary, sf->secondary, half1);
-    datav = data;
-    for (x = half1 - 1; x > 0; --x) {  /* 0 -> half1 - 1 */
-        *datav = COLOR(x);
-        ++datav;
-        NEXT(x);
-    }
-    *datav = COLOR(x);
-    ++datav;
-
-    if (half2 > 0) {
-        SETUP(x, sf->secondary, sf->primary, half2);
-        for (x = half2 - 1; x > 0; --x) {  /* 0 -> half2 - 1 */
-            *datav = COLOR(x);
-            ++datav;
-            NEXT(x);
-        }
-        *datav = COLOR(x);
-        ++datav;
-    }
+    gradient_row(data, sf->primary, sf->secondary, half1);
+    if (half2 > 0)
+        gradient_row(data + half1, sf->secondary, sf->primary, half2);
+    datav = data + w;
 
     /* copy the first row to the rest in O(logn) copies */
     datac = (gchar*)datav;
@@ -667,14 +875,13 @@ static void gradient_vertical(RrSurface *sf, gint w, gint h)
 
 static void gradient_diagonal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y;
+    register gint y;
     RrPixel32 *data = sf->pixel_data;
     RrColor left, right;
     RrColor extracorner;
 
     VARS(lefty);
     VARS(righty);
-    VARS(x);
 
     extracorner.r = (sf->primary->r + sf->secondary->r) / 2;
     extracorner.g = (sf->primary->g + sf->secondary->g) / 2;
@@ -687,14 +894,8 @@ static void gradient_diagonal(RrSurface *sf, gint w, gint h)
         COLOR_RR(lefty, (&left));
         COLOR_RR(righty, (&right));
 
-        SETUP(x, (&left), (&right), w);
-
-        for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-            *(data++) = COLOR(x);
-
-            NEXT(x);
-        }
-        *(data++) = COLOR(x);
+        gradient_row(data, &left, &right, w);
+        data += w;
 
         NEXT(lefty);
         NEXT(righty);
@@ -702,26 +903,18 @@ static void gradient_diagonal(RrSurface *sf, gint w, gint h)
     COLOR_RR(lefty, (&left));
     COLOR_RR(righty, (&right));
 
-    SETUP(x, (&left), (&right), w);
-
-    for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-        *(data++) = COLOR(x);
-
-        NEXT(x);
-    }
-    *data = COLOR(x);
+    gradient_row(data, &left, &right, w);
 }
 
 static void gradient_crossdiagonal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y;
+    register gint y;
     RrPixel32 *data = sf->pixel_data;
     RrColor left, right;
     RrColor extracorner;
 
     VARS(lefty);
     VARS(righty);
-    VARS(x);
 
     extracorner.r = (sf->primary->r + sf->secondary->r) / 2;
     extracorner.g = (sf->primary->g + sf->secondary->g) / 2;
@@ -734,14 +927,8 @@ static void gradient_crossdiagonal(RrSurface *sf, gint w, gint h)
         COLOR_RR(lefty, (&left));
         COLOR_RR(righty, (&right));
 
-        SETUP(x, (&left), (&right), w);
-
-        for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-            *(data++) = COLOR(x);
-
-            NEXT(x);
-        }
-        *(data++) = COLOR(x);
+        gradient_row(data, &left, &right, w);
+        data += w;
 
         NEXT(lefty);
         NEXT(righty);
@@ -749,14 +936,7 @@ static void gradient_crossdiagonal(RrSurface *sf, gint w, gint h)
     COLOR_RR(lefty, (&left));
     COLOR_RR(righty, (&right));
 
-    SETUP(x, (&left), (&right), w);
-
-    for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-        *(data++) = COLOR(x);
-
-        NEXT(x);
-    }
-    *data = COLOR(x);
+    gradient_row(data, &left, &right, w);
 }
 
 static void gradient_pyramid(RrSurface *sf, gint w, gint h)
@@ -769,7 +949,6 @@ static void gradient_pyramid(RrSurface *sf, gint w, gint h)
 
     VARS(lefty);
     VARS(righty);
-    VARS(x);
 
     extracorner.r = (sf->primary->r + sf->secondary->r) / 2;
     extracorner.g = (sf->primary->g + sf->secondary->g) / 2;
@@ -785,30 +964,21 @@ static void gradient_pyramid(RrSurface *sf, gint w, gint h)
 
     /* draw the top half
 
-       it is faster to draw both top quarters together than to draw one and
-       then copy it over to the other side.
+       the top left quarter is drawn a row at a time, and each row is mirrored
+       into the top right quarter while it is still in the cache.
     */
 
     ldata = sf->pixel_data;
-    rdata = ldata + w - 1;
     for (y = halfh + midy; y > 0; --y) {  /* 0 -> (h+1)/2 */
-        RrPixel32 c;
-
         COLOR_RR(lefty, (&left));
         COLOR_RR(righty, (&right));
 
-        SETUP(x, (&left), (&right), halfw + midx);
-
-        for (x = halfw + midx - 1; x > 0; --x) {  /* 0 -> (w+1)/2 */
-            c = COLOR(x);
-            *(ldata++) = *(rdata--) = c;
+        gradient_row(ldata, &left, &right, halfw + midx);
 
-            NEXT(x);
-        }
-        c = COLOR(x);
-        *ldata = *rdata = c;
-        ldata += halfw + 1;
-        rdata += halfw - 1 + midx + w;
+        rdata = ldata + w - 1;
+        for (x = 0; x < halfw; ++x)  /* the middle column is already set */
+            *(rdata--) = ldata[x];
+        ldata += w;
 
         NEXT(lefty);
         NEXT(righty);
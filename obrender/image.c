@@ -21,6 +21,7 @@
 #include "image.h"
 #include "color.h"
 #include "imagecache.h"
+#include "cpu.h"
 #ifdef USE_IMLIB2
 #include <Imlib2.h>
 #endif
@@ -31,10 +32,17 @@
 
 #include <glib.h>
 
+#ifdef RR_SIMD_X86
+#include <immintrin.h>
+#endif
+
 #define FRACTION        12
 #define FLOOR(i)        ((i) & (~0UL << FRACTION))
 #define AVERAGE(a, b)   (((((a) ^ (b)) & 0xfefefefeL) >> 1) + ((a) & (b)))
 
+/* the next value for an RrImageSet's serial */
+static gulong next_set_serial = 1;
+
 /************************************************************************
  RrImagePic functions.
 
@@ -77,6 +85,18 @@ static RrImagePic* RrImagePicNew(gint w, gint h, RrPixel32 *data)
     return pic;
 }
 
+/*! Create a new RrImagePic which owns the picture data given to it.
+  The data must have been allocated with g_malloc().
+*/
+static RrImagePic* RrImagePicNewTake(gint w, gint h, RrPixel32 *data)
+{
+    RrImagePic *pic;
+
+    pic = g_slice_new(RrImagePic);
+    RrImagePicInit(pic, w, h, data);
+    return pic;
+}
+
 
 /*! Destroy an RrImagePic.
   This frees the RrImagePic object and everything inside it.
@@ -168,6 +188,9 @@ static void RrImageSetRemovePictureAt(RrImageSet *self, gint i,
 
     g_assert(i >= 0 && i < *len);
 
+    if (original)
+        self->serial = next_set_serial++;
+
     /* remove the picture data as a key in the cache */
     g_hash_table_remove(self->cache->pic_table, (*list)[i]);
 
@@ -210,6 +233,7 @@ static void RrImageSetAddPicture(RrImageSet *self, RrImagePic *pic,
 
         list = &self->original;
         len = &self->n_original;
+        self->serial = next_set_serial++;
     }
     else {
         list = &self->resized;
@@ -352,6 +376,7 @@ RrImageSet* RrImageSetMergeSets(RrImageSet *b, RrImageSet *a)
     a->original = original;
     a->n_resized = n_resized;
     a->resized = resized;
+    a->serial = next_set_serial++;
 
     RrImageSetFree(b);
 
@@ -412,36 +437,54 @@ void RrImageSetDestroyFunc(RrImage *self, RrImageDestroyFunc func,
     self->destroy_data = data;
 }
 
-void RrImageAddFromData(RrImage *self, RrPixel32 *data, gint w, gint h)
+static void image_add(RrImage *self, RrPixel32 *data, gint w, gint h,
+                      gboolean take)
 {
     RrImagePic pic, *ppic;
     RrImageSet *set;
 
-    g_return_if_fail(self != NULL);
-    g_return_if_fail(data != NULL);
-    g_return_if_fail(w > 0 && h > 0);
-
     RrImagePicInit(&pic, w, h, data);
     set = g_hash_table_lookup(self->set->cache->pic_table, &pic);
-    if (set)
+    if (set) {
         self->set = RrImageSetMergeSets(self->set, set);
+        if (take) g_free(data);
+    }
     else {
-        ppic = RrImagePicNew(w, h, data);
+        ppic = take ? RrImagePicNewTake(w, h, data) :
+            RrImagePicNew(w, h, data);
         RrImageSetAddPicture(self->set, ppic, TRUE);
     }
 }
 
-RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
-                            gint w, gint h)
+void RrImageAddFromData(RrImage *self, RrPixel32 *data, gint w, gint h)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(data != NULL);
+    g_return_if_fail(w > 0 && h > 0);
+
+    image_add(self, data, w, h, FALSE);
+}
+
+void RrImageAddFromDataTake(RrImage *self, RrPixel32 *data, gint w, gint h)
+{
+    if (!self || !data || w <= 0 || h <= 0) {
+        /* the data belongs to us now, even though it can't be used */
+        g_free(data);
+        g_return_if_fail(self != NULL);
+        g_return_if_fail(data != NULL);
+        g_return_if_fail(w > 0 && h > 0);
+    }
+
+    image_add(self, data, w, h, TRUE);
+}
+
+static RrImage* image_new(RrImageCache *cache, RrPixel32 *data,
+                          gint w, gint h, gboolean take)
 {
     RrImagePic pic, *ppic;
     RrImage *self;
     RrImageSet *set;
 
-    g_return_val_if_fail(cache != NULL, NULL);
-    g_return_val_if_fail(data != NULL, NULL);
-    g_return_val_if_fail(w > 0 && h > 0, NULL);
-
     /* finds a picture in the cache, if it is already in there, and use the
        RrImageSet the picture lives in. */
     RrImagePicInit(&pic, w, h, data);
@@ -449,6 +492,7 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
     if (set) {
         self = set->images->data; /* just grab any RrImage from the list */
         RrImageRef(self);
+        if (take) g_free(data);
         return self;
     }
 
@@ -462,12 +506,36 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
     self->set->cache = cache;
     self->set->images = g_slist_append(self->set->images, self);
 
-    ppic = RrImagePicNew(w, h, data);
+    ppic = take ? RrImagePicNewTake(w, h, data) : RrImagePicNew(w, h, data);
     RrImageSetAddPicture(self->set, ppic, TRUE);
 
     return self;
 }
 
+RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
+                            gint w, gint h)
+{
+    g_return_val_if_fail(cache != NULL, NULL);
+    g_return_val_if_fail(data != NULL, NULL);
+    g_return_val_if_fail(w > 0 && h > 0, NULL);
+
+    return image_new(cache, data, w, h, FALSE);
+}
+
+RrImage* RrImageNewFromDataTake(RrImageCache *cache, RrPixel32 *data,
+                                gint w, gint h)
+{
+    if (!cache || !data || w <= 0 || h <= 0) {
+        /* the data belongs to us now, even though it can't be used */
+        g_free(data);
+        g_return_val_if_fail(cache != NULL, NULL);
+        g_return_val_if_fail(data != NULL, NULL);
+        g_return_val_if_fail(w > 0 && h > 0, NULL);
+    }
+
+    return image_new(cache, data, w, h, TRUE);
+}
+
 #if defined(USE_IMLIB2)
 typedef struct _ImlibLoader ImlibLoader;
 
@@ -695,6 +763,235 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
  Image drawing and resizing operations.
 **************************************************************************/
 
+/*! The source pixels that go into each destination pixel along one axis when
+  resizing an image, and how much each of them counts for */
+typedef struct {
+    /*! The size of a destination pixel, in source pixels with FRACTION bits
+      of fixed point precision */
+    gulong ratio;
+    /*! The first source pixel used for each destination pixel */
+    gint *first;
+    /*! The number of source pixels used for each destination pixel */
+    gint *count;
+    /*! The weights for the source pixels, for one destination pixel after
+      the other.  The weights for each one add up to ratio. */
+    guint16 *weight;
+} ResizeAxis;
+
+static void ResizeAxisInit(ResizeAxis *ax, gulong src, gulong dst)
+{
+    gulong d, s, s1, s2, portion;
+    gint n = 0;
+
+    ax->ratio = (src << FRACTION) / dst;
+    ax->first = g_new(gint, dst);
+    ax->count = g_new(gint, dst);
+    /* a destination pixel can cover parts of 2 source pixels more than the
+       ratio, one at each end */
+    ax->weight = g_new(guint16, dst * ((ax->ratio >> FRACTION) + 2));
+
+    s2 = 0;
+    for (d = 0; d < dst; ++d) {
+        s1 = s2;
+        s2 += ax->ratio;
+
+        ax->first[d] = s1 >> FRACTION;
+        ax->count[d] = 0;
+        for (s = s1; s < s2; s += (1UL << FRACTION)) {
+            if (s == s1) {
+                s = FLOOR(s);
+                portion = (1UL << FRACTION) - (s1 - s);
+                if (portion > s2 - s1)
+                    portion = s2 - s1;
+            }
+            else if (s == FLOOR(s2))
+                portion = s2 - s;
+            else
+                portion = (1UL << FRACTION);
+
+            ax->weight[n++] = portion;
+            ++ax->count[d];
+        }
+    }
+}
+
+static void ResizeAxisClear(ResizeAxis *ax)
+{
+    g_free(ax->first);
+    g_free(ax->count);
+    g_free(ax->weight);
+}
+
+/*! Builds a pixel from the weighted sums of each of its bytes */
+static inline RrPixel32 ResizePixel(const guint64 *sum, guint64 total)
+{
+    return ((sum[0] / total) |
+            ((sum[1] / total) << 8) |
+            ((sum[2] / total) << 16) |
+            ((sum[3] / total) << 24));
+}
+
+/*! Area-averaging resize, done as a horizontal pass into a buffer of
+  weighted sums followed by a vertical pass over that buffer.  Every byte of
+  a pixel is treated the same way, so this doesn't care about which channel
+  is which.  The sums of the horizontal pass are 32 bits, which must be
+  enough to hold 255 * ax->ratio. */
+static void ResizeScalar(const RrPixel32 *src, gulong srcW, gulong srcH,
+                         RrPixel32 *dst, gulong dstW, gulong dstH,
+                         const ResizeAxis *ax, const ResizeAxis *ay)
+{
+    guint32 *sums, *t;
+    const guint16 *w;
+    const guint64 total = (guint64)ax->ratio * ay->ratio;
+    gulong x, y;
+    gint i;
+
+    sums = t = g_new(guint32, srcH * dstW * 4);
+    for (y = 0; y < srcH; ++y) {
+        w = ax->weight;
+        for (x = 0; x < dstW; ++x, t += 4) {
+            const RrPixel32 *p = src + y * srcW + ax->first[x];
+
+            t[0] = t[1] = t[2] = t[3] = 0;
+            for (i = 0; i < ax->count[x]; ++i, ++p, ++w) {
+                t[0] += *w * (*p & 0xff);
+                t[1] += *w * ((*p >> 8) & 0xff);
+                t[2] += *w * ((*p >> 16) & 0xff);
+                t[3] += *w * (*p >> 24);
+            }
+        }
+    }
+
+    w = ay->weight;
+    for (y = 0; y < dstH; ++y) {
+        for (x = 0; x < dstW; ++x) {
+            guint64 sum[4] = { 0, 0, 0, 0 };
+
+            t = sums + (ay->first[y] * dstW + x) * 4;
+            for (i = 0; i < ay->count[y]; ++i, t += dstW * 4) {
+                sum[0] += (guint64)w[i] * t[0];
+                sum[1] += (guint64)w[i] * t[1];
+                sum[2] += (guint64)w[i] * t[2];
+                sum[3] += (guint64)w[i] * t[3];
+            }
+
+            *dst++ = ResizePixel(sum, total);
+        }
+        w += ay->count[y];
+    }
+
+    g_free(sums);
+}
+
+#ifdef RR_SIMD_X86
+/*! The same as ResizeScalar, weighing two source pixels at a time */
+__attribute__((target("sse2")))
+static void ResizeSSE2(const RrPixel32 *src, gulong srcW, gulong srcH,
+                       RrPixel32 *dst, gulong dstW, gulong dstH,
+                       const ResizeAxis *ax, const ResizeAxis *ay)
+{
+    guint32 *sums, *t;
+    const guint16 *w;
+    const guint64 total = (guint64)ax->ratio * ay->ratio;
+    const __m128i zero = _mm_setzero_si128();
+    gulong x, y;
+    gint i, n;
+
+    sums = t = g_new(guint32, srcH * dstW * 4);
+    for (y = 0; y < srcH; ++y) {
+        w = ax->weight;
+        for (x = 0; x < dstW; ++x, t += 4) {
+            const RrPixel32 *p = src + y * srcW + ax->first[x];
+            __m128i acc = zero, px;
+
+            /* interleave the bytes of two pixels as 16 bit values so that
+               pmaddwd can weigh and add them in one go */
+            for (n = ax->count[x]; n >= 2; n -= 2, p += 2, w += 2) {
+                px = _mm_unpacklo_epi8(_mm_cvtsi32_si128((gint)p[0]),
+                                       _mm_cvtsi32_si128((gint)p[1]));
+                px = _mm_unpacklo_epi8(px, zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(
+                          px, _mm_set1_epi32(w[0] | (w[1] << 16))));
+            }
+            if (n) {
+                px = _mm_unpacklo_epi8(_mm_cvtsi32_si128((gint)p[0]), zero);
+                px = _mm_unpacklo_epi8(px, zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(
+                          px, _mm_set1_epi32(w[0])));
+                ++w;
+            }
+            _mm_storeu_si128((__m128i*)t, acc);
+        }
+    }
+
+    w = ay->weight;
+    for (y = 0; y < dstH; ++y) {
+        for (x = 0; x < dstW; ++x) {
+            /* bytes 0 and 2, and 1 and 3, as 64 bit sums */
+            __m128i even = zero, odd = zero;
+            guint64 e[2], o[2], sum[4];
+
+            t = sums + (ay->first[y] * dstW + x) * 4;
+            for (i = 0; i < ay->count[y]; ++i, t += dstW * 4) {
+                __m128i s = _mm_loadu_si128((const __m128i*)t);
+                __m128i wy = _mm_set1_epi32(w[i]);
+
+                even = _mm_add_epi64(even, _mm_mul_epu32(s, wy));
+                odd = _mm_add_epi64(odd,
+                                    _mm_mul_epu32(_mm_srli_epi64(s, 32), wy));
+            }
+            _mm_storeu_si128((__m128i*)e, even);
+            _mm_storeu_si128((__m128i*)o, odd);
+            sum[0] = e[0];
+            sum[1] = o[0];
+            sum[2] = e[1];
+            sum[3] = o[1];
+
+            *dst++ = ResizePixel(sum, total);
+        }
+        w += ay->count[y];
+    }
+
+    g_free(sums);
+}
+#endif
+
+/*! Resizes the data to exactly the given size, returning a newly allocated
+  buffer */
+static RrPixel32* ResizeData(const RrPixel32 *src, gulong srcW, gulong srcH,
+                             gulong dstW, gulong dstH)
+{
+    RrPixel32 *dst, *mid = NULL;
+    ResizeAxis ax, ay;
+
+    if ((srcW << FRACTION) / dstW > G_MAXUINT32 / 0xff) {
+        /* the horizontal sums would overflow, which takes a ridiculously wide
+           image, so squash it in two steps */
+        mid = ResizeData(src, srcW, srcH, dstW * 0xff, srcH);
+        src = mid;
+        srcW = dstW * 0xff;
+    }
+
+    ResizeAxisInit(&ax, srcW, dstW);
+    ResizeAxisInit(&ay, srcH, dstH);
+    /* each destination pixel has to cover some part of the source */
+    g_assert(ax.ratio > 0 && ay.ratio > 0);
+
+    dst = g_new(RrPixel32, dstW * dstH);
+
+#ifdef RR_SIMD_X86
+    if (RrCpuDetect() & RR_CPU_SSE2)
+        ResizeSSE2(src, srcW, srcH, dst, dstW, dstH, &ax, &ay);
+    else
+#endif
+        ResizeScalar(src, srcW, srcH, dst, dstW, dstH, &ax, &ay);
+
+    ResizeAxisClear(&ax);
+    ResizeAxisClear(&ay);
+    g_free(mid);
+    return dst;
+}
+
 /*! Given a picture in RGBA format, of a specified size, resize it to the new
   requested size (but keep its aspect ratio).  If the image does not need to
   be resized (it is already the right size) then this returns NULL.  Otherwise
@@ -706,11 +1003,7 @@ static RrImagePic* ResizeImage(RrPixel32 *src,
                                gulong srcW, gulong srcH,
                                gulong dstW, gulong dstH)
 {
-    RrPixel32 *dst, *dststart;
     RrImagePic *pic;
-    gulong dstX, dstY, srcX, srcY;
-    gulong srcX1, srcX2, srcY1, srcY2;
-    gulong ratioX, ratioY;
     gulong aspectW, aspectH;
 
     g_assert(srcW > 0);
@@ -731,142 +1024,239 @@ static RrImagePic* ResizeImage(RrPixel32 *src,
     if (srcW == dstW && srcH == dstH)
         return NULL; /* no scaling needed! */
 
-    dststart = dst = g_new(RrPixel32, dstW * dstH);
-
-    ratioX = (srcW << FRACTION) / dstW;
-    ratioY = (srcH << FRACTION) / dstH;
-
-    srcY2 = 0;
-    for (dstY = 0; dstY < dstH; dstY++) {
-        srcY1 = srcY2;
-        srcY2 += ratioY;
-
-        srcX2 = 0;
-        for (dstX = 0; dstX < dstW; dstX++) {
-            gulong red = 0, green = 0, blue = 0, alpha = 0;
-            gulong portionX, portionY, portionXY, sumXY = 0;
-            RrPixel32 pixel;
-
-            srcX1 = srcX2;
-            srcX2 += ratioX;
-
-            for (srcY = srcY1; srcY < srcY2; srcY += (1UL << FRACTION)) {
-                if (srcY == srcY1) {
-                    srcY = FLOOR(srcY);
-                    portionY = (1UL << FRACTION) - (srcY1 - srcY);
-                    if (portionY > srcY2 - srcY1)
-                        portionY = srcY2 - srcY1;
-                }
-                else if (srcY == FLOOR(srcY2))
-                    portionY = srcY2 - srcY;
-                else
-                    portionY = (1UL << FRACTION);
-
-                for (srcX = srcX1; srcX < srcX2; srcX += (1UL << FRACTION)) {
-                    if (srcX == srcX1) {
-                        srcX = FLOOR(srcX);
-                        portionX = (1UL << FRACTION) - (srcX1 - srcX);
-                        if (portionX > srcX2 - srcX1)
-                            portionX = srcX2 - srcX1;
-                    }
-                    else if (srcX == FLOOR(srcX2))
-                        portionX = srcX2 - srcX;
-                    else
-                        portionX = (1UL << FRACTION);
-
-                    portionXY = (portionX * portionY) >> FRACTION;
-                    sumXY += portionXY;
-
-                    pixel = *(src + (srcY >> FRACTION) * srcW
-                            + (srcX >> FRACTION));
-                    red   += ((pixel >> RrDefaultRedOffset)   & 0xFF)
-                             * portionXY;
-                    green += ((pixel >> RrDefaultGreenOffset) & 0xFF)
-                             * portionXY;
-                    blue  += ((pixel >> RrDefaultBlueOffset)  & 0xFF)
-                             * portionXY;
-                    alpha += ((pixel >> RrDefaultAlphaOffset) & 0xFF)
-                             * portionXY;
-                }
-            }
+    pic = g_slice_new(RrImagePic);
+    RrImagePicInit(pic, dstW, dstH, ResizeData(src, srcW, srcH, dstW, dstH));
+
+    return pic;
+}
+
+#define ALPHA_MASK ((RrPixel32)0xff << RrDefaultAlphaOffset)
+
+/*! Divides by 255 with rounding, for 0 <= x <= 0xffff - 128 */
+#define DIV255(x) ((((x) + 128) + (((x) + 128) >> 8)) >> 8)
+
+/*! Blends a row of source pixels over the destination, the source's alpha
+  channel being scaled by @alpha.  The destination's alpha channel is left
+  cleared.  This is the reference for the SIMD versions below, which must
+  give exactly the same results. */
+static void BlendRowScalar(RrPixel32 *dest, const RrPixel32 *source, gint w,
+                           gint alpha)
+{
+    for (; w > 0; --w, ++dest, ++source) {
+        guint a = DIV255((*source >> RrDefaultAlphaOffset) * alpha);
+
+        if (a == 0xff)
+            *dest = *source & ~ALPHA_MASK;
+        else if (a == 0)
+            *dest &= ~ALPHA_MASK;
+        else {
+            guint r, g, b, bgr, bgg, bgb;
+
+            r = (*source >> RrDefaultRedOffset) & 0xff;
+            g = (*source >> RrDefaultGreenOffset) & 0xff;
+            b = (*source >> RrDefaultBlueOffset) & 0xff;
+
+            /* background color */
+            bgr = (*dest >> RrDefaultRedOffset) & 0xff;
+            bgg = (*dest >> RrDefaultGreenOffset) & 0xff;
+            bgb = (*dest >> RrDefaultBlueOffset) & 0xff;
 
-            g_assert(sumXY != 0);
-            red   /= sumXY;
-            green /= sumXY;
-            blue  /= sumXY;
-            alpha /= sumXY;
+            r = DIV255(r * a + bgr * (0xff - a));
+            g = DIV255(g * a + bgg * (0xff - a));
+            b = DIV255(b * a + bgb * (0xff - a));
 
-            *dst++ = (red   << RrDefaultRedOffset)   |
-                     (green << RrDefaultGreenOffset) |
-                     (blue  << RrDefaultBlueOffset)  |
-                     (alpha << RrDefaultAlphaOffset);
+            *dest = ((r << RrDefaultRedOffset) |
+                     (g << RrDefaultGreenOffset) |
+                     (b << RrDefaultBlueOffset));
         }
     }
+}
 
-    pic = g_slice_new(RrImagePic);
-    RrImagePicInit(pic, dstW, dstH, dststart);
+#ifdef RR_SIMD_X86
 
-    return pic;
+/* The SIMD versions work out the alpha for a group of pixels first, and
+   copy or skip the group if it is all opaque or all transparent, which is
+   most of any icon.  Otherwise each byte is blended as a 16 bit value, with
+   the same rounding as BlendRowScalar. */
+
+__attribute__((target("sse2")))
+static inline __m128i div255_sse2(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i blend_sse2(__m128i s, __m128i d, __m128i a)
+{
+    const __m128i ff = _mm_set1_epi16(0xff);
+
+    return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(s, a),
+                                     _mm_mullo_epi16(d, _mm_sub_epi16(ff, a))));
+}
+
+__attribute__((target("sse2")))
+static void BlendRowSSE2(RrPixel32 *dest, const RrPixel32 *source, gint w,
+                         gint alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ff = _mm_set1_epi32(0xff);
+    const __m128i rgb = _mm_set1_epi32(~ALPHA_MASK);
+    const __m128i ga = _mm_set1_epi32(alpha);
+    gint x;
+
+    for (x = 0; x + 4 <= w; x += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(source + x));
+        __m128i d, a, lo, hi;
+        gint opaque;
+
+        /* the 4 alpha values, one per 32 bit lane */
+        a = _mm_srli_epi32(s, RrDefaultAlphaOffset);
+        if (alpha != 0xff)
+            a = div255_sse2(_mm_mullo_epi16(a, ga));
+
+        opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(a, ff));
+        if (opaque == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dest + x), _mm_and_si128(s, rgb));
+            continue;
+        }
+
+        d = _mm_loadu_si128((const __m128i*)(dest + x));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dest + x), _mm_and_si128(d, rgb));
+            continue;
+        }
+
+        /* copy each pixel's alpha into all 4 of its bytes */
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+
+        lo = blend_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero),
+                        _mm_unpacklo_epi8(a, zero));
+        hi = blend_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero),
+                        _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128((__m128i*)(dest + x),
+                         _mm_and_si128(_mm_packus_epi16(lo, hi), rgb));
+    }
+    BlendRowScalar(dest + x, source + x, w - x, alpha);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i div255_avx2(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blend_avx2(__m256i s, __m256i d, __m256i a)
+{
+    const __m256i ff = _mm256_set1_epi16(0xff);
+
+    return div255_avx2(_mm256_add_epi16(
+                           _mm256_mullo_epi16(s, a),
+                           _mm256_mullo_epi16(d, _mm256_sub_epi16(ff, a))));
+}
+
+__attribute__((target("avx2")))
+static void BlendRowAVX2(RrPixel32 *dest, const RrPixel32 *source, gint w,
+                         gint alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ff = _mm256_set1_epi32(0xff);
+    const __m256i rgb = _mm256_set1_epi32(~ALPHA_MASK);
+    const __m256i ga = _mm256_set1_epi32(alpha);
+    gint x;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(source + x));
+        __m256i d, a, lo, hi;
+
+        /* the 8 alpha values, one per 32 bit lane */
+        a = _mm256_srli_epi32(s, RrDefaultAlphaOffset);
+        if (alpha != 0xff)
+            a = div255_avx2(_mm256_mullo_epi16(a, ga));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, ff)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dest + x),
+                                _mm256_and_si256(s, rgb));
+            continue;
+        }
+
+        d = _mm256_loadu_si256((const __m256i*)(dest + x));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dest + x),
+                                _mm256_and_si256(d, rgb));
+            continue;
+        }
+
+        /* copy each pixel's alpha into all 4 of its bytes */
+        a = _mm256_or_si256(a, _mm256_slli_epi32(a, 8));
+        a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+
+        /* these work within each 128 bit half, and packus puts them back in
+           the same order */
+        lo = blend_avx2(_mm256_unpacklo_epi8(s, zero),
+                        _mm256_unpacklo_epi8(d, zero),
+                        _mm256_unpacklo_epi8(a, zero));
+        hi = blend_avx2(_mm256_unpackhi_epi8(s, zero),
+                        _mm256_unpackhi_epi8(d, zero),
+                        _mm256_unpackhi_epi8(a, zero));
+        _mm256_storeu_si256((__m256i*)(dest + x),
+                            _mm256_and_si256(_mm256_packus_epi16(lo, hi),
+                                             rgb));
+    }
+    BlendRowScalar(dest + x, source + x, w - x, alpha);
+}
+
+#endif
+
+typedef void (*BlendRowFunc)(RrPixel32 *dest, const RrPixel32 *source,
+                             gint w, gint alpha);
+
+static void BlendRowPick(RrPixel32 *dest, const RrPixel32 *source, gint w,
+                         gint alpha);
+
+/*! The fastest BlendRow* that the processor can run, picked the first time
+  it is used */
+static BlendRowFunc BlendRow = BlendRowPick;
+
+static void BlendRowPick(RrPixel32 *dest, const RrPixel32 *source, gint w,
+                         gint alpha)
+{
+    BlendRow = BlendRowScalar;
+#ifdef RR_SIMD_X86
+    if (RrCpuDetect() & RR_CPU_AVX2)
+        BlendRow = BlendRowAVX2;
+    else if (RrCpuDetect() & RR_CPU_SSE2)
+        BlendRow = BlendRowSSE2;
+#endif
+    BlendRow(dest, source, w, alpha);
 }
 
 /*! This draws an RGBA picture into the target, within the rectangle specified
   by the area parameter.  If the area's size differs from the source's then it
-  will be centered within the rectangle */
+  will be centered within the rectangle.  The source must already be sized to
+  fit the area. */
 void DrawRGBA(RrPixel32 *target, gint target_w, gint target_h,
               RrPixel32 *source, gint source_w, gint source_h,
               gint alpha, RrRect *area)
 {
     RrPixel32 *dest;
-    gint col, num_pixels;
-    gint dw, dh;
+    gint y;
 
     g_assert(source_w <= area->width && source_h <= area->height);
     g_assert(area->x + area->width <= target_w);
     g_assert(area->y + area->height <= target_h);
 
-    /* keep the aspect ratio */
-    dw = area->width;
-    dh = (gint)(dw * ((gdouble)source_h / source_w));
-    if (dh > area->height) {
-        dh = area->height;
-        dw = (gint)(dh * ((gdouble)source_w / source_h));
-    }
-
     /* copy source -> dest, and apply the alpha channel.
        center the image if it is smaller than the area */
-    col = 0;
-    num_pixels = dw * dh;
-    dest = target + area->x + (area->width - dw) / 2 +
-        (target_w * (area->y + (area->height - dh) / 2));
-    while (num_pixels-- > 0) {
-        guchar a, r, g, b, bgr, bgg, bgb;
-
-        /* apply the rgba's opacity as well */
-        a = ((*source >> RrDefaultAlphaOffset) * alpha) >> 8;
-        r = *source >> RrDefaultRedOffset;
-        g = *source >> RrDefaultGreenOffset;
-        b = *source >> RrDefaultBlueOffset;
-
-        /* background color */
-        bgr = *dest >> RrDefaultRedOffset;
-        bgg = *dest >> RrDefaultGreenOffset;
-        bgb = *dest >> RrDefaultBlueOffset;
-
-        r = bgr + (((r - bgr) * a) >> 8);
-        g = bgg + (((g - bgg) * a) >> 8);
-        b = bgb + (((b - bgb) * a) >> 8);
-
-        *dest = ((r << RrDefaultRedOffset) |
-                 (g << RrDefaultGreenOffset) |
-                 (b << RrDefaultBlueOffset));
-
-        dest++;
-        source++;
-
-        if (++col >= dw) {
-            col = 0;
-            dest += target_w - dw;
-        }
+    dest = target + area->x + (area->width - source_w) / 2 +
+        (target_w * (area->y + (area->height - source_h) / 2));
+    for (y = 0; y < source_h; ++y) {
+        BlendRow(dest, source, source_w, alpha);
+        dest += target_w;
+        source += source_w;
     }
 }
 
@@ -19,6 +19,7 @@
 
 #include "render.h"
 #include "instance.h"
+#include "shm.h"
 
 static RrInstance *definst = NULL;
 
@@ -86,6 +87,8 @@ RrInstance* RrInstanceNew (Display *display, gint screen)
         g_free (definst);
         return definst = NULL;
     }
+
+    definst->shm_pool = RrShmPoolNew(definst);
     return definst;
 }
 
@@ -209,6 +212,7 @@ void RrInstanceFree (RrInstance *inst)
 {
     if (inst) {
         if (inst == definst) definst = NULL;
+        RrShmPoolFree(inst, inst->shm_pool);
         g_free(inst->pseudo_colors);
         g_hash_table_destroy(inst->color_hash);
         g_object_unref(inst->pango);
@@ -305,3 +309,8 @@ GHashTable* RrColorHash (const RrInstance *inst)
 {
     return (inst ? inst : definst)->color_hash;
 }
+
+RrShmPool* RrShm (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->shm_pool;
+}
@@ -23,6 +23,8 @@
 #include <glib.h>
 #include <pango/pangoxft.h>
 
+typedef struct _RrShmPool RrShmPool;
+
 struct _RrInstance {
     Display *display;
     gint screen;
@@ -48,10 +50,14 @@ struct _RrInstance {
     XColor *pseudo_colors;
 
     GHashTable *color_hash;
+
+    /* NULL when MIT-SHM can't be used for this display */
+    RrShmPool *shm_pool;
 };
 
 guint       RrPseudoBPC    (const RrInstance *inst);
 XColor*     RrPseudoColors (const RrInstance *inst);
 GHashTable* RrColorHash    (const RrInstance *inst);
+RrShmPool*  RrShm          (const RrInstance *inst);
 
 #endif
@@ -0,0 +1,362 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   paintcache.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "render.h"
+#include "paintcache.h"
+#include "color.h"
+#include "font.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xft/Xft.h>
+#include <string.h>
+
+typedef struct _RrPaintEntry RrPaintEntry;
+
+struct _RrPaintEntry {
+    /* the key, see build_key() */
+    gchar *key;
+    gsize len;
+    guint hash;
+
+    Pixmap pixmap;
+    /*! Unique among all entries that have ever been made */
+    gulong serial;
+    gulong bytes;
+    /*! The entry's position in the cache's lru queue */
+    GList *link;
+};
+
+/* shared between all caches so that an appearance's serials are never
+   mistaken for an entry in a different cache */
+static gulong next_serial = 1;
+
+static guint entry_hash(const RrPaintEntry *e)
+{
+    return e->hash;
+}
+
+static gboolean entry_equal(const RrPaintEntry *e1, const RrPaintEntry *e2)
+{
+    return e1->hash == e2->hash && e1->len == e2->len &&
+        memcmp(e1->key, e2->key, e1->len) == 0;
+}
+
+static void entry_free(RrPaintCache *self, RrPaintEntry *e)
+{
+    XFreePixmap(RrDisplay(self->inst), e->pixmap);
+    self->bytes -= e->bytes;
+    g_free(e->key);
+    g_slice_free(RrPaintEntry, e);
+}
+
+static void entry_remove(RrPaintCache *self, RrPaintEntry *e)
+{
+    g_hash_table_remove(self->table, e);
+    g_queue_delete_link(&self->lru, e->link);
+    entry_free(self, e);
+}
+
+RrPaintCache* RrPaintCacheNew(const RrInstance *inst, gulong max_bytes)
+{
+    RrPaintCache *self;
+
+    self = g_slice_new0(RrPaintCache);
+    self->ref = 1;
+    self->inst = inst;
+    self->max_bytes = max_bytes;
+    self->table = g_hash_table_new((GHashFunc)entry_hash,
+                                   (GEqualFunc)entry_equal);
+    g_queue_init(&self->lru);
+    return self;
+}
+
+void RrPaintCacheRef(RrPaintCache *self)
+{
+    ++self->ref;
+}
+
+void RrPaintCacheUnref(RrPaintCache *self)
+{
+    if (self && --self->ref == 0) {
+        RrPaintCacheClear(self);
+        g_hash_table_destroy(self->table);
+        g_slice_free(RrPaintCache, self);
+    }
+}
+
+void RrPaintCacheClear(RrPaintCache *self)
+{
+    while (self->lru.tail)
+        entry_remove(self, self->lru.tail->data);
+    g_assert(self->bytes == 0);
+}
+
+static void key_add(GString *k, gconstpointer p, gsize n)
+{
+    g_string_append_len(k, p, n);
+}
+
+#define KEY_ADD(k, v) key_add((k), &(v), sizeof(v))
+
+static void key_add_color(GString *k, const RrColor *c)
+{
+    gulong px = c ? RrColorPixel(c) : G_MAXULONG;
+    KEY_ADD(k, px);
+}
+
+static void key_add_string(GString *k, const gchar *s)
+{
+    /* include the terminating nul so strings can't run into each other */
+    if (s) key_add(k, s, strlen(s) + 1);
+    else key_add(k, "", 1);
+}
+
+/*! Builds a key that describes everything about the appearance that ends up
+  in its pixmap, or returns FALSE if the appearance can't be cached */
+static gboolean build_key(GString *k, RrAppearance *a, gint w, gint h)
+{
+    gint i;
+
+    KEY_ADD(k, a->id);
+    KEY_ADD(k, w);
+    KEY_ADD(k, h);
+
+    if (a->surface.grad == RR_SURFACE_PARENTREL) {
+        RrAppearance *p = a->surface.parent;
+
+        /* the parent has to have come from the cache for us to know what is
+           in it */
+        if (!p || !p->paint_serial) return FALSE;
+        KEY_ADD(k, p->paint_serial);
+        KEY_ADD(k, a->surface.parentx);
+        KEY_ADD(k, a->surface.parenty);
+    }
+
+    for (i = 0; i < a->textures; ++i) {
+        RrTextureData *d = &a->texture[i].data;
+
+        KEY_ADD(k, a->texture[i].type);
+        switch (a->texture[i].type) {
+        case RR_TEXTURE_NONE:
+            break;
+        case RR_TEXTURE_MASK:
+            key_add_color(k, d->mask.color);
+            KEY_ADD(k, d->mask.mask);
+            break;
+        case RR_TEXTURE_TEXT:
+            KEY_ADD(k, d->text.font);
+            KEY_ADD(k, d->text.justify);
+            key_add_color(k, d->text.color);
+            KEY_ADD(k, d->text.shadow_offset_x);
+            KEY_ADD(k, d->text.shadow_offset_y);
+            key_add_color(k, d->text.shadow_color);
+            KEY_ADD(k, d->text.shadow_alpha);
+            KEY_ADD(k, d->text.shortcut);
+            KEY_ADD(k, d->text.shortcut_pos);
+            KEY_ADD(k, d->text.ellipsize);
+            KEY_ADD(k, d->text.flow);
+            KEY_ADD(k, d->text.maxwidth);
+            key_add_string(k, d->text.string);
+            break;
+        case RR_TEXTURE_LINE_ART:
+            key_add_color(k, d->lineart.color);
+            KEY_ADD(k, d->lineart.x1);
+            KEY_ADD(k, d->lineart.y1);
+            KEY_ADD(k, d->lineart.x2);
+            KEY_ADD(k, d->lineart.y2);
+            break;
+        case RR_TEXTURE_IMAGE:
+            KEY_ADD(k, d->image.image->set->serial);
+            KEY_ADD(k, d->image.alpha);
+            KEY_ADD(k, d->image.tx);
+            KEY_ADD(k, d->image.ty);
+            KEY_ADD(k, d->image.twidth);
+            KEY_ADD(k, d->image.theight);
+            break;
+        case RR_TEXTURE_RGBA:
+            /* the pixels behind this can change without the pointer to them
+               changing, so there is nothing to key it on */
+            return FALSE;
+        case RR_TEXTURE_NUM_TYPES:
+            g_assert_not_reached();
+        }
+    }
+    return TRUE;
+}
+
+static guint key_hash(const gchar *k, gsize len)
+{
+    /* FNV-1a */
+    guint32 h = 2166136261u;
+    gsize i;
+
+    for (i = 0; i < len; ++i) {
+        h ^= (guchar)k[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void drop_pixmap(RrAppearance *a)
+{
+    if (a->xftdraw != NULL) {
+        XftDrawDestroy(a->xftdraw);
+        a->xftdraw = NULL;
+    }
+    if (a->pixmap != None) {
+        XFreePixmap(RrDisplay(a->inst), a->pixmap);
+        a->pixmap = None;
+    }
+}
+
+/*! Make the appearance's pixel_data hold what it was last painted with, as
+  parent-relative children are rendered from it */
+static void restore_pixel_data(RrAppearance *a)
+{
+    gulong serial;
+    Pixmap oldp;
+
+    if (!a->paint_serial || a->data_serial == a->paint_serial)
+        return;
+
+    if (a->surface.grad == RR_SURFACE_PARENTREL && a->surface.parent)
+        restore_pixel_data(a->surface.parent);
+
+    serial = a->paint_serial;
+    oldp = RrPaintPixmap(a, a->paint_w, a->paint_h);
+    if (oldp) XFreePixmap(RrDisplay(a->inst), oldp);
+    /* the cache already has a pixmap for this, we only wanted the data */
+    drop_pixmap(a);
+    a->paint_serial = a->data_serial = serial;
+}
+
+/*! Finds the entry holding the appearance painted at the given size, painting
+  it into a new entry if there isn't one.  Returns FALSE if the appearance
+  can't be cached.  Otherwise @entry is set to the entry, or to NULL if there
+  was nothing to paint. */
+static gboolean paint_entry(RrPaintCache *self, RrAppearance *a,
+                            gint w, gint h, RrPaintEntry **entry)
+{
+    RrPaintEntry look, *e;
+    GString *key;
+
+    *entry = NULL;
+
+    key = g_string_sized_new(64);
+    if (w <= 0 || h <= 0 || !build_key(key, a, w, h)) {
+        g_string_free(key, TRUE);
+        return FALSE;
+    }
+
+    look.key = key->str;
+    look.len = key->len;
+    look.hash = key_hash(key->str, key->len);
+
+    if ((e = g_hash_table_lookup(self->table, &look))) {
+        g_string_free(key, TRUE);
+
+        g_queue_unlink(&self->lru, e->link);
+        g_queue_push_head_link(&self->lru, e->link);
+    }
+    else {
+        Pixmap oldp;
+
+        if (a->surface.grad == RR_SURFACE_PARENTREL)
+            restore_pixel_data(a->surface.parent);
+
+        /* the pixmap will belong to the cache, not the appearance */
+        drop_pixmap(a);
+        oldp = RrPaintPixmap(a, w, h);
+        g_assert(oldp == None);
+        if (a->pixmap == None) {
+            /* there was nothing to paint */
+            g_string_free(key, TRUE);
+            return TRUE;
+        }
+
+        e = g_slice_new(RrPaintEntry);
+        e->len = look.len;
+        e->hash = look.hash;
+        e->key = g_string_free(key, FALSE);
+        e->pixmap = a->pixmap;
+        e->serial = next_serial++;
+        /* roughly how much memory the X server uses for the pixmap */
+        e->bytes = (gulong)w * h * (RrDepth(a->inst) > 16 ? 4 :
+                                    (RrDepth(a->inst) > 8 ? 2 : 1));
+
+        a->pixmap = None;
+        if (a->xftdraw != NULL) {
+            XftDrawDestroy(a->xftdraw);
+            a->xftdraw = NULL;
+        }
+        a->data_serial = e->serial;
+
+        g_hash_table_insert(self->table, e, e);
+        g_queue_push_head(&self->lru, e);
+        e->link = self->lru.head;
+        self->bytes += e->bytes;
+
+        /* make room, but always keep the entry we are about to show */
+        while (self->bytes > self->max_bytes && self->lru.tail->data != e)
+            entry_remove(self, self->lru.tail->data);
+    }
+
+    a->paint_serial = e->serial;
+    a->paint_w = w;
+    a->paint_h = h;
+
+    *entry = e;
+    return TRUE;
+}
+
+void RrPaintCached(RrPaintCache *self, RrAppearance *a, Window win,
+                   gint w, gint h)
+{
+    RrPaintEntry *e;
+
+    if (!paint_entry(self, a, w, h, &e)) {
+        if (a->surface.grad == RR_SURFACE_PARENTREL && a->surface.parent)
+            restore_pixel_data(a->surface.parent);
+        RrPaint(a, win, w, h);
+        return;
+    }
+    if (!e) return;
+
+    XSetWindowBackgroundPixmap(RrDisplay(a->inst), win, e->pixmap);
+    XClearWindow(RrDisplay(a->inst), win);
+}
+
+Pixmap RrPaintCachedPixmap(RrPaintCache *self, RrAppearance *a,
+                           gint w, gint h)
+{
+    RrPaintEntry *e;
+
+    if (!paint_entry(self, a, w, h, &e)) {
+        Pixmap oldp;
+
+        if (w <= 0 || h <= 0) return None;
+
+        if (a->surface.grad == RR_SURFACE_PARENTREL && a->surface.parent)
+            restore_pixel_data(a->surface.parent);
+        /* paint it into the appearance's own pixmap instead */
+        oldp = RrPaintPixmap(a, w, h);
+        if (oldp) XFreePixmap(RrDisplay(a->inst), oldp);
+        return a->pixmap;
+    }
+    return e ? e->pixmap : None;
+}
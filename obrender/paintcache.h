@@ -0,0 +1,52 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   paintcache.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __paintcache_h
+#define __paintcache_h
+
+#include "render.h"
+
+#include <glib.h>
+
+/*! A cache of pixmaps that have been painted for appearances.
+
+  Each entry is found by a key made from the appearance, the size it was
+  painted at, and everything in its textures that changes what ends up in the
+  pixmap (such as the text being drawn).  For parent-relative appearances,
+  the key also includes the entry that their parent was last painted from, so
+  a title's label is only reused on top of the same title.
+
+  Windows hold their own reference to their background pixmap in the X
+  server, so evicting an entry never changes what is on screen.
+*/
+struct _RrPaintCache {
+    gint ref;
+    const RrInstance *inst;
+
+    /*! The most memory that the pixmaps in the cache should use, roughly */
+    gulong max_bytes;
+    /*! The memory being used by the pixmaps in the cache right now */
+    gulong bytes;
+
+    /*! RrPaintEntry -> RrPaintEntry */
+    GHashTable *table;
+    /*! The entries in the cache, the most recently used at the head */
+    GQueue lru;
+};
+
+#endif
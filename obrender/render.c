@@ -25,6 +25,7 @@
 #include "color.h"
 #include "image.h"
 #include "theme.h"
+#include "shm.h"
 
 #include <glib.h>
 #include <X11/Xlib.h>
@@ -38,6 +39,11 @@
 static void pixel_data_to_pixmap(RrAppearance *l,
                                  gint x, gint y, gint w, gint h);
 
+/* used to give each appearance a unique id, so that RrPaintCache keys never
+   match an appearance which was freed and replaced by another at the same
+   address */
+static guint next_appearance_id = 1;
+
 Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
 {
     gint i, transferred = 0, force_transfer = 0;
@@ -61,6 +67,9 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
 
     resized = (a->w != w || a->h != h);
 
+    /* the pixel data won't be anything that the paint cache knows about */
+    a->paint_serial = a->data_serial = 0;
+
     oldp = a->pixmap; /* save to free after changing the visible pixmap */
     a->pixmap = XCreatePixmap(RrDisplay(a->inst),
                               RrRootWindow(a->inst),
@@ -204,6 +213,7 @@ RrAppearance *RrAppearanceNew(const RrInstance *inst, gint numtex)
 
   out = g_slice_new0(RrAppearance);
   out->inst = inst;
+  out->id = next_appearance_id++;
   out->textures = numtex;
   out->surface.bevel_light_adjust = 128;
   out->surface.bevel_dark_adjust = 64;
@@ -315,6 +325,9 @@ RrAppearance *RrAppearanceCopy(RrAppearance *orig)
     copy->pixmap = None;
     copy->xftdraw = NULL;
     copy->w = copy->h = 0;
+    copy->id = next_appearance_id++;
+    copy->paint_serial = copy->data_serial = 0;
+    copy->paint_w = copy->paint_h = 0;
     return copy;
 }
 
@@ -348,6 +361,14 @@ static void pixel_data_to_pixmap(RrAppearance *l,
     RrPixel32 *in, *scratch;
     Pixmap out;
     XImage *im = NULL;
+
+    /* avoid pushing the image through the X socket when we can share the
+       memory with the server */
+    if (RrShmPutImage(l->inst, l->pixmap,
+                      DefaultGC(RrDisplay(l->inst), RrScreen(l->inst)),
+                      l->surface.pixel_data, x, y, w, h))
+        return;
+
     im = XCreateImage(RrDisplay(l->inst), RrVisual(l->inst), RrDepth(l->inst),
                       ZPixmap, 0, NULL, w, h, 32, 0);
     g_assert(im != NULL);
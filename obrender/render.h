@@ -47,6 +47,7 @@ typedef struct _RrImage            RrImage;
 typedef struct _RrImageSet         RrImageSet;
 typedef struct _RrImagePic         RrImagePic;
 typedef struct _RrImageCache       RrImageCache;
+typedef struct _RrPaintCache       RrPaintCache;
 typedef struct _RrButton           RrButton;
 
 typedef guint32 RrPixel32;  /* ARGB format, not premultiplied alpha */
@@ -231,6 +232,12 @@ struct _RrAppearance {
 
     /* cached for internal use */
     gint w, h;
+
+    /* used by RrPaintCached */
+    guint id;
+    gulong paint_serial; /* the cache entry this was last painted from */
+    gulong data_serial;  /* the cache entry in surface.pixel_data */
+    gint paint_w, paint_h;
 };
 
 /*! Holds a RGBA image picture */
@@ -285,6 +292,10 @@ struct _RrImageSet
       RrImage. */
     RrImagePic **resized;
     gint n_resized;
+
+    /*! Changes every time the "original" pictures in the set change, and is
+      never the same for two sets. */
+    gulong serial;
 };
 
 struct _RrButton {
@@ -397,12 +408,27 @@ RrSize *RrFontMeasureString (const RrFont *f, const gchar *str,
                              gboolean flow, gint maxwidth);
 gint    RrFontHeight        (const RrFont *f, gint shadow_offset_y);
 gint    RrFontMaxCharWidth  (const RrFont *f);
+/*! Gives how many times the font found a string it had already laid out,
+  and how many times it had to lay one out */
+void    RrFontCacheStats    (const RrFont *f, gulong *hits, gulong *misses);
 
 /* Paint into the appearance. The old pixmap is returned (if there was one). It
    is the responsibility of the caller to call XFreePixmap on the return when
    it is non-null. */
 Pixmap RrPaintPixmap (RrAppearance *a, gint w, gint h);
 void   RrPaint       (RrAppearance *a, Window win, gint w, gint h);
+/*! Paint into the window like RrPaint, but reuse a pixmap from the cache when
+  the appearance has been painted with the same size and contents before.
+  Parent-relative appearances must be painted with the same cache as their
+  parent. */
+void   RrPaintCached (RrPaintCache *cache, RrAppearance *a, Window win,
+                      gint w, gint h);
+/*! Paint the appearance like RrPaintCached, but return the pixmap that holds
+  it instead of putting it in a window.  The pixmap belongs to the cache or to
+  the appearance, and is only good until the next time either is painted, so
+  copy from it straight away.  Returns None if there was nothing to paint. */
+Pixmap RrPaintCachedPixmap(RrPaintCache *cache, RrAppearance *a,
+                           gint w, gint h);
 void   RrMinSize     (RrAppearance *a, gint *w, gint *h);
 gint   RrMinWidth    (RrAppearance *a);
 /* For text textures, if flow is TRUE, then the string must be set before
@@ -421,6 +447,16 @@ RrImageCache* RrImageCacheNew(gint max_resized_saved);
 void          RrImageCacheRef(RrImageCache *self);
 void          RrImageCacheUnref(RrImageCache *self);
 
+/*! Create a new cache for painted appearances.
+  @param max_bytes The amount of memory the cached pixmaps may use in the X
+    server before the least recently used ones are thrown away
+*/
+RrPaintCache* RrPaintCacheNew(const RrInstance *inst, gulong max_bytes);
+void          RrPaintCacheRef(RrPaintCache *self);
+void          RrPaintCacheUnref(RrPaintCache *self);
+/*! Throw away all of the pixmaps in the cache */
+void          RrPaintCacheClear(RrPaintCache *self);
+
 /*! Create a new image, or return one from the cache that matches.
   @param cache The image cache.
   @param old The current RrImage, which the new image should be added to.
@@ -444,6 +480,10 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name);
 */
 RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
                             gint w, gint h);
+/*! Like RrImageNewFromData, but the image takes ownership of the data instead
+  of copying it.  The data must have been allocated with g_malloc(). */
+RrImage* RrImageNewFromDataTake(RrImageCache *cache, RrPixel32 *data,
+                                gint w, gint h);
 
 /*! Add a new size of a picture to an image.
   If a picture has multiple versions of different sizes (example 16x16, 32x32
@@ -453,6 +493,9 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
   different dimention.
 */
 void RrImageAddFromData(RrImage *image, RrPixel32 *data, gint w, gint h);
+/*! Like RrImageAddFromData, but the image takes ownership of the data instead
+  of copying it.  The data must have been allocated with g_malloc(). */
+void RrImageAddFromDataTake(RrImage *image, RrPixel32 *data, gint w, gint h);
 
 void RrImageRef(RrImage *im);
 void RrImageUnref(RrImage *im);
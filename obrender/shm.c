@@ -0,0 +1,264 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   shm.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "render.h"
+#include "instance.h"
+#include "color.h"
+#include "shm.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#ifdef XSHM
+#include <X11/extensions/XShm.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+#ifdef XSHM
+
+/*! Images smaller than this many pixels are cheaper to send with a plain
+  XPutImage than to synchronize with the X server over the shared segment */
+#define SHM_MIN_PIXELS (64 * 64)
+/*! How many segments are used in turn, so that the next image can be
+  written into one while the server is still reading from another */
+#define SHM_SEGMENTS 2
+
+typedef struct _RrShmSegment RrShmSegment;
+
+struct _RrShmSegment {
+    XShmSegmentInfo info;
+    /*! The size of the attached segment in bytes, 0 if nothing is attached */
+    gsize size;
+    /*! The serial of the last XShmPutImage that read from the segment */
+    gulong busy_serial;
+    gboolean busy;
+};
+
+struct _RrShmPool {
+    RrShmSegment segments[SHM_SEGMENTS];
+    /*! The segment to try using first for the next image */
+    guint next;
+    /*! Set when attaching a segment failed, we don't try again after that */
+    gboolean broken;
+};
+
+static gboolean attach_error;
+
+static int attach_error_handler(Display *d, XErrorEvent *e)
+{
+    attach_error = TRUE;
+    return 0;
+}
+
+static gboolean display_is_local(Display *d)
+{
+    const gchar *s = DisplayString(d);
+    const gchar *c = strrchr(s, ':');
+
+    /* ":0" and "unix:0" are local, anything with a host name is not */
+    if (!c) return FALSE;
+    return c == s || (c - s == 4 && !strncmp(s, "unix", 4));
+}
+
+static void segment_detach(const RrInstance *inst, RrShmSegment *p)
+{
+    if (!p->size) return;
+
+    XShmDetach(RrDisplay(inst), &p->info);
+    /* the server must be done with the memory before it goes away */
+    XSync(RrDisplay(inst), False);
+    shmdt(p->info.shmaddr);
+    p->size = 0;
+    p->busy = FALSE;
+}
+
+static gboolean segment_attach(const RrInstance *inst, RrShmSegment *p,
+                               gsize size)
+{
+    Display *d = RrDisplay(inst);
+    XErrorHandler old;
+    gsize page = sysconf(_SC_PAGESIZE);
+
+    g_assert(p->size == 0);
+
+    size = (size + page - 1) / page * page;
+
+    p->info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (p->info.shmid < 0)
+        return FALSE;
+
+    p->info.shmaddr = shmat(p->info.shmid, NULL, 0);
+    if (p->info.shmaddr == (gchar*)-1) {
+        shmctl(p->info.shmid, IPC_RMID, NULL);
+        return FALSE;
+    }
+    p->info.readOnly = True;
+
+    /* a remote server will refuse to attach, catch the error for that */
+    XSync(d, False);
+    attach_error = FALSE;
+    old = XSetErrorHandler(attach_error_handler);
+    XShmAttach(d, &p->info);
+    XSync(d, False);
+    XSetErrorHandler(old);
+
+    /* the segment is destroyed once both of us have detached from it, so it
+       can't leak even if we crash */
+    shmctl(p->info.shmid, IPC_RMID, NULL);
+
+    if (attach_error) {
+        shmdt(p->info.shmaddr);
+        return FALSE;
+    }
+
+    p->size = size;
+    p->busy = FALSE;
+    return TRUE;
+}
+
+RrShmPool* RrShmPoolNew(const RrInstance *inst)
+{
+    RrShmPool *p;
+
+    if (!XShmQueryExtension(RrDisplay(inst)) ||
+        !display_is_local(RrDisplay(inst)))
+        return NULL;
+
+    p = g_slice_new0(RrShmPool);
+
+    /* make sure we can actually share memory with the server before
+       claiming to support it */
+    if (!segment_attach(inst, &p->segments[0],
+                        SHM_MIN_PIXELS * sizeof(RrPixel32)))
+    {
+        g_slice_free(RrShmPool, p);
+        return NULL;
+    }
+    return p;
+}
+
+void RrShmPoolFree(const RrInstance *inst, RrShmPool *p)
+{
+    if (p) {
+        guint i;
+
+        for (i = 0; i < SHM_SEGMENTS; ++i)
+            segment_detach(inst, &p->segments[i]);
+        g_slice_free(RrShmPool, p);
+    }
+}
+
+/*! Picks the segment to write the next image into, waiting for the server
+  to finish reading from one if it may still be using all of them */
+static RrShmSegment* segment_next(Display *dpy, RrShmPool *p)
+{
+    RrShmSegment *s;
+    guint i;
+
+    for (i = 0; i < SHM_SEGMENTS; ++i) {
+        s = &p->segments[(p->next + i) % SHM_SEGMENTS];
+        if (!s->busy ||
+            (glong)(LastKnownRequestProcessed(dpy) - s->busy_serial) >= 0)
+        {
+            p->next = (p->next + i + 1) % SHM_SEGMENTS;
+            return s;
+        }
+    }
+
+    /* the server may still be reading out of every segment */
+    XSync(dpy, False);
+    for (i = 0; i < SHM_SEGMENTS; ++i)
+        p->segments[i].busy = FALSE;
+
+    s = &p->segments[p->next];
+    p->next = (p->next + 1) % SHM_SEGMENTS;
+    return s;
+}
+
+gboolean RrShmPutImage(const RrInstance *inst, Drawable d, GC gc,
+                       RrPixel32 *data, gint x, gint y, gint w, gint h)
+{
+    RrShmPool *pool = RrShm(inst);
+    RrShmSegment *p;
+    Display *dpy = RrDisplay(inst);
+    XImage *im;
+    gsize need;
+
+    if (!pool || pool->broken || w * h < SHM_MIN_PIXELS)
+        return FALSE;
+
+    p = segment_next(dpy, pool);
+
+    im = XShmCreateImage(dpy, RrVisual(inst), RrDepth(inst), ZPixmap,
+                         NULL, &p->info, w, h);
+    if (!im)
+        return FALSE;
+
+    need = im->bytes_per_line * im->height;
+    if (need > p->size) {
+        /* grow geometrically so that a window being resized doesn't make us
+           reallocate the segment every time */
+        need = MAX(need, p->size * 2);
+        segment_detach(inst, p);
+        if (!segment_attach(inst, p, need)) {
+            pool->broken = TRUE;
+            XDestroyImage(im);
+            return FALSE;
+        }
+    }
+
+    im->data = p->info.shmaddr;
+    RrReduceDepth(inst, data, im);
+    if (im->data != p->info.shmaddr) {
+        /* RrReduceDepth hands back the source data when it is already in the
+           visual's format, so copy it in ourselves */
+        memcpy(p->info.shmaddr, im->data, im->bytes_per_line * im->height);
+        im->data = p->info.shmaddr;
+    }
+
+    p->busy_serial = NextRequest(dpy);
+    p->busy = TRUE;
+    XShmPutImage(dpy, d, gc, im, 0, 0, x, y, w, h, False);
+
+    /* this only frees the XImage structure for shm images */
+    XDestroyImage(im);
+    return TRUE;
+}
+
+#else
+
+RrShmPool* RrShmPoolNew(const RrInstance *inst)
+{
+    return NULL;
+}
+
+void RrShmPoolFree(const RrInstance *inst, RrShmPool *p)
+{
+}
+
+gboolean RrShmPutImage(const RrInstance *inst, Drawable d, GC gc,
+                       RrPixel32 *data, gint x, gint y, gint w, gint h)
+{
+    return FALSE;
+}
+
+#endif
@@ -0,0 +1,39 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   shm.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __shm_h
+#define __shm_h
+
+#include "render.h"
+#include "instance.h"
+
+#include <X11/Xlib.h>
+
+/*! Creates the MIT-SHM segment pool for an instance.  Returns NULL when the
+  extension is missing, was not compiled in, or the X server can not attach
+  to our memory (such as when the display is remote). */
+RrShmPool* RrShmPoolNew(const RrInstance *inst);
+void RrShmPoolFree(const RrInstance *inst, RrShmPool *pool);
+
+/*! Converts the ARGB data to the instance's visual straight into the pooled
+  shared memory segment and copies it into the drawable with XShmPutImage.
+  Returns FALSE if the caller needs to transfer the data some other way. */
+gboolean RrShmPutImage(const RrInstance *inst, Drawable d, GC gc,
+                       RrPixel32 *data, gint x, gint y, gint w, gint h);
+
+#endif
@@ -23,13 +23,14 @@
 #include "mask.h"
 #include "theme.h"
 #include "icon.h"
+#include "themecache.h"
 #include "obt/paths.h"
 
 #include <X11/Xlib.h>
-#include <X11/Xresource.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 struct fallbacks {
     RrAppearance *focused_disabled;
@@ -48,21 +49,21 @@ struct fallbacks {
     RrAppearance *unfocused_pressed_toggled;
 };
 
-static XrmDatabase loaddb(const gchar *name, gchar **path);
-static gboolean read_int(XrmDatabase db, const gchar *rname, gint *value);
-static gboolean read_string(XrmDatabase db, const gchar *rname, gchar **value);
-static gboolean read_color(XrmDatabase db, const RrInstance *inst,
+static RrThemeCache* loaddb(const gchar *name, gchar **path);
+static gboolean read_int(RrThemeCache *db, const gchar *rname, gint *value);
+static gboolean read_string(RrThemeCache *db, const gchar *rname,
+                            gchar **value);
+static gboolean read_color(RrThemeCache *db, const RrInstance *inst,
                            const gchar *rname, RrColor **value);
-static gboolean read_mask(const RrInstance *inst, const gchar *path,
+static gboolean read_mask(RrThemeCache *db, const RrInstance *inst,
                           const gchar *maskname, RrPixmapMask **value);
-static gboolean read_appearance(XrmDatabase db, const RrInstance *inst,
+static gboolean read_appearance(RrThemeCache *db, const RrInstance *inst,
                                 const gchar *rname, RrAppearance *value,
                                 gboolean allow_trans);
 static int parse_inline_number(const char *p);
 static RrPixel32* read_c_image(gint width, gint height, const guint8 *data);
 static void set_default_appearance(RrAppearance *a);
-static void read_button_styles(XrmDatabase db, const RrInstance *inst, 
-                               gchar *path,
+static void read_button_styles(RrThemeCache *db, const RrInstance *inst, 
                                const RrTheme *theme, RrButton *btn, 
                                const gchar *btnname,
                                struct fallbacks *fbs,
@@ -101,7 +102,7 @@ static RrFont *get_font(RrFont *target, RrFont **default_font,
         x_var = x_def;
 
 #define READ_MASK_COPY(x_file, x_var, x_copysrc) \
-    if (!read_mask(inst, path, x_file, & x_var)) \
+    if (!read_mask(db, inst, x_file, & x_var)) \
         x_var = RrPixmapMaskCopy(x_copysrc);
 
 #define READ_APPEARANCE(x_resstr, x_var, x_parrel) \
@@ -132,7 +133,7 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
                     RrFont *menu_title_font, RrFont *menu_item_font,
                     RrFont *active_osd_font, RrFont *inactive_osd_font)
 {
-    XrmDatabase db = NULL;
+    RrThemeCache *db = NULL;
     RrJustify winjust, mtitlejust;
     gchar *str;
     RrTheme *theme;
@@ -140,6 +141,7 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     gchar *path;
     gint menu_overlap = 0;
     struct fallbacks fbs;
+    struct stat st;
 
     if (name) {
         db = loaddb(name, &path);
@@ -487,14 +489,14 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     {
         guchar normal_mask[] =  { 0x3f, 0x3f, 0x21, 0x21, 0x21, 0x3f };
         guchar toggled_mask[] = { 0x3e, 0x22, 0x2f, 0x29, 0x39, 0x0f };
-        read_button_styles(db, inst, path, theme, theme->btn_max, "max",
+        read_button_styles(db, inst, theme, theme->btn_max, "max",
                            &fbs, normal_mask, toggled_mask);
     }
 
     /* close button */
     {
         guchar normal_mask[] = { 0x33, 0x3f, 0x1e, 0x1e, 0x3f, 0x33 };
-        read_button_styles(db, inst, path, theme, theme->btn_close, "close",
+        read_button_styles(db, inst, theme, theme->btn_close, "close",
                            &fbs, normal_mask, NULL);
     }
 
@@ -502,26 +504,26 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     {
         guchar normal_mask[] =  { 0x33, 0x33, 0x00, 0x00, 0x33, 0x33 };
         guchar toggled_mask[] = { 0x00, 0x1e, 0x1a, 0x16, 0x1e, 0x00 };
-        read_button_styles(db, inst, path, theme, theme->btn_desk, "desk",
+        read_button_styles(db, inst, theme, theme->btn_desk, "desk",
                            &fbs, normal_mask, toggled_mask);
     }
 
     /* shade button */
     {
         guchar normal_mask[] = { 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00 };
-        read_button_styles(db, inst, path, theme, theme->btn_shade, "shade",
+        read_button_styles(db, inst, theme, theme->btn_shade, "shade",
                            &fbs, normal_mask, normal_mask);
     }
 
     /* iconify button */
     {
         guchar normal_mask[] = { 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f };
-        read_button_styles(db, inst, path, theme, theme->btn_iconify, "iconify",
+        read_button_styles(db, inst, theme, theme->btn_iconify, "iconify",
                            &fbs, normal_mask, NULL);
     }
 
     /* submenu bullet mask */
-    if (!read_mask(inst, path, "bullet.xbm", &theme->menu_bullet_mask))
+    if (!read_mask(db, inst, "bullet.xbm", &theme->menu_bullet_mask))
     {
         guchar data[] = { 0x01, 0x03, 0x07, 0x0f, 0x07, 0x03, 0x01 };
         theme->menu_bullet_mask = RrPixmapMaskNew(inst, 4, 7, (gchar*)data);
@@ -940,8 +942,12 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     theme->a_menu_bullet_selected->texture[0].data.mask.color =
         theme->menu_bullet_selected_color;
 
+    theme->file = g_build_filename(path, "themerc", NULL);
+    if (stat(theme->file, &st) == 0)
+        theme->file_mtime = st.st_mtime;
+
     g_free(path);
-    XrmDestroyDatabase(db);
+    RrThemeCacheClose(db);
 
     /* set the font heights */
     theme->win_font_height = RrFontHeight(theme->win_font_focused,
@@ -1007,6 +1013,7 @@ void RrThemeFree(RrTheme *theme)
 {
     if (theme) {
         g_free(theme->name);
+        g_free(theme->file);
 
         RrButtonFree(theme->btn_max);
         RrButtonFree(theme->btn_close);
@@ -1112,144 +1119,110 @@ void RrThemeFree(RrTheme *theme)
     }
 }
 
-static XrmDatabase loaddb(const gchar *name, gchar **path)
+gboolean RrThemeFileChanged(const RrTheme *theme)
+{
+    struct stat st;
+
+    return stat(theme->file, &st) != 0 || st.st_mtime != theme->file_mtime;
+}
+
+static RrThemeCache* loaddb(const gchar *name, gchar **path)
 {
-    GSList *it;
-    XrmDatabase db = NULL;
-    gchar *s;
+    RrThemeCache *db;
+    GSList *files = NULL;
 
+    /* the places to look for the theme, in order */
     if (name[0] == '/') {
-        s = g_build_filename(name, "openbox-3", "themerc", NULL);
-        if ((db = XrmGetFileDatabase(s)))
-            *path = g_path_get_dirname(s);
-        g_free(s);
+        files = g_slist_append(files, g_build_filename(name, "openbox-3",
+                                                       "themerc", NULL));
     } else {
         ObtPaths *p;
+        GSList *it;
 
         p = obt_paths_new();
 
         /* XXX backwards compatibility, remove me sometime later */
-        s = g_build_filename(g_get_home_dir(), ".themes", name,
-                             "openbox-3", "themerc", NULL);
-        if ((db = XrmGetFileDatabase(s)))
-            *path = g_path_get_dirname(s);
-        g_free(s);
-
-        for (it = obt_paths_data_dirs(p); !db && it; it = g_slist_next(it))
-        {
-            s = g_build_filename(it->data, "themes", name,
-                                 "openbox-3", "themerc", NULL);
-            if ((db = XrmGetFileDatabase(s)))
-                *path = g_path_get_dirname(s);
-            g_free(s);
-        }
+        files = g_slist_append(files, g_build_filename(g_get_home_dir(),
+                                                       ".themes", name,
+                                                       "openbox-3", "themerc",
+                                                       NULL));
 
-        obt_paths_unref(p);
-    }
+        for (it = obt_paths_data_dirs(p); it; it = g_slist_next(it))
+            files = g_slist_append(files, g_build_filename(it->data, "themes",
+                                                           name, "openbox-3",
+                                                           "themerc", NULL));
 
-    if (db == NULL) {
-        s = g_build_filename(name, "themerc", NULL);
-        if ((db = XrmGetFileDatabase(s)))
-            *path = g_path_get_dirname(s);
-        g_free(s);
+        obt_paths_unref(p);
     }
+    files = g_slist_append(files, g_build_filename(name, "themerc", NULL));
 
-    return db;
-}
-
-static gchar *create_class_name(const gchar *rname)
-{
-    gchar *rclass = g_strdup(rname);
-    gchar *p = rclass;
+    db = RrThemeCacheOpen(files, path);
 
-    while (TRUE) {
-        *p = toupper(*p);
-        p = strchr(p+1, '.');
-        if (p == NULL) break;
-        ++p;
-        if (*p == '\0') break;
+    while (files) {
+        g_free(files->data);
+        files = g_slist_delete_link(files, files);
     }
-    return rclass;
+    return db;
 }
 
-static gboolean read_int(XrmDatabase db, const gchar *rname, gint *value)
+static gboolean read_int(RrThemeCache *db, const gchar *rname, gint *value)
 {
     gboolean ret = FALSE;
-    gchar *rclass = create_class_name(rname);
-    gchar *rettype, *end;
-    XrmValue retvalue;
-
-    if (XrmGetResource(db, rname, rclass, &rettype, &retvalue) &&
-        retvalue.addr != NULL) {
-        *value = (gint)strtol(retvalue.addr, &end, 10);
-        if (end != retvalue.addr)
+    gchar *str, *end;
+
+    if ((str = RrThemeCacheGet(db, rname))) {
+        *value = (gint)strtol(str, &end, 10);
+        if (end != str)
             ret = TRUE;
     }
 
-    g_free(rclass);
     return ret;
 }
 
-static gboolean read_string(XrmDatabase db, const gchar *rname, gchar **value)
+static gboolean read_string(RrThemeCache *db, const gchar *rname,
+                            gchar **value)
 {
     gboolean ret = FALSE;
-    gchar *rclass = create_class_name(rname);
-    gchar *rettype;
-    XrmValue retvalue;
-
-    if (XrmGetResource(db, rname, rclass, &rettype, &retvalue) &&
-        retvalue.addr != NULL) {
-        g_strstrip(retvalue.addr);
-        *value = retvalue.addr;
+    gchar *str;
+
+    if ((str = RrThemeCacheGet(db, rname))) {
+        *value = str;
         ret = TRUE;
     }
 
-    g_free(rclass);
     return ret;
 }
 
-static gboolean read_color(XrmDatabase db, const RrInstance *inst,
+static gboolean read_color(RrThemeCache *db, const RrInstance *inst,
                            const gchar *rname, RrColor **value)
 {
     gboolean ret = FALSE;
-    gchar *rclass = create_class_name(rname);
-    gchar *rettype;
-    XrmValue retvalue;
+    gchar *str;
 
-    if (XrmGetResource(db, rname, rclass, &rettype, &retvalue) &&
-        retvalue.addr != NULL) {
+    if ((str = RrThemeCacheGet(db, rname))) {
         RrColor *c;
 
-        /* retvalue.addr is inside the xrdb database so we can't destroy it
-           but we can edit it in place, as g_strstrip does. */
-        g_strstrip(retvalue.addr);
-        c = RrColorParse(inst, retvalue.addr);
+        c = RrColorParse(inst, str);
         if (c != NULL) {
             *value = c;
             ret = TRUE;
         }
     }
 
-    g_free(rclass);
     return ret;
 }
 
-static gboolean read_mask(const RrInstance *inst, const gchar *path,
+static gboolean read_mask(RrThemeCache *db, const RrInstance *inst,
                           const gchar *maskname, RrPixmapMask **value)
 {
     gboolean ret = FALSE;
-    gchar *s;
-    gint hx, hy; /* ignored */
     guint w, h;
-    guchar *b;
+    const gchar *b;
 
-    s = g_build_filename(path, maskname, NULL);
-    if (XReadBitmapFileData(s, &w, &h, &b, &hx, &hy) == BitmapSuccess) {
+    if (RrThemeCacheMask(db, maskname, &w, &h, &b)) {
         ret = TRUE;
-        *value = RrPixmapMaskNew(inst, w, h, (gchar*)b);
-        XFree(b);
+        *value = RrPixmapMaskNew(inst, w, h, b);
     }
-    g_free(s);
 
     return ret;
 }
@@ -1315,16 +1288,14 @@ static void parse_appearance(gchar *tex, RrSurfaceColorType *grad,
         *interlaced = FALSE;
 }
 
-static gboolean read_appearance(XrmDatabase db, const RrInstance *inst,
+static gboolean read_appearance(RrThemeCache *db, const RrInstance *inst,
                                 const gchar *rname, RrAppearance *value,
                                 gboolean allow_trans)
 {
     gboolean ret = FALSE;
-    gchar *rclass = create_class_name(rname);
     gchar *cname, *ctoname, *bcname, *icname, *hname, *sname;
     gchar *csplitname, *ctosplitname;
-    gchar *rettype;
-    XrmValue retvalue;
+    gchar *str;
     gint i;
 
     cname = g_strconcat(rname, ".color", NULL);
@@ -1336,9 +1307,8 @@ static gboolean read_appearance(XrmDatabase db, const RrInstance *inst,
     csplitname = g_strconcat(rname, ".color.splitTo", NULL);
     ctosplitname = g_strconcat(rname, ".colorTo.splitTo", NULL);
 
-    if (XrmGetResource(db, rname, rclass, &rettype, &retvalue) &&
-        retvalue.addr != NULL) {
-        parse_appearance(retvalue.addr,
+    if ((str = RrThemeCacheGet(db, rname))) {
+        parse_appearance(str,
                          &value->surface.grad,
                          &value->surface.relief,
                          &value->surface.bevel,
@@ -1407,7 +1377,6 @@ static gboolean read_appearance(XrmDatabase db, const RrInstance *inst,
     g_free(bcname);
     g_free(ctoname);
     g_free(cname);
-    g_free(rclass);
     return ret;
 }
 
@@ -1461,8 +1430,7 @@ static RrPixel32* read_c_image(gint width, gint height, const guint8 *data)
     return im;
 }
 
-static void read_button_styles(XrmDatabase db, const RrInstance *inst, 
-                               gchar *path,
+static void read_button_styles(RrThemeCache *db, const RrInstance *inst, 
                                const RrTheme *theme, RrButton *btn, 
                                const gchar *btnname,
                                struct fallbacks *fbs,
@@ -1473,13 +1441,13 @@ static void read_button_styles(XrmDatabase db, const RrInstance *inst,
     gboolean userdef = TRUE;
 
     g_snprintf(name, 128, "%s.xbm", btnname);
-    if (!read_mask(inst, path, name, &btn->unpressed_mask) && normal_mask)
+    if (!read_mask(db, inst, name, &btn->unpressed_mask) && normal_mask)
     {
         btn->unpressed_mask = RrPixmapMaskNew(inst, 6, 6, (gchar*)normal_mask);
         userdef = FALSE;
     }
     g_snprintf(name, 128, "%s_toggled.xbm", btnname);
-    if (toggled_mask && !read_mask(inst, path, name, &btn->unpressed_toggled_mask))
+    if (toggled_mask && !read_mask(db, inst, name, &btn->unpressed_toggled_mask))
     {
         if (userdef)
             btn->unpressed_toggled_mask = RrPixmapMaskCopy(btn->unpressed_mask);
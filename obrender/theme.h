@@ -22,6 +22,8 @@
 
 #include "render.h"
 
+#include <time.h>
+
 G_BEGIN_DECLS
 
 typedef struct _RrTheme RrTheme;
@@ -174,8 +176,16 @@ struct _RrTheme {
     RrAppearance *osd_focused_button;
 
     gchar *name;
+    /*! The themerc file the theme was loaded from */
+    gchar *file;
+    /*! When the themerc file was last modified, when it was loaded */
+    time_t file_mtime;
 };
 
+/*! Returns TRUE if the theme's themerc file has been changed or removed since
+  the theme was loaded */
+gboolean RrThemeFileChanged(const RrTheme *theme);
+
 /*! The font values are all optional. If a NULL is used for any of them, then
   the default font will be used. */
 RrTheme* RrThemeNew(const RrInstance *inst, const gchar *theme,
@@ -0,0 +1,531 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   themecache.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "themecache.h"
+#include "obt/paths.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xresource.h>
+#include <ctype.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* change the version whenever the format of the cache files changes */
+#define THEME_CACHE_MAGIC   0x4f625463 /* "ObTc" */
+#define THEME_CACHE_VERSION 1
+
+typedef struct _ThemeDep ThemeDep;
+typedef struct _ThemeValue ThemeValue;
+typedef struct _ThemeMask ThemeMask;
+
+/*! A file which the theme was read from, or which was looked for */
+struct _ThemeDep {
+    const gchar *file;
+    /*! The file's modification time in nanoseconds, or -1 if it did not
+      exist */
+    gint64 mtime;
+    /*! The file's size in bytes, or -1 if it did not exist */
+    gint64 size;
+};
+
+struct _ThemeValue {
+    /*! The value as it was read, NULL if the resource is not set */
+    const gchar *orig;
+    /*! A copy of the value, which the theme's reader is allowed to modify */
+    gchar *value;
+};
+
+struct _ThemeMask {
+    guint w;
+    guint h;
+    /*! NULL if the mask could not be read */
+    const gchar *bits;
+};
+
+struct _RrThemeCache {
+    /*! The themerc file */
+    const gchar *file;
+    /*! The directory of the themerc file */
+    const gchar *dir;
+    /*! Where the cache is saved, NULL if it can't be */
+    gchar *cache_file;
+    /*! Identifies the list of themerc files the cache was made from */
+    gchar *key;
+
+    /*! The themerc's database, only loaded when something is read that is
+      not in the cache */
+    XrmDatabase xrdb;
+    /*! The cache file mapped into memory, the strings in it are used in
+      place */
+    gpointer map;
+    gsize map_size;
+
+    /*! Holds all the strings which are not in the cache file */
+    GStringChunk *strings;
+    /*! The files the cache depends on */
+    GArray *deps;
+    /*! Resource name -> ThemeValue */
+    GHashTable *values;
+    /*! Mask file name -> ThemeMask */
+    GHashTable *masks;
+
+    /*! If something was read which is not in the cache file yet */
+    gboolean dirty;
+};
+
+static guint32 key_hash(const gchar *k)
+{
+    /* FNV-1a */
+    guint32 h = 2166136261u;
+
+    for (; *k; ++k) {
+        h ^= (guchar)*k;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static gchar* create_class_name(const gchar *rname)
+{
+    gchar *rclass = g_strdup(rname);
+    gchar *p = rclass;
+
+    while (TRUE) {
+        *p = toupper(*p);
+        p = strchr(p+1, '.');
+        if (p == NULL) break;
+        ++p;
+        if (*p == '\0') break;
+    }
+    return rclass;
+}
+
+/*! Finds the file's modification time and size, so that any change to it
+  can be noticed.  The time is as precise as the system keeps it, so a file
+  which is saved twice in one second is still seen to change. */
+static void file_stat(const gchar *file, gint64 *mtime, gint64 *size)
+{
+    struct stat st;
+
+    if (stat(file, &st) == 0) {
+        *mtime = (gint64)st.st_mtime * G_GINT64_CONSTANT(1000000000);
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+        *mtime += st.st_mtim.tv_nsec;
+#endif
+        *size = st.st_size;
+    }
+    else
+        *mtime = *size = -1;
+}
+
+static void add_dep(RrThemeCache *self, const gchar *file,
+                    gint64 mtime, gint64 size)
+{
+    ThemeDep d;
+
+    d.file = file;
+    d.mtime = mtime;
+    d.size = size;
+    g_array_append_val(self->deps, d);
+}
+
+static void add_file_dep(RrThemeCache *self, const gchar *file)
+{
+    gint64 mtime, size;
+
+    file_stat(file, &mtime, &size);
+    add_dep(self, file, mtime, size);
+}
+
+/* reading a cache file */
+
+typedef struct {
+    const gchar *p;
+    const gchar *end;
+} Reader;
+
+static gboolean get32(Reader *r, guint32 *v)
+{
+    if (r->end - r->p < (gssize)sizeof(*v)) return FALSE;
+    memcpy(v, r->p, sizeof(*v));
+    r->p += sizeof(*v);
+    return TRUE;
+}
+
+static gboolean get64(Reader *r, gint64 *v)
+{
+    if (r->end - r->p < (gssize)sizeof(*v)) return FALSE;
+    memcpy(v, r->p, sizeof(*v));
+    r->p += sizeof(*v);
+    return TRUE;
+}
+
+static gboolean getc8(Reader *r, guint8 *v)
+{
+    if (r->p >= r->end) return FALSE;
+    *v = *r->p++;
+    return TRUE;
+}
+
+/*! Strings are stored with a trailing nul, so they are used in place */
+static gboolean getstr(Reader *r, const gchar **s, guint32 *len)
+{
+    guint32 l;
+
+    if (!get32(r, &l) || (gsize)(r->end - r->p) <= l || r->p[l] != '\0')
+        return FALSE;
+    *s = r->p;
+    if (len) *len = l;
+    r->p += l + 1;
+    return TRUE;
+}
+
+static gboolean load(RrThemeCache *self)
+{
+    Reader r;
+    struct stat st;
+    guint32 magic, version, n, i;
+    const gchar *key, *file;
+    gint fd;
+
+    if (!self->cache_file) return FALSE;
+
+    if ((fd = open(self->cache_file, O_RDONLY)) < 0)
+        return FALSE;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return FALSE;
+    }
+    self->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (self->map == MAP_FAILED) {
+        self->map = NULL;
+        return FALSE;
+    }
+    self->map_size = st.st_size;
+
+    r.p = self->map;
+    r.end = r.p + self->map_size;
+
+    if (!get32(&r, &magic) || magic != THEME_CACHE_MAGIC ||
+        !get32(&r, &version) || version != THEME_CACHE_VERSION ||
+        !getstr(&r, &key, NULL) || strcmp(key, self->key) ||
+        !getstr(&r, &file, NULL))
+        return FALSE;
+    self->file = file;
+
+    /* make sure none of the theme's files have changed */
+    if (!get32(&r, &n)) return FALSE;
+    for (i = 0; i < n; ++i) {
+        const gchar *dep;
+        gint64 mtime, size, now_mtime, now_size;
+
+        if (!getstr(&r, &dep, NULL) || !get64(&r, &mtime) ||
+            !get64(&r, &size))
+            return FALSE;
+        file_stat(dep, &now_mtime, &now_size);
+        if (now_mtime != mtime || now_size != size)
+            return FALSE;
+        add_dep(self, dep, mtime, size);
+    }
+
+    if (!get32(&r, &n)) return FALSE;
+    for (i = 0; i < n; ++i) {
+        const gchar *name, *value = NULL;
+        guint8 set;
+        ThemeValue *v;
+
+        if (!getstr(&r, &name, NULL) || !getc8(&r, &set) ||
+            (set && !getstr(&r, &value, NULL)))
+            return FALSE;
+
+        v = g_new0(ThemeValue, 1);
+        v->orig = value;
+        g_hash_table_insert(self->values, (gchar*)name, v);
+    }
+
+    if (!get32(&r, &n)) return FALSE;
+    for (i = 0; i < n; ++i) {
+        const gchar *name, *bits = NULL;
+        guint32 w = 0, h = 0, len;
+        guint8 set;
+        ThemeMask *m;
+
+        if (!getstr(&r, &name, NULL) || !getc8(&r, &set))
+            return FALSE;
+        if (set && (!get32(&r, &w) || !get32(&r, &h) ||
+                    !getstr(&r, &bits, &len) || len != (w + 7) / 8 * h))
+            return FALSE;
+
+        m = g_new0(ThemeMask, 1);
+        m->w = w;
+        m->h = h;
+        m->bits = bits;
+        g_hash_table_insert(self->masks, (gchar*)name, m);
+    }
+
+    return r.p == r.end;
+}
+
+/*! Forgets everything read from a cache file which was not valid */
+static void unload(RrThemeCache *self)
+{
+    g_hash_table_remove_all(self->values);
+    g_hash_table_remove_all(self->masks);
+    g_array_set_size(self->deps, 0);
+    self->file = NULL;
+    if (self->map) munmap(self->map, self->map_size);
+    self->map = NULL;
+}
+
+/* writing a cache file */
+
+static void put32(GString *s, guint32 v)
+{
+    g_string_append_len(s, (const gchar*)&v, sizeof(v));
+}
+
+static void put64(GString *s, gint64 v)
+{
+    g_string_append_len(s, (const gchar*)&v, sizeof(v));
+}
+
+static void putstr(GString *s, const gchar *str, guint32 len)
+{
+    put32(s, len);
+    g_string_append_len(s, str, len);
+    g_string_append_c(s, '\0');
+}
+
+static void put_value(gpointer key, gpointer val, gpointer data)
+{
+    const gchar *name = key;
+    ThemeValue *v = val;
+    GString *s = data;
+
+    putstr(s, name, strlen(name));
+    g_string_append_c(s, v->orig != NULL);
+    if (v->orig)
+        putstr(s, v->orig, strlen(v->orig));
+}
+
+static void put_mask(gpointer key, gpointer val, gpointer data)
+{
+    const gchar *name = key;
+    ThemeMask *m = val;
+    GString *s = data;
+
+    putstr(s, name, strlen(name));
+    g_string_append_c(s, m->bits != NULL);
+    if (m->bits) {
+        put32(s, m->w);
+        put32(s, m->h);
+        putstr(s, m->bits, (m->w + 7) / 8 * m->h);
+    }
+}
+
+static void save(RrThemeCache *self)
+{
+    GString *s;
+    gchar *dir;
+    guint i;
+
+    dir = g_path_get_dirname(self->cache_file);
+    if (!obt_paths_mkdir_path(dir, 0700)) {
+        g_free(dir);
+        return;
+    }
+    g_free(dir);
+
+    s = g_string_sized_new(16384);
+
+    put32(s, THEME_CACHE_MAGIC);
+    put32(s, THEME_CACHE_VERSION);
+    putstr(s, self->key, strlen(self->key));
+    putstr(s, self->file, strlen(self->file));
+
+    put32(s, self->deps->len);
+    for (i = 0; i < self->deps->len; ++i) {
+        ThemeDep *d = &g_array_index(self->deps, ThemeDep, i);
+        putstr(s, d->file, strlen(d->file));
+        put64(s, d->mtime);
+        put64(s, d->size);
+    }
+
+    put32(s, g_hash_table_size(self->values));
+    g_hash_table_foreach(self->values, put_value, s);
+    put32(s, g_hash_table_size(self->masks));
+    g_hash_table_foreach(self->masks, put_mask, s);
+
+    /* this replaces the file atomically, so a running Openbox which has it
+       mapped is not affected */
+    if (!g_file_set_contents(self->cache_file, s->str, s->len, NULL))
+        g_message("Unable to save the theme cache '%s'", self->cache_file);
+
+    g_string_free(s, TRUE);
+}
+
+RrThemeCache* RrThemeCacheOpen(GSList *files, gchar **path)
+{
+    RrThemeCache *self;
+    ObtPaths *p;
+    GString *key;
+    GSList *it;
+    gchar *name;
+
+    self = g_slice_new0(RrThemeCache);
+    self->strings = g_string_chunk_new(4096);
+    self->deps = g_array_new(FALSE, FALSE, sizeof(ThemeDep));
+    self->values = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                         NULL, g_free);
+    self->masks = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                        NULL, g_free);
+
+    /* a different list of places to look for the theme gets its own cache
+       file */
+    key = g_string_new(NULL);
+    for (it = files; it; it = g_slist_next(it)) {
+        g_string_append(key, it->data);
+        g_string_append_c(key, '\n');
+    }
+    self->key = g_string_free(key, FALSE);
+
+    p = obt_paths_new();
+    name = g_strdup_printf("%08x", key_hash(self->key));
+    self->cache_file = g_build_filename(obt_paths_cache_home(p), "openbox",
+                                        "themes", name, NULL);
+    g_free(name);
+    obt_paths_unref(p);
+
+    if (!load(self)) {
+        unload(self);
+
+        for (it = files; it && !self->xrdb; it = g_slist_next(it)) {
+            const gchar *f = g_string_chunk_insert(self->strings, it->data);
+
+            if ((self->xrdb = XrmGetFileDatabase(f)))
+                self->file = f;
+            add_file_dep(self, f);
+        }
+        self->dirty = TRUE;
+
+        if (!self->xrdb) {
+            self->dirty = FALSE;
+            RrThemeCacheClose(self);
+            return NULL;
+        }
+    }
+
+    name = g_path_get_dirname(self->file);
+    self->dir = g_string_chunk_insert(self->strings, name);
+    g_free(name);
+
+    *path = g_strdup(self->dir);
+    return self;
+}
+
+void RrThemeCacheClose(RrThemeCache *self)
+{
+    if (self) {
+        if (self->dirty && self->cache_file)
+            save(self);
+
+        if (self->xrdb) XrmDestroyDatabase(self->xrdb);
+        g_hash_table_destroy(self->values);
+        g_hash_table_destroy(self->masks);
+        g_array_free(self->deps, TRUE);
+        if (self->map) munmap(self->map, self->map_size);
+        g_string_chunk_free(self->strings);
+        g_free(self->cache_file);
+        g_free(self->key);
+        g_slice_free(RrThemeCache, self);
+    }
+}
+
+gchar* RrThemeCacheGet(RrThemeCache *self, const gchar *rname)
+{
+    ThemeValue *v;
+
+    if (!(v = g_hash_table_lookup(self->values, rname))) {
+        gchar *rclass, *rettype;
+        XrmValue retvalue;
+
+        /* not in the cache, so read it from the themerc */
+        if (!self->xrdb)
+            self->xrdb = XrmGetFileDatabase(self->file);
+
+        v = g_new0(ThemeValue, 1);
+        rclass = create_class_name(rname);
+        if (self->xrdb &&
+            XrmGetResource(self->xrdb, rname, rclass, &rettype, &retvalue) &&
+            retvalue.addr != NULL)
+        {
+            v->orig = g_string_chunk_insert(self->strings,
+                                            g_strstrip(retvalue.addr));
+        }
+        g_free(rclass);
+
+        g_hash_table_insert(self->values,
+                            g_string_chunk_insert(self->strings, rname), v);
+        self->dirty = TRUE;
+    }
+
+    if (v->orig && !v->value)
+        v->value = g_string_chunk_insert(self->strings, v->orig);
+    return v->value;
+}
+
+gboolean RrThemeCacheMask(RrThemeCache *self, const gchar *maskname,
+                          guint *w, guint *h, const gchar **bits)
+{
+    ThemeMask *m;
+
+    if (!(m = g_hash_table_lookup(self->masks, maskname))) {
+        gchar *s;
+        gint hx, hy; /* ignored */
+        guchar *b;
+
+        /* not in the cache, so read it from its file */
+        m = g_new0(ThemeMask, 1);
+        s = g_build_filename(self->dir, maskname, NULL);
+        if (XReadBitmapFileData(s, &m->w, &m->h, &b, &hx, &hy) ==
+            BitmapSuccess)
+        {
+            m->bits = g_string_chunk_insert_len(self->strings, (gchar*)b,
+                                                (m->w + 7) / 8 * m->h);
+            XFree(b);
+        }
+        add_file_dep(self, g_string_chunk_insert(self->strings, s));
+        g_free(s);
+
+        g_hash_table_insert(self->masks,
+                            g_string_chunk_insert(self->strings, maskname),
+                            m);
+        self->dirty = TRUE;
+    }
+
+    if (!m->bits) return FALSE;
+    *w = m->w;
+    *h = m->h;
+    *bits = m->bits;
+    return TRUE;
+}
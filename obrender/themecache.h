@@ -0,0 +1,57 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   themecache.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __themecache_h
+#define __themecache_h
+
+#include <glib.h>
+
+typedef struct _RrThemeCache RrThemeCache;
+
+/*! Opens the first of the themerc files in @files which exists.
+
+  Every resource and button mask read from a theme is saved in a binary
+  cache file, under the user's cache directory, when the theme is closed.
+  The next time the same theme is opened, the cache file is mapped into
+  memory and used instead of parsing the themerc and the masks again, as
+  long as none of those files have been changed, and none of the files
+  before it in @files has appeared since.
+
+  @param files The paths of the themerc files to try, in order
+  @param path Returns the directory of the themerc which was opened
+  @return NULL if none of the @files could be opened
+*/
+RrThemeCache* RrThemeCacheOpen(GSList *files, gchar **path);
+/*! Closes the theme, and writes its cache file if anything was read from it
+  that was not in the cache yet. */
+void RrThemeCacheClose(RrThemeCache *self);
+
+/*! Returns the value of the resource @rname with the whitespace stripped
+  from it, or NULL if the theme does not set it.  The value belongs to the
+  theme, and can be modified until the theme is closed, but each read of the
+  same resource returns the same string. */
+gchar* RrThemeCacheGet(RrThemeCache *self, const gchar *rname);
+
+/*! Reads the bitmap @maskname from the theme's directory.
+  @param bits Returns the bitmap's data, which belongs to the theme
+  @return FALSE if the bitmap does not exist or could not be read
+*/
+gboolean RrThemeCacheMask(RrThemeCache *self, const gchar *maskname,
+                          guint *w, guint *h, const gchar **bits);
+
+#endif
@@ -24,6 +24,13 @@
 #ifdef HAVE_STRING_H
 #  include <string.h>
 #endif
+#ifdef HAVE_STDLIB_H
+#  include <stdlib.h>
+#endif
+#ifdef USE_XCB
+#  include <X11/Xlib-xcb.h>
+#  include <xcb/xcb.h>
+#endif
 
 Atom prop_atoms[OBT_PROP_NUM_ATOMS];
 gboolean prop_started = FALSE;
@@ -209,6 +216,200 @@ Atom obt_prop_atom(ObtPropAtom a)
     return prop_atoms[a];
 }
 
+#ifdef USE_XCB
+
+typedef struct _ObtPropPrefetch ObtPropPrefetch;
+
+struct _ObtPropPrefetch {
+    xcb_get_property_cookie_t cookie;
+    /*! NULL until the reply has been waited for, and also if the request
+      failed */
+    xcb_get_property_reply_t *reply;
+    gboolean waited;
+};
+
+/*! The window whose properties are being prefetched, or None */
+static Window prefetch_win = None;
+/*! Maps Atoms to ObtPropPrefetch structs for prefetch_win */
+static GHashTable *prefetch = NULL;
+
+static void prefetch_free(ObtPropPrefetch *p)
+{
+    if (p->waited)
+        free(p->reply);
+    else
+        xcb_discard_reply(XGetXCBConnection(obt_display),
+                          p->cookie.sequence);
+    g_slice_free(ObtPropPrefetch, p);
+}
+
+void obt_prop_prefetch_begin(Window win, const Atom *props, guint n)
+{
+    xcb_connection_t *c;
+    guint i;
+
+    obt_prop_prefetch_end(prefetch_win);
+
+    if (!prefetch)
+        prefetch = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                         (GDestroyNotify)prefetch_free);
+
+    /* anything Xlib has buffered has to go out before our requests, so that
+       the replies reflect it */
+    XFlush(obt_display);
+
+    c = XGetXCBConnection(obt_display);
+    prefetch_win = win;
+    for (i = 0; i < n; ++i) {
+        ObtPropPrefetch *p;
+
+        if (g_hash_table_lookup(prefetch, GUINT_TO_POINTER(props[i])))
+            continue;
+
+        p = g_slice_new(ObtPropPrefetch);
+        /* ask for the whole property of any type, the requested type and
+           length are applied when the reply is used */
+        p->cookie = xcb_get_property_unchecked(c, FALSE, win, props[i],
+                                               XCB_GET_PROPERTY_TYPE_ANY,
+                                               0, G_MAXUINT32 / 4);
+        p->reply = NULL;
+        p->waited = FALSE;
+        g_hash_table_insert(prefetch, GUINT_TO_POINTER(props[i]), p);
+    }
+    xcb_flush(c);
+}
+
+void obt_prop_prefetch_end(Window win)
+{
+    if (win == None || win != prefetch_win) return;
+
+    g_hash_table_remove_all(prefetch);
+    prefetch_win = None;
+}
+
+/*! Forget a prefetched property because we changed it ourselves */
+static void prefetch_forget(Window win, Atom prop)
+{
+    if (win != None && win == prefetch_win)
+        g_hash_table_remove(prefetch, GUINT_TO_POINTER(prop));
+}
+
+/*! Fills in the XGetWindowProperty return values from a prefetched reply.
+  @return FALSE if the property was not prefetched.
+*/
+static gboolean prefetch_get(Window win, Atom prop, glong offset, glong length,
+                             Atom type, Atom *ret_type, gint *ret_size,
+                             gulong *ret_items, gulong *bytes_left,
+                             guchar **xdata, gint *res)
+{
+    ObtPropPrefetch *p;
+    xcb_get_property_reply_t *r;
+    gulong bytes, unit, skip;
+
+    if (win == None || win != prefetch_win ||
+        !(p = g_hash_table_lookup(prefetch, GUINT_TO_POINTER(prop))))
+        return FALSE;
+
+    if (!p->waited) {
+        xcb_generic_error_t *err = NULL;
+
+        p->reply = xcb_get_property_reply(XGetXCBConnection(obt_display),
+                                          p->cookie, &err);
+        p->waited = TRUE;
+        free(err);
+    }
+
+    if (!(r = p->reply)) {
+        /* the window is gone, XGetWindowProperty would have failed too */
+        *res = BadWindow;
+        return TRUE;
+    }
+
+    *res = Success;
+    *ret_type = r->type;
+    *ret_size = r->format;
+    *xdata = NULL;
+    *ret_items = 0;
+    bytes = xcb_get_property_value_length(r);
+    *bytes_left = bytes;
+
+    if (r->type == None || (type != AnyPropertyType && type != r->type))
+        return TRUE; /* no data is returned, just like XGetWindowProperty */
+
+    skip = (gulong)offset * 4;
+    if (skip > bytes) {
+        *res = BadValue;
+        return TRUE;
+    }
+
+    unit = r->format / 8;
+    bytes = MIN(bytes - skip, (gulong)length * 4);
+    *ret_items = bytes / unit;
+    *bytes_left -= skip + *ret_items * unit;
+
+    if (*ret_items) {
+        const guchar *v = (const guchar*)xcb_get_property_value(r) + skip;
+        gulong i;
+
+        /* give the data back the way Xlib does, with 32-bit values in longs
+           and a trailing nul, so it can be passed to XFree() */
+        switch (r->format) {
+        case 8:
+            *xdata = malloc(*ret_items + 1);
+            memcpy(*xdata, v, *ret_items);
+            (*xdata)[*ret_items] = '\0';
+            break;
+        case 16:
+            *xdata = malloc(*ret_items * sizeof(gushort));
+            for (i = 0; i < *ret_items; ++i)
+                ((gushort*)*xdata)[i] = ((const guint16*)v)[i];
+            break;
+        case 32:
+            *xdata = malloc(*ret_items * sizeof(gulong));
+            for (i = 0; i < *ret_items; ++i)
+                ((gulong*)*xdata)[i] = ((const guint32*)v)[i];
+            break;
+        default:
+            *ret_items = 0;
+            *res = BadImplementation;
+        }
+    }
+    return TRUE;
+}
+
+#else
+
+void obt_prop_prefetch_begin(Window win, const Atom *props, guint n)
+{
+}
+
+void obt_prop_prefetch_end(Window win)
+{
+}
+
+#define prefetch_forget(win, prop) ((void)0)
+#define prefetch_get(win, prop, offset, length, type, ret_type, ret_size, \
+                     ret_items, bytes_left, xdata, res) FALSE
+
+#endif
+
+/*! XGetWindowProperty which uses the reply to an outstanding prefetch when
+  there is one */
+static gint get_property(Window win, Atom prop, glong offset, glong length,
+                         Atom type, Atom *ret_type, gint *ret_size,
+                         gulong *ret_items, gulong *bytes_left,
+                         guchar **xdata)
+{
+    gint res;
+
+    if (!prefetch_get(win, prop, offset, length, type, ret_type, ret_size,
+                      ret_items, bytes_left, xdata, &res))
+        res = XGetWindowProperty(obt_display, win, prop, offset, length,
+                                 FALSE, type, ret_type, ret_size,
+                                 ret_items, bytes_left, xdata);
+    return res;
+}
+
 static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
                              guchar *data, gulong num)
 {
@@ -220,9 +421,8 @@ static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
     gulong ret_items, bytes_left;
     glong num32 = 32 / size * num; /* num in 32-bit elements */
 
-    res = XGetWindowProperty(obt_display, win, prop, 0l, num32,
-                             FALSE, type, &ret_type, &ret_size,
-                             &ret_items, &bytes_left, &xdata);
+    res = get_property(win, prop, 0l, num32, type, &ret_type, &ret_size,
+                       &ret_items, &bytes_left, &xdata);
     if (res == Success && ret_items && xdata) {
         if (ret_size == size && ret_items >= num) {
             guint i;
@@ -257,9 +457,8 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
     gint ret_size;
     gulong ret_items, bytes_left;
 
-    res = XGetWindowProperty(obt_display, win, prop, 0l, G_MAXLONG,
-                             FALSE, type, &ret_type, &ret_size,
-                             &ret_items, &bytes_left, &xdata);
+    res = get_property(win, prop, 0l, G_MAXLONG, type, &ret_type, &ret_size,
+                       &ret_items, &bytes_left, &xdata);
     if (res == Success) {
         if (ret_size == size && ret_items > 0) {
             guint i;
@@ -299,7 +498,26 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
 static gboolean get_text_property(Window win, Atom prop,
                                   XTextProperty *tprop, ObtPropTextType type)
 {
-    if (!(XGetTextProperty(obt_display, win, tprop, prop) && tprop->nitems))
+    Atom ret_type;
+    gint ret_size;
+    gulong ret_items, bytes_left;
+    guchar *xdata = NULL;
+
+    /* this is what XGetTextProperty does */
+    tprop->value = NULL;
+    if (get_property(win, prop, 0l, 1000000l, AnyPropertyType, &ret_type,
+                     &ret_size, &ret_items, &bytes_left, &xdata) != Success ||
+        ret_type == None)
+    {
+        if (xdata) XFree(xdata);
+        return FALSE;
+    }
+    tprop->value = xdata;
+    tprop->encoding = ret_type;
+    tprop->format = ret_size;
+    tprop->nitems = ret_items;
+
+    if (!tprop->nitems)
         return FALSE;
     if (!type)
         return TRUE; /* no type checking */
@@ -481,6 +699,29 @@ gboolean obt_prop_get_array32(Window win, Atom prop, Atom type, guint32 **ret,
     return get_all(win, prop, type, 32, (guchar**)ret, nret);
 }
 
+gboolean obt_prop_get_array32_part(Window win, Atom prop, Atom type,
+                                   gulong offset, gulong length,
+                                   gulong **ret, guint *nret, gulong *left)
+{
+    gint res;
+    guchar *xdata = NULL;
+    Atom ret_type;
+    gint ret_size;
+    gulong ret_items, bytes_left;
+
+    res = get_property(win, prop, offset, length, type, &ret_type, &ret_size,
+                       &ret_items, &bytes_left, &xdata);
+    if (res == Success && ret_size == 32 && ret_items > 0 && xdata) {
+        /* hand back Xlib's own buffer rather than copying it */
+        *ret = (gulong*)xdata;
+        *nret = ret_items;
+        *left = bytes_left / 4;
+        return TRUE;
+    }
+    if (xdata) XFree(xdata);
+    return FALSE;
+}
+
 gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
                            gchar **ret_string)
 {
@@ -522,6 +763,7 @@ gboolean obt_prop_get_array_text(Window win, Atom prop,
 
 void obt_prop_set32(Window win, Atom prop, Atom type, gulong val)
 {
+    prefetch_forget(win, prop);
     XChangeProperty(obt_display, win, prop, type, 32, PropModeReplace,
                     (guchar*)&val, 1);
 }
@@ -529,12 +771,14 @@ void obt_prop_set32(Window win, Atom prop, Atom type, gulong val)
 void obt_prop_set_array32(Window win, Atom prop, Atom type, gulong *val,
                       guint num)
 {
+    prefetch_forget(win, prop);
     XChangeProperty(obt_display, win, prop, type, 32, PropModeReplace,
                     (guchar*)val, num);
 }
 
 void obt_prop_set_text(Window win, Atom prop, const gchar *val)
 {
+    prefetch_forget(win, prop);
     XChangeProperty(obt_display, win, prop, OBT_PROP_ATOM(UTF8_STRING), 8,
                     PropModeReplace, (const guchar*)val, strlen(val));
 }
@@ -544,6 +788,7 @@ void obt_prop_set_array_text(Window win, Atom prop, const gchar *const *strs)
     GString *str;
     gchar const *const *s;
 
+    prefetch_forget(win, prop);
     str = g_string_sized_new(0);
     for (s = strs; *s; ++s) {
         str = g_string_append(str, *s);
@@ -556,6 +801,7 @@ void obt_prop_set_array_text(Window win, Atom prop, const gchar *const *strs)
 
 void obt_prop_erase(Window win, Atom prop)
 {
+    prefetch_forget(win, prop);
     XDeleteProperty(obt_display, win, prop);
 }
 
@@ -246,9 +246,29 @@ typedef enum {
     OBT_PROP_TEXT_UTF8_STRING = 5,
 } ObtPropTextType;
 
+/*! Send the requests for a number of properties on a window all at once,
+  instead of waiting for each reply before asking for the next one.  The
+  obt_prop_get functions will use the replies for @win until
+  obt_prop_prefetch_end() is called.  Only one window is prefetched at a time,
+  and this does nothing when built without XCB.
+*/
+void obt_prop_prefetch_begin(Window win, const Atom *props, guint n);
+/*! Throw away the prefetched properties for @win which were not used */
+void obt_prop_prefetch_end(Window win);
+
 gboolean obt_prop_get32(Window win, Atom prop, Atom type, guint32 *ret);
 gboolean obt_prop_get_array32(Window win, Atom prop, Atom type, guint32 **ret,
                               guint *nret);
+/*! Reads part of a 32-bit array property, without copying it out of the
+  reply.  @ret holds each value in a long, as Xlib gives it, and must be freed
+  with XFree().
+  @param offset The index of the first value to read
+  @param length The most values to read
+  @param left Set to the number of values in the property after those read
+*/
+gboolean obt_prop_get_array32_part(Window win, Atom prop, Atom type,
+                                   gulong offset, gulong length,
+                                   gulong **ret, guint *nret, gulong *left);
 
 gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
                            gchar **ret);
@@ -278,6 +298,9 @@ void obt_prop_message_to(Window to, Window about, Atom messagetype,
 #define OBT_PROP_GETA32(win, prop, type, ret, nret) \
     (obt_prop_get_array32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), \
                           ret, nret))
+#define OBT_PROP_GETA32_PART(win, prop, type, offset, length, ret, nret, left)\
+    (obt_prop_get_array32_part(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), \
+                               offset, length, ret, nret, left))
 #define OBT_PROP_GETS(win, prop, ret) \
     (obt_prop_get_text(win, OBT_PROP_ATOM(prop), 0, ret))
 #define OBT_PROP_GETSS(win, prop, ret) \
@@ -9,11 +9,15 @@ const gchar* g_active_test_name = NULL;
 
 /* Add all test suites here. Keep them sorted. */
 extern void run_bsearch_unittest();
+extern void run_monitor_map_unittest();
+extern void run_place_overlap_unittest();
 
 gint main(gint argc, gchar **argv)
 {
     /* Add all test suites here. Keep them sorted. */
     run_bsearch_unittest();
+    run_monitor_map_unittest();
+    run_place_overlap_unittest();
 
     return g_test_failures == 0 ? 0 : 1;
 }
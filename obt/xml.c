@@ -105,6 +105,12 @@ xmlNodePtr obt_xml_root(ObtXmlInst *i)
     return i->root;
 }
 
+const gchar* obt_xml_path(ObtXmlInst *i)
+{
+    g_assert(i->doc); /* a doc is open? */
+    return i->path;
+}
+
 void obt_xml_register(ObtXmlInst *i, const gchar *tag,
                       ObtXmlCallback func, gpointer data)
 {
@@ -304,6 +310,73 @@ gboolean obt_xml_load_mem(ObtXmlInst *i,
     return r;
 }
 
+struct _ObtXmlPush {
+    xmlParserCtxtPtr ctxt;
+};
+
+ObtXmlPush* obt_xml_push_new(void)
+{
+    ObtXmlPush *p = g_slice_new(ObtXmlPush);
+    p->ctxt = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, NULL);
+    return p;
+}
+
+void obt_xml_push_free(ObtXmlPush *p)
+{
+    if (p) {
+        if (p->ctxt->myDoc)
+            xmlFreeDoc(p->ctxt->myDoc);
+        xmlFreeParserCtxt(p->ctxt);
+        g_slice_free(ObtXmlPush, p);
+    }
+}
+
+gboolean obt_xml_push_chunk(ObtXmlPush *p, gconstpointer data, guint len)
+{
+    return xmlParseChunk(p->ctxt, data, len, 0) == 0;
+}
+
+gboolean obt_xml_load_push(ObtXmlInst *i, ObtXmlPush *p,
+                           const gchar *root_node)
+{
+    gboolean r = FALSE;
+
+    g_assert(i->doc == NULL); /* another doc isn't open already? */
+
+    xmlResetLastError();
+
+    /* terminate the document */
+    xmlParseChunk(p->ctxt, NULL, 0, 1);
+
+    if (p->ctxt->wellFormed)
+        i->doc = p->ctxt->myDoc;
+    else if (p->ctxt->myDoc)
+        xmlFreeDoc(p->ctxt->myDoc);
+    p->ctxt->myDoc = NULL;
+
+    if (i->doc) {
+        i->root = xmlDocGetRootElement(i->doc);
+        if (!i->root) {
+            xmlFreeDoc(i->doc);
+            i->doc = NULL;
+            g_message("Given data is an empty document");
+        }
+        else if (xmlStrcmp(i->root->name, (const xmlChar*)root_node)) {
+            xmlFreeDoc(i->doc);
+            i->doc = NULL;
+            i->root = NULL;
+            g_message("XML Document in given data is of wrong "
+                      "type. Root node is not '%s'\n", root_node);
+        }
+        else
+            r = TRUE; /* ok ! */
+    }
+
+    obt_xml_save_last_error(i);
+
+    return r;
+}
+
 static void obt_xml_save_last_error(ObtXmlInst* inst)
 {
     xmlErrorPtr error = xmlGetLastError();
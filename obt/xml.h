@@ -25,6 +25,7 @@
 G_BEGIN_DECLS
 
 typedef struct _ObtXmlInst ObtXmlInst;
+typedef struct _ObtXmlPush ObtXmlPush;
 
 typedef void (*ObtXmlCallback)(xmlNodePtr node, gpointer data);
 
@@ -51,6 +52,18 @@ gboolean obt_xml_load_theme_file(ObtXmlInst *inst,
 gboolean obt_xml_load_mem(ObtXmlInst *inst,
                           gpointer data, guint len, const gchar *root_node);
 
+/*! Create a parser which is given a document a piece at a time, as it
+  becomes available */
+ObtXmlPush* obt_xml_push_new(void);
+void obt_xml_push_free(ObtXmlPush *p);
+/*! Parse the next piece of the document.  Returns FALSE if the data is not
+  well formed. */
+gboolean obt_xml_push_chunk(ObtXmlPush *p, gconstpointer data, guint len);
+/*! Finish the document given to the parser and load it into the instance,
+  the same as obt_xml_load_mem() would.  The parser must still be freed. */
+gboolean obt_xml_load_push(ObtXmlInst *inst, ObtXmlPush *p,
+                           const gchar *root_node);
+
 /* Returns true if an error is present. */
 gboolean obt_xml_last_error(ObtXmlInst *inst);
 gchar* obt_xml_last_error_file(ObtXmlInst *inst);
@@ -63,6 +76,9 @@ gboolean obt_xml_save_file(ObtXmlInst *inst,
 
 xmlDocPtr obt_xml_doc(ObtXmlInst *inst);
 xmlNodePtr obt_xml_root(ObtXmlInst *inst);
+/*! The path of the file that the open document was loaded from, or NULL if
+  it was not loaded from a file */
+const gchar* obt_xml_path(ObtXmlInst *inst);
 
 void obt_xml_close(ObtXmlInst *inst);
 
@@ -100,7 +100,7 @@ static gboolean run_func(ObActionsData *data, gpointer options)
     Options *o = options;
 
     if (data->client) {
-        Rect *area, *carea;
+        const Rect *area, *carea;
         ObClient *c;
         guint mon, cmon;
         gint x, y, lw, lh, w, h;
@@ -194,9 +194,6 @@ static gboolean run_func(ObActionsData *data, gpointer options)
         actions_client_move(data, TRUE);
         client_configure(c, x, y, w, h, TRUE, TRUE, FALSE);
         actions_client_move(data, FALSE);
-
-        g_slice_free(Rect, area);
-        g_slice_free(Rect, carea);
     }
 
     return FALSE;
@@ -39,6 +39,7 @@
 #include "menuframe.h"
 #include "keyboard.h"
 #include "mouse.h"
+#include "spatial.h"
 #include "obrender/render.h"
 #include "gettext.h"
 #include "obt/display.h"
@@ -69,12 +70,54 @@ typedef struct
     gpointer data;
 } ClientCallback;
 
+/*! The X requests for a client which are held back until the current
+  client_configure transaction commits */
+typedef struct
+{
+    ObClient *client;
+    /*! Move and resize the frame's window to the frame's area */
+    gboolean frame;
+    /*! Move and resize the client's window inside the frame */
+    gboolean resize;
+    /*! Send the client a synthetic ConfigureNotify */
+    gboolean notify;
+    /*! The size of the client's window on the server */
+    gint oldw, oldh;
+} ClientConfigure;
+
 GList          *client_list             = NULL;
 
 static GSList  *client_destroy_notifies = NULL;
 static RrImage *client_default_icon     = NULL;
+/*! How many client_configure transactions are open */
+static guint       configure_depth   = 0;
+/*! ClientConfigure structs in the order their clients were first changed */
+static GSList     *configure_pending = NULL;
+/*! Maps an ObClient* to its ClientConfigure in configure_pending */
+static GHashTable *configure_map     = NULL;
+/*! If enter events from the committed requests should be ignored */
+static gboolean    configure_ignore_enters = FALSE;
+/*! Changes every time a client's parents or transients change */
+static guint     transient_serial = 1;
+/*! The last mark given to a client_search_transient() search */
+static guint     transient_mark   = 0;
+/*! The client whose transients were last marked, the transient_serial when
+  they were and the mark they were given */
+static ObClient *marked_transients_of = NULL;
+static guint     marked_transients_serial = 0;
+static guint     marked_transients_mark = 0;
+/*! The client whose parents were last marked, the transient_serial when
+  they were and the mark they were given */
+static ObClient *marked_parents_of = NULL;
+static guint     marked_parents_serial = 0;
+static guint     marked_parents_mark = 0;
+/*! The client searched for by the last client_search_transient() */
+static ObClient *last_transient_search = NULL;
+/*! The current client_calc_layer() pass */
+static guint     layer_pass = 0;
 
 static void client_get_all(ObClient *self, gboolean real);
+static void client_get_all_props(ObClient *self, gboolean real);
 static void client_get_startup_id(ObClient *self);
 static void client_get_session_ids(ObClient *self);
 static void client_save_app_rule_values(ObClient *self);
@@ -102,9 +145,9 @@ static void client_update_transient_tree(ObClient *self,
                                          ObClient *newparent);
 static void client_present(ObClient *self, gboolean here, gboolean raise,
                            gboolean unshade);
-static GSList *client_search_all_top_parents_internal(ObClient *self,
-                                                      gboolean bylayer,
-                                                      ObStackingLayer layer);
+static const GSList *client_search_top_parents_internal(ObClient *self,
+                                                       gboolean bylayer,
+                                                       ObStackingLayer layer);
 static void client_call_notifies(ObClient *self, GSList *list);
 static void client_ping_event(ObClient *self, gboolean dead);
 static void client_prompt_kill(ObClient *self);
@@ -114,6 +157,8 @@ static gboolean client_can_steal_focus(ObClient *self,
                                        Time steal_time, Time launch_time);
 static void client_setup_default_decor_and_functions(ObClient *self);
 static void client_setup_decor_undecorated(ObClient *self);
+static ClientConfigure* client_configure_get(ObClient *self);
+static void client_configure_forget(ObClient *self);
 
 void client_startup(gboolean reconfig)
 {
@@ -123,6 +168,8 @@ void client_startup(gboolean reconfig)
 
     if (reconfig) return;
 
+    configure_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+
     client_set_list();
 }
 
@@ -132,6 +179,10 @@ void client_shutdown(gboolean reconfig)
     client_default_icon = NULL;
 
     if (reconfig) return;
+
+    g_assert(configure_depth == 0);
+    g_hash_table_destroy(configure_map);
+    configure_map = NULL;
 }
 
 static void client_call_notifies(ObClient *self, GSList *list)
@@ -237,6 +288,7 @@ void client_manage(Window window, ObPrompt *prompt)
     self->window = window;
     self->prompt = prompt;
     self->managed = TRUE;
+    self->self_list.data = self;
 
     /* non-zero defaults */
     self->wmstate = WithdrawnState; /* make sure it gets updated first time */
@@ -380,7 +432,7 @@ void client_manage(Window window, ObPrompt *prompt)
             /* oldschool fullscreen windows are allowed */
             !client_is_oldfullscreen(self, &place))
         {
-            Rect *r;
+            const Rect *r;
 
             r = screen_area(self->desktop, SCREEN_AREA_ALL_MONITORS, NULL);
             if (r->x || r->y) {
@@ -388,7 +440,6 @@ void client_manage(Window window, ObPrompt *prompt)
                 place.y = r->y;
                 ob_debug("Moving buggy app from (0,0) to (%d,%d)", r->x, r->y);
             }
-            g_slice_free(Rect, r);
         }
 
         /* make sure the window is visible. */
@@ -442,7 +493,8 @@ void client_manage(Window window, ObPrompt *prompt)
              fit the screen but it is not USSize'd or USPosition'd) */
           !client_is_oldfullscreen(self, &place))))
     {
-        Rect *a = screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR, &place);
+        const Rect *a = screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR,
+                                    &place);
 
         /* get the size of the frame */
         place.width += self->frame->size.left + self->frame->size.right;
@@ -457,8 +509,6 @@ void client_manage(Window window, ObPrompt *prompt)
         /* get the size of the client back */
         place.width -= self->frame->size.left + self->frame->size.right;
         place.height -= self->frame->size.top + self->frame->size.bottom;
-
-        g_slice_free(Rect, a);
     }
 
     ob_debug("placing window 0x%x at %d, %d with size %d x %d. "
@@ -626,7 +676,9 @@ void client_unmanage(ObClient *self)
     self->kill_prompt = NULL;
 
     client_list = g_list_remove(client_list, self);
-    stacking_remove(self);
+    stacking_remove(CLIENT_AS_WINDOW(self));
+    spatial_remove(self);
+    client_configure_forget(self);
     window_remove(self->window);
 
     /* once the client is out of the list, update the struts to remove its
@@ -636,6 +688,9 @@ void client_unmanage(ObClient *self)
 
     client_call_notifies(self, client_destroy_notifies);
 
+    /* the client can't be found in the transient tree anymore */
+    ++transient_serial;
+
     /* tell our parent(s) that we're gone */
     for (it = self->parents; it; it = g_slist_next(it))
         ((ObClient*)it->data)->transients =
@@ -645,6 +700,7 @@ void client_unmanage(ObClient *self)
     for (it = self->transients; it; it = g_slist_next(it)) {
         ((ObClient*)it->data)->parents =
             g_slist_remove(((ObClient*)it->data)->parents, self);
+        ++transient_serial;
         /* we could be keeping our children in a higher layer */
         client_calc_layer(it->data);
     }
@@ -908,11 +964,15 @@ static gboolean client_can_steal_focus(ObClient *self,
 static ObAppSettings *client_get_settings_state(ObClient *self)
 {
     ObAppSettings *settings;
-    GSList *it;
+    GSList *candidates, *it;
 
     settings = config_create_app_settings();
 
-    for (it = config_per_app_settings; it; it = g_slist_next(it)) {
+    /* only the rules which can match the window's class, name or role are
+       checked */
+    candidates = config_per_app_settings_candidates(self->class, self->name,
+                                                    self->role);
+    for (it = candidates; it; it = g_slist_next(it)) {
         ObAppSettings *app = it->data;
         gboolean match = TRUE;
 
@@ -957,6 +1017,7 @@ static ObAppSettings *client_get_settings_state(ObClient *self)
             config_app_settings_copy_non_defaults(app, settings);
         }
     }
+    g_slist_free(candidates);
 
     if (settings->shade != -1)
         self->shaded = !!settings->shade;
@@ -1147,7 +1208,7 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
     */
     found_mon = FALSE;
     for (i = 0; i < screen_num_monitors; ++i) {
-        Rect *a;
+        const Rect *a;
 
         if (!screen_physical_area_monitor_contains(i, &desired)) {
             if (i < screen_num_monitors - 1 || found_mon)
@@ -1192,8 +1253,6 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
         if (rudet && !self->strut.top && *y < a->y) *y = a->y;
         if (rudeb && !self->strut.bottom && *y + fh > a->y + a->height)
             *y = a->y + MAX(0, a->height - fh);
-
-        g_slice_free(Rect, a);
     }
 
     /* get where the client should be */
@@ -1203,6 +1262,41 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
 }
 
 static void client_get_all(ObClient *self, gboolean real)
+{
+    /* the properties read while managing a window, ask for them all at once
+       rather than one round trip at a time */
+    const Atom props[] = {
+        OBT_PROP_ATOM(MOTIF_WM_HINTS),
+        OBT_PROP_ATOM(NET_WM_WINDOW_TYPE),
+        OBT_PROP_ATOM(NET_WM_STATE),
+        OBT_PROP_ATOM(WM_CLASS),
+        OBT_PROP_ATOM(WM_WINDOW_ROLE),
+        OBT_PROP_ATOM(WM_CLIENT_LEADER),
+        OBT_PROP_ATOM(SM_CLIENT_ID),
+        OBT_PROP_ATOM(WM_COMMAND),
+        OBT_PROP_ATOM(WM_CLIENT_MACHINE),
+        OBT_PROP_ATOM(NET_WM_PID),
+        OBT_PROP_ATOM(NET_WM_NAME),
+        OBT_PROP_ATOM(WM_NAME),
+        OBT_PROP_ATOM(WM_PROTOCOLS),
+        OBT_PROP_ATOM(NET_STARTUP_ID),
+        OBT_PROP_ATOM(NET_WM_DESKTOP),
+        OBT_PROP_ATOM(NET_WM_SYNC_REQUEST_COUNTER),
+        OBT_PROP_ATOM(NET_WM_STRUT_PARTIAL),
+        OBT_PROP_ATOM(NET_WM_STRUT),
+        /* not NET_WM_ICON, client_update_icons() only reads the parts of it
+           that it wants */
+        OBT_PROP_ATOM(NET_WM_ICON_GEOMETRY)
+    };
+
+    obt_prop_prefetch_begin(self->window, props, G_N_ELEMENTS(props));
+
+    client_get_all_props(self, real);
+
+    obt_prop_prefetch_end(self->window);
+}
+
+static void client_get_all_props(ObClient *self, gboolean real)
 {
     /* this is needed for the frame to set itself up */
     client_get_area(self);
@@ -1459,6 +1553,9 @@ static void client_update_transient_tree(ObClient *self,
         oldgtran == newgtran &&
         oldparent == newparent) return;
 
+    /* forget any transients or parents that were marked in the tree */
+    ++transient_serial;
+
     /** Remove the client from the transient tree **/
 
     for (it = self->transients; it; it = next) {
@@ -2221,12 +2318,95 @@ void client_update_strut(ObClient *self)
     }
 }
 
+/*! Where one of the icons in a window's _NET_WM_ICON is */
+typedef struct
+{
+    gulong offset; /*!< The index of its first pixel in the property */
+    guint w, h;
+    gboolean wanted;
+} ClientIconHeader;
+
+/*! Finds the icons in the window's _NET_WM_ICON by reading only their width
+  and height, skipping over the pixels */
+static GArray* client_read_icon_headers(ObClient *self)
+{
+    GArray *heads;
+    gulong off, left, *data;
+    guint num;
+
+    heads = g_array_new(FALSE, FALSE, sizeof(ClientIconHeader));
+
+    off = 0;
+    while (OBT_PROP_GETA32_PART(self->window, NET_WM_ICON, CARDINAL,
+                                off, 2, &data, &num, &left))
+    {
+        ClientIconHeader hd;
+        guint64 size;
+
+        if (num < 2) { /* make sure there is a w and h */
+            XFree(data);
+            break;
+        }
+        hd.offset = off + 2;
+        hd.w = data[0];
+        hd.h = data[1];
+        hd.wanted = FALSE;
+        XFree(data);
+
+        /* watch for the data being too small for the specified size */
+        size = (guint64)hd.w * hd.h;
+        if (size > left) break;
+
+        /* and for zero sized icons */
+        if (hd.w > 0 && hd.h > 0)
+            g_array_append_val(heads, hd);
+
+        off += 2 + size;
+        if (left - size < 2) break; /* no room for another icon */
+    }
+    return heads;
+}
+
+/*! Marks the icons that are the best to scale to each of the sizes that the
+  window's icon is drawn at.  That is the smallest one that is at least as
+  large, or the largest one if none are. */
+static void client_choose_icons(GArray *heads)
+{
+    const guint sizes[] = {
+        ob_rr_theme->button_size + 2,      /* the titlebar */
+        ob_rr_theme->menu_font_height,     /* the client list menus */
+        config_theme_window_list_icon_size /* the focus cycle popup */
+    };
+    guint i, j;
+
+    for (i = 0; i < G_N_ELEMENTS(sizes); ++i) {
+        ClientIconHeader *best = NULL;
+
+        for (j = 0; j < heads->len; ++j) {
+            ClientIconHeader *hd = &g_array_index(heads, ClientIconHeader, j);
+            guint big = MAX(hd->w, hd->h);
+
+            if (!best)
+                best = hd;
+            else {
+                guint bestbig = MAX(best->w, best->h);
+
+                if (bestbig < sizes[i] ? big > bestbig :
+                    (big >= sizes[i] && big < bestbig))
+                    best = hd;
+            }
+        }
+        if (best) best->wanted = TRUE;
+    }
+}
+
 void client_update_icons(ObClient *self)
 {
     guint num;
     guint32 *data;
     guint w, h, i, j;
     RrImage *img;
+    GArray *heads;
 
     img = NULL;
 
@@ -2235,39 +2415,44 @@ void client_update_icons(ObClient *self)
        icon */
     grab_server(TRUE);
 
-    if (OBT_PROP_GETA32(self->window, NET_WM_ICON, CARDINAL, &data, &num)) {
-        /* figure out how many valid icons are in here */
-        i = 0;
-        while (i + 2 < num) { /* +2 is to make sure there is a w and h */
-            w = data[i++];
-            h = data[i++];
-            /* watch for the data being too small for the specified size,
-               or for zero sized icons. */
-            if (i + w*h > num || w == 0 || h == 0) {
-                i += w*h;
-                continue;
-            }
+    heads = client_read_icon_headers(self);
+    client_choose_icons(heads);
 
-            /* convert it to the right bit order for ObRender */
-            for (j = 0; j < w*h; ++j)
-                data[i+j] =
-                    (((data[i+j] >> 24) & 0xff) << RrDefaultAlphaOffset) +
-                    (((data[i+j] >> 16) & 0xff) << RrDefaultRedOffset)   +
-                    (((data[i+j] >>  8) & 0xff) << RrDefaultGreenOffset) +
-                    (((data[i+j] >>  0) & 0xff) << RrDefaultBlueOffset);
-
-            /* add it to the image cache as an original */
-            if (!img)
-                img = RrImageNewFromData(ob_rr_icons, &data[i], w, h);
-            else
-                RrImageAddFromData(img, &data[i], w, h);
+    for (i = 0; i < heads->len; ++i) {
+        ClientIconHeader *hd = &g_array_index(heads, ClientIconHeader, i);
+        gulong *xdata, left;
+        RrPixel32 *pixels;
 
-            i += w*h;
+        if (!hd->wanted) continue;
+        if (!OBT_PROP_GETA32_PART(self->window, NET_WM_ICON, CARDINAL,
+                                  hd->offset, hd->w * hd->h,
+                                  &xdata, &num, &left))
+            continue;
+        if (num < hd->w * hd->h) { /* it changed under us */
+            XFree(xdata);
+            continue;
         }
 
-        g_free(data);
+        /* convert it to the right bit order for ObRender on the way out of
+           Xlib's buffer, into the memory the image will keep */
+        pixels = g_new(RrPixel32, hd->w * hd->h);
+        for (j = 0; j < hd->w * hd->h; ++j)
+            pixels[j] =
+                (((xdata[j] >> 24) & 0xff) << RrDefaultAlphaOffset) +
+                (((xdata[j] >> 16) & 0xff) << RrDefaultRedOffset)   +
+                (((xdata[j] >>  8) & 0xff) << RrDefaultGreenOffset) +
+                (((xdata[j] >>  0) & 0xff) << RrDefaultBlueOffset);
+        XFree(xdata);
+
+        /* add it to the image cache as an original */
+        if (!img)
+            img = RrImageNewFromDataTake(ob_rr_icons, pixels, hd->w, hd->h);
+        else
+            RrImageAddFromDataTake(img, pixels, hd->w, hd->h);
     }
 
+    g_array_free(heads, TRUE);
+
     /* if we didn't find an image from the NET_WM_ICON stuff, then try the
        legacy X hints */
     if (!img) {
@@ -2638,31 +2823,39 @@ gboolean client_is_oldfullscreen(const ObClient *self,
 
 static ObStackingLayer calc_layer(ObClient *self)
 {
-    ObStackingLayer l;
-
-    if (self->type == OB_CLIENT_TYPE_DESKTOP)
-        l = OB_STACKING_LAYER_DESKTOP;
-    else if (self->type == OB_CLIENT_TYPE_DOCK) {
-        if (self->below) l = OB_STACKING_LAYER_NORMAL;
-        else l = OB_STACKING_LAYER_ABOVE;
-    }
-    else if ((self->fullscreen ||
-              client_is_oldfullscreen(self, &self->area)) &&
-             /* you are fullscreen while you or your children are focused.. */
-             (client_focused(self) || client_search_focus_tree(self) ||
-              /* you can be fullscreen if you're on another desktop */
-              (self->desktop != screen_desktop &&
-               self->desktop != DESKTOP_ALL) ||
-              /* and you can also be fullscreen if the focused client is on
-                 another monitor, or nothing else is focused */
-              (!focus_client ||
-               client_monitor(focus_client) != client_monitor(self))))
-        l = OB_STACKING_LAYER_FULLSCREEN;
-    else if (self->above) l = OB_STACKING_LAYER_ABOVE;
-    else if (self->below) l = OB_STACKING_LAYER_BELOW;
-    else l = OB_STACKING_LAYER_NORMAL;
-
-    return l;
+    if (!self->own_layer_valid) {
+        if (self->type == OB_CLIENT_TYPE_DESKTOP)
+            self->own_layer = OB_STACKING_LAYER_DESKTOP;
+        else if (self->type == OB_CLIENT_TYPE_DOCK) {
+            if (self->below) self->own_layer = OB_STACKING_LAYER_NORMAL;
+            else self->own_layer = OB_STACKING_LAYER_ABOVE;
+        }
+        else if (self->above) self->own_layer = OB_STACKING_LAYER_ABOVE;
+        else if (self->below) self->own_layer = OB_STACKING_LAYER_BELOW;
+        else self->own_layer = OB_STACKING_LAYER_NORMAL;
+
+        self->own_fullscreen =
+            self->type != OB_CLIENT_TYPE_DESKTOP &&
+            self->type != OB_CLIENT_TYPE_DOCK &&
+            (self->fullscreen ||
+             client_is_oldfullscreen(self, &self->area));
+        self->own_layer_valid = TRUE;
+    }
+
+    /* this depends on the focus, so it can't be saved with the rest */
+    if (self->own_fullscreen &&
+        /* you are fullscreen while you or your children are focused.. */
+        (client_focused(self) || client_search_focus_tree(self) ||
+         /* you can be fullscreen if you're on another desktop */
+         (self->desktop != screen_desktop &&
+          self->desktop != DESKTOP_ALL) ||
+         /* and you can also be fullscreen if the focused client is on
+            another monitor, or nothing else is focused */
+         (!focus_client ||
+          client_monitor(focus_client) != client_monitor(self))))
+        return OB_STACKING_LAYER_FULLSCREEN;
+
+    return self->own_layer;
 }
 
 static void client_calc_layer_recursive(ObClient *self, ObClient *orig,
@@ -2681,7 +2874,7 @@ static void client_calc_layer_recursive(ObClient *self, ObClient *orig,
     }
 
     /* we've been restacked */
-    self->visited = TRUE;
+    self->layer_pass = layer_pass;
 
     for (it = self->transients; it; it = g_slist_next(it))
         client_calc_layer_recursive(it->data, orig,
@@ -2690,7 +2883,7 @@ static void client_calc_layer_recursive(ObClient *self, ObClient *orig,
 
 static void client_calc_layer_internal(ObClient *self)
 {
-    GSList *sit;
+    const GSList *sit;
 
     /* transients take on the layer of their parents */
     sit = client_search_all_top_parents(self);
@@ -2703,30 +2896,28 @@ void client_calc_layer(ObClient *self)
 {
     GList *it;
 
-    /* skip over stuff above fullscreen layer */
-    for (it = stacking_list; it; it = g_list_next(it))
-        if (window_layer(it->data) <= OB_STACKING_LAYER_FULLSCREEN) break;
+    /* this is called when the client's state changes */
+    self->own_layer_valid = FALSE;
 
-    /* find the windows in the fullscreen layer, and mark them not-visited */
-    for (; it; it = g_list_next(it)) {
-        if (window_layer(it->data) < OB_STACKING_LAYER_FULLSCREEN) break;
-        else if (WINDOW_IS_CLIENT(it->data))
-            WINDOW_AS_CLIENT(it->data)->visited = FALSE;
-    }
+    /* windows which are recalculated in this pass are marked with it, so
+       the ones in the fullscreen layer don't need to be cleared first */
+    ++layer_pass;
 
     client_calc_layer_internal(self);
 
-    /* skip over stuff above fullscreen layer */
-    for (it = stacking_list; it; it = g_list_next(it))
-        if (window_layer(it->data) <= OB_STACKING_LAYER_FULLSCREEN) break;
-
     /* now recalc any windows in the fullscreen layer which have not
-       had their layer recalced already */
-    for (; it; it = g_list_next(it)) {
-        if (window_layer(it->data) < OB_STACKING_LAYER_FULLSCREEN) break;
-        else if (WINDOW_IS_CLIENT(it->data) &&
-                 !WINDOW_AS_CLIENT(it->data)->visited)
+       had their layer recalced already.  that can move windows around in
+       the layer, so start over at its top after each one */
+    it = stacking_layer_top(OB_STACKING_LAYER_FULLSCREEN);
+    while (it && window_layer(it->data) == OB_STACKING_LAYER_FULLSCREEN) {
+        if (WINDOW_IS_CLIENT(it->data) &&
+            WINDOW_AS_CLIENT(it->data)->layer_pass != layer_pass)
+        {
             client_calc_layer_internal(it->data);
+            it = stacking_layer_top(OB_STACKING_LAYER_FULLSCREEN);
+        }
+        else
+            it = g_list_next(it);
     }
 }
 
@@ -3018,7 +3209,7 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
         user = FALSE; /* ignore if the client can't be moved/resized when it
                          is fullscreening */
     } else if (self->max_horz || self->max_vert) {
-        Rect *a;
+        const Rect *a;
         guint i;
 
         /* use all possible struts when maximizing to the full screen */
@@ -3038,8 +3229,6 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
 
         user = FALSE; /* ignore if the client can't be moved/resized when it
                          is maximizing */
-
-        g_slice_free(Rect, a);
     }
 
     /* gets the client's position */
@@ -3166,6 +3355,140 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
     g_assert(*h > 0);
 }
 
+static ClientConfigure* client_configure_get(ObClient *self)
+{
+    ClientConfigure *c;
+
+    c = g_hash_table_lookup(configure_map, self);
+    if (!c) {
+        c = g_slice_new0(ClientConfigure);
+        c->client = self;
+        c->oldw = self->area.width;
+        c->oldh = self->area.height;
+        g_hash_table_insert(configure_map, self, c);
+        configure_pending = g_slist_prepend(configure_pending, c);
+    }
+    return c;
+}
+
+static void client_configure_forget(ObClient *self)
+{
+    ClientConfigure *c;
+
+    if (!configure_map) return;
+
+    c = g_hash_table_lookup(configure_map, self);
+    if (c) {
+        g_hash_table_remove(configure_map, self);
+        configure_pending = g_slist_remove(configure_pending, c);
+        g_slice_free(ClientConfigure, c);
+    }
+}
+
+/*! Sends the client a synthetic ConfigureNotify with its root coordinates */
+static void client_send_configure_notify(ObClient *self)
+{
+    XEvent event;
+
+    event.type = ConfigureNotify;
+    event.xconfigure.display = obt_display;
+    event.xconfigure.event = self->window;
+    event.xconfigure.window = self->window;
+
+    ob_debug("Sending ConfigureNotify to %s for %d,%d %dx%d",
+             self->title, self->root_pos.x, self->root_pos.y,
+             self->area.width, self->area.height);
+
+    /* root window real coords */
+    event.xconfigure.x = self->root_pos.x;
+    event.xconfigure.y = self->root_pos.y;
+    event.xconfigure.width = self->area.width;
+    event.xconfigure.height = self->area.height;
+    event.xconfigure.border_width = self->border_width;
+    event.xconfigure.above = None;
+    event.xconfigure.override_redirect = FALSE;
+    XSendEvent(event.xconfigure.display, event.xconfigure.window,
+               FALSE, StructureNotifyMask, &event);
+}
+
+static void client_configure_send(ClientConfigure *c)
+{
+    ObClient *self = c->client;
+    ObFrame *f = self->frame;
+    gint w = self->area.width;
+    gint h = self->area.height;
+
+    /* grow the client before the frame and shrink it after, the same as
+       client_configure does, so nothing is exposed in between */
+    if (c->resize && (w > c->oldw || h > c->oldh))
+        XMoveResizeWindow(obt_display, self->window,
+                          f->size.left, f->size.top,
+                          MAX(w, c->oldw), MAX(h, c->oldh));
+
+    if (c->frame && !frame_iconify_animating(f))
+        XMoveResizeWindow(obt_display, f->window,
+                          f->area.x, f->area.y,
+                          f->area.width, f->area.height);
+
+    if (c->resize && (w <= c->oldw || h <= c->oldh))
+        XMoveResizeWindow(obt_display, self->window,
+                          f->size.left, f->size.top, w, h);
+
+    if (c->notify)
+        client_send_configure_notify(self);
+}
+
+void client_configure_begin(void)
+{
+    ++configure_depth;
+}
+
+void client_configure_commit(void)
+{
+    GSList *it;
+    gulong ignore_start;
+
+    g_assert(configure_depth > 0);
+    if (--configure_depth) return;
+
+    if (configure_ignore_enters)
+        ignore_start = event_start_ignore_all_enters();
+
+    /* the list was built backwards */
+    configure_pending = g_slist_reverse(configure_pending);
+    for (it = configure_pending; it; it = g_slist_next(it)) {
+        client_configure_send(it->data);
+        g_slice_free(ClientConfigure, it->data);
+    }
+    g_slist_free(configure_pending);
+    configure_pending = NULL;
+    if (configure_map) g_hash_table_remove_all(configure_map);
+
+    stacking_commit();
+
+    if (configure_ignore_enters) {
+        event_end_ignore_all_enters(ignore_start);
+        configure_ignore_enters = FALSE;
+    }
+
+    XFlush(obt_display);
+}
+
+gboolean client_configure_batching(void)
+{
+    return configure_depth > 0;
+}
+
+void client_configure_frame_window(ObClient *self)
+{
+    if (configure_depth)
+        client_configure_get(self)->frame = TRUE;
+    else
+        XMoveResizeWindow(obt_display, self->frame->window,
+                          self->frame->area.x, self->frame->area.y,
+                          self->frame->area.width, self->frame->area.height);
+}
+
 void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
                       gboolean user, gboolean final, gboolean force_reply)
 {
@@ -3191,6 +3514,9 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
 
     oldframe = self->frame->area;
     oldclient = self->area;
+    /* remember the window's size on the server before it changes */
+    if (configure_depth)
+        client_configure_get(self);
     RECT_SET(self->area, x, y, w, h);
 
     /* for app-requested resizes, always resize if 'resized' is true.
@@ -3201,7 +3527,15 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
                                     (resized && config_resize_redraw))));
 
     /* if the client is enlarging, then resize the client before the frame */
-    if (send_resize_client && (w > oldclient.width || h > oldclient.height)) {
+    if (send_resize_client && configure_depth) {
+        /* the client is resized when the transaction commits, growing or
+           shrinking around the frame just the same */
+        client_configure_get(self)->resize = TRUE;
+        frame_adjust_client_area(self->frame);
+    }
+    else if (send_resize_client &&
+             (w > oldclient.width || h > oldclient.height))
+    {
         XMoveResizeWindow(obt_display, self->window,
                           self->frame->size.left, self->frame->size.top,
                           MAX(w, oldclient.width), MAX(h, oldclient.height));
@@ -3222,8 +3556,10 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
     /* adjust the frame */
     if (fmoved || fresized) {
         gulong ignore_start;
-        if (!user)
+        if (!user) {
             ignore_start = event_start_ignore_all_enters();
+            if (configure_depth) configure_ignore_enters = TRUE;
+        }
 
         /* replay pending pointer event before move the window, in case it
            would change what window gets the event */
@@ -3267,26 +3603,12 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
     if ((!user && !resized && (rootmoved || force_reply)) ||
         (user && ((!resized && force_reply) || (final && rootmoved))))
     {
-        XEvent event;
-
-        event.type = ConfigureNotify;
-        event.xconfigure.display = obt_display;
-        event.xconfigure.event = self->window;
-        event.xconfigure.window = self->window;
-
-        ob_debug("Sending ConfigureNotify to %s for %d,%d %dx%d",
-                 self->title, self->root_pos.x, self->root_pos.y, w, h);
-
-        /* root window real coords */
-        event.xconfigure.x = self->root_pos.x;
-        event.xconfigure.y = self->root_pos.y;
-        event.xconfigure.width = w;
-        event.xconfigure.height = h;
-        event.xconfigure.border_width = self->border_width;
-        event.xconfigure.above = None;
-        event.xconfigure.override_redirect = FALSE;
-        XSendEvent(event.xconfigure.display, event.xconfigure.window,
-                   FALSE, StructureNotifyMask, &event);
+        if (configure_depth)
+            /* only the last position is sent, when the transaction
+               commits */
+            client_configure_get(self)->notify = TRUE;
+        else
+            client_send_configure_notify(self);
     }
 
     /* if the client is shrinking, then resize the frame before the client.
@@ -3294,14 +3616,16 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
        both of these resize sections may run, because the top one only resizes
        in the direction that is growing
      */
-    if (send_resize_client && (w <= oldclient.width || h <= oldclient.height))
+    if (send_resize_client && !configure_depth &&
+        (w <= oldclient.width || h <= oldclient.height))
     {
         frame_adjust_client_area(self->frame);
         XMoveResizeWindow(obt_display, self->window,
                           self->frame->size.left, self->frame->size.top, w, h);
     }
 
-    XFlush(obt_display);
+    if (!configure_depth)
+        XFlush(obt_display);
 
     /* if it moved between monitors, then this can affect the stacking
        layer of this window or others - for fullscreen windows.
@@ -3311,6 +3635,10 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
        watch out tho, don't try change stacking stuff if the window is no
        longer being managed !
     */
+    /* it may have started or stopped filling its monitor */
+    if (final)
+        self->own_layer_valid = FALSE;
+
     if (self->managed &&
         (screen_find_monitor(&self->frame->area) !=
          screen_find_monitor(&oldframe) ||
@@ -3752,6 +4080,7 @@ static void client_set_desktop_recursive(ObClient *self,
 
         old = self->desktop;
         self->desktop = target;
+        spatial_update(self);
         OBT_PROP_SET32(self->window, NET_WM_DESKTOP, CARDINAL, target);
         /* the frame can display the current desktop state */
         frame_adjust_state(self->frame);
@@ -4222,11 +4551,10 @@ ObClient *client_search_top_direct_parent(ObClient *self)
     return self;
 }
 
-static GSList *client_search_all_top_parents_internal(ObClient *self,
-                                                      gboolean bylayer,
-                                                      ObStackingLayer layer)
+static const GSList *client_search_top_parents_internal(ObClient *self,
+                                                       gboolean bylayer,
+                                                       ObStackingLayer layer)
 {
-    GSList *ret;
     ObClient *p;
 
     /* move up the direct transient chain as far as possible */
@@ -4235,21 +4563,19 @@ static GSList *client_search_all_top_parents_internal(ObClient *self,
         self = p;
 
     if (!self->parents)
-        ret = g_slist_prepend(NULL, self);
+        return &self->self_list;
     else
-        ret = g_slist_copy(self->parents);
-
-    return ret;
+        return self->parents;
 }
 
-GSList *client_search_all_top_parents(ObClient *self)
+const GSList *client_search_all_top_parents(ObClient *self)
 {
-    return client_search_all_top_parents_internal(self, FALSE, 0);
+    return client_search_top_parents_internal(self, FALSE, 0);
 }
 
-GSList *client_search_all_top_parents_layer(ObClient *self)
+const GSList *client_search_all_top_parents_layer(ObClient *self)
 {
-    return client_search_all_top_parents_internal(self, TRUE, self->layer);
+    return client_search_top_parents_internal(self, TRUE, self->layer);
 }
 
 ObClient *client_search_focus_parent(ObClient *self)
@@ -4287,17 +4613,62 @@ ObClient *client_search_parent(ObClient *self, ObClient *search)
     return NULL;
 }
 
-ObClient *client_search_transient(ObClient *self, ObClient *search)
+static void mark_transients(ObClient *self, guint mark)
 {
-    GSList *sit;
+    GSList *it;
 
-    for (sit = self->transients; sit; sit = g_slist_next(sit)) {
-        if (sit->data == search)
-            return search;
-        if (client_search_transient(sit->data, search))
-            return search;
+    /* the marks also stop this from looping if the tree has a cycle in it */
+    for (it = self->transients; it; it = g_slist_next(it)) {
+        ObClient *c = it->data;
+        if (c->transients_mark != mark) {
+            c->transients_mark = mark;
+            mark_transients(c, mark);
+        }
     }
-    return NULL;
+}
+
+static void mark_parents(ObClient *self, guint mark)
+{
+    GSList *it;
+
+    for (it = self->parents; it; it = g_slist_next(it)) {
+        ObClient *c = it->data;
+        if (c->parents_mark != mark) {
+            c->parents_mark = mark;
+            mark_parents(c, mark);
+        }
+    }
+}
+
+ObClient *client_search_transient(ObClient *self, ObClient *search)
+{
+    gboolean found;
+
+    if (self == marked_transients_of &&
+        marked_transients_serial == transient_serial)
+        found = search->transients_mark == marked_transients_mark;
+    else if (search == marked_parents_of &&
+             marked_parents_serial == transient_serial)
+        found = self->parents_mark == marked_parents_mark;
+    else if (search == last_transient_search) {
+        /* the same client is being searched for from different ones, so
+           mark everything above it */
+        marked_parents_of = search;
+        marked_parents_serial = transient_serial;
+        marked_parents_mark = ++transient_mark;
+        mark_parents(search, marked_parents_mark);
+        found = self->parents_mark == marked_parents_mark;
+    }
+    else {
+        marked_transients_of = self;
+        marked_transients_serial = transient_serial;
+        marked_transients_mark = ++transient_mark;
+        mark_transients(self, marked_transients_mark);
+        found = search->transients_mark == marked_transients_mark;
+    }
+
+    last_transient_search = search;
+    return found ? search : NULL;
 }
 
 static void detect_edge(Rect area, ObDirection dir,
@@ -4411,7 +4782,7 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
                                   gint *dest, gboolean *near_edge)
 {
     GList *it;
-    Rect *a;
+    const Rect *a;
     Rect dock_area;
     gint edge;
     guint i;
@@ -4441,10 +4812,9 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
 
     /* search for edges of monitors */
     for (i = 0; i < screen_num_monitors; ++i) {
-        Rect *area = screen_area(self->desktop, i, NULL);
+        const Rect *area = screen_area(self->desktop, i, NULL);
         detect_edge(*area, dir, my_head, my_size, my_edge_start,
                     my_edge_size, dest, near_edge);
-        g_slice_free(Rect, area);
     }
 
     /* search for edges of clients */
@@ -4468,8 +4838,6 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
     dock_get_area(&dock_area);
     detect_edge(dock_area, dir, my_head, my_size, my_edge_start,
                 my_edge_size, dest, near_edge);
-
-    g_slice_free(Rect, a);
 }
 
 void client_find_move_directional(ObClient *self, ObDirection dir,
@@ -4674,32 +5042,23 @@ void client_find_resize_directional(ObClient *self,
     *h -= self->frame->size.top + self->frame->size.bottom;
 }
 
+static gboolean client_under_pointer_filter(ObClient *c, gpointer data)
+{
+    return c->frame->visible &&
+        /* ignore all animating windows */
+        !frame_iconify_animating(c->frame);
+}
+
 ObClient* client_under_pointer(void)
 {
     gint x, y;
-    GList *it;
     ObClient *ret = NULL;
 
-    if (screen_pointer_pos(&x, &y)) {
-        for (it = stacking_list; it; it = g_list_next(it)) {
-            if (WINDOW_IS_CLIENT(it->data)) {
-                ObClient *c = WINDOW_AS_CLIENT(it->data);
-                if (c->frame->visible &&
-                    /* check the desktop, this is done during desktop
-                       switching and windows are shown/hidden status is not
-                       reliable */
-                    (c->desktop == screen_desktop ||
-                     c->desktop == DESKTOP_ALL) &&
-                    /* ignore all animating windows */
-                    !frame_iconify_animating(c->frame) &&
-                    RECT_CONTAINS(c->frame->area, x, y))
-                {
-                    ret = c;
-                    break;
-                }
-            }
-        }
-    }
+    if (screen_pointer_pos(&x, &y))
+        /* check the desktop, this is done during desktop switching and
+           windows are shown/hidden status is not reliable */
+        ret = spatial_client_at(screen_desktop, x, y,
+                                client_under_pointer_filter, NULL);
     return ret;
 }
 
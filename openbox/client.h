@@ -100,6 +100,15 @@ struct _ObClient
     GSList *parents;
     /*! The clients which are transients (children) of this client */
     GSList *transients;
+    /*! A list holding only this client, which is given as its top-level
+      parents when it has no parents */
+    GSList self_list;
+    /*! The mark of the last client_search_transient() search that found
+      this client below the client it searched from */
+    guint transients_mark;
+    /*! The mark of the last client_search_transient() search that found
+      this client above the client it searched for */
+    guint parents_mark;
     /*! The desktop on which the window resides (0xffffffff for all
       desktops) */
     guint desktop;
@@ -314,8 +323,18 @@ struct _ObClient
     /*! Where the window should iconify to/from */
     Rect icon_geometry;
 
-    /*! A boolean used for algorithms which need to mark clients as visited */
-    gboolean visited;
+    /*! The client_calc_layer() pass which last recalculated the client's
+      layer */
+    guint layer_pass;
+    /*! The layer which the client's own state puts it in, when it is not
+      fullscreen.  Only valid when own_layer_valid is TRUE */
+    ObStackingLayer own_layer;
+    /*! If the client is fullscreen, or fills a monitor like a fullscreen
+      window does.  Only valid when own_layer_valid is TRUE */
+    gboolean own_fullscreen;
+    /*! FALSE when the client's state has changed since its own_layer and
+      own_fullscreen were found */
+    gboolean own_layer_valid;
 };
 
 extern GList      *client_list;
@@ -458,6 +477,19 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
 void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
                       gboolean user, gboolean final, gboolean force_reply);
 
+/*! Starts a transaction which holds back the X requests made by
+  client_configure and by restacking, so that only the last state of each
+  window is sent to the server. Transactions may be nested. */
+void client_configure_begin(void);
+/*! Ends a transaction. When the outermost one ends, the held back requests
+  are sent in one burst and flushed. */
+void client_configure_commit(void);
+/*! Returns TRUE while a client_configure transaction is open */
+gboolean client_configure_batching(void);
+/*! Moves and resizes the client's frame window to the frame's area, or
+  holds it back until the open transaction commits */
+void client_configure_frame_window(ObClient *self);
+
 /*! Finds coordinates to keep a client on the screen.
   @param self The client
   @param x The x coord of the client, may be changed.
@@ -721,16 +753,16 @@ ObClient *client_search_modal_child(ObClient *self);
 
 /*! Returns a list of top-level windows which this is a transient for.
   It will only contain more than 1 element if the client is transient for its
-  group.
+  group.  The list belongs to a client, and must not be changed or freed.
 */
-GSList *client_search_all_top_parents(ObClient *self);
+const GSList *client_search_all_top_parents(ObClient *self);
 
 /*! Returns a list of top-level windows which this is a transient for, and
   which are in the same layer as this client.
   It will only contain more than 1 element if the client is transient for its
-  group.
+  group.  The list belongs to a client, and must not be changed or freed.
 */
-GSList *client_search_all_top_parents_layer(ObClient *self);
+const GSList *client_search_all_top_parents_layer(ObClient *self);
 
 /*! Returns the client's parent when it is transient for a direct window
   rather than a group. If it has no parents, or is transient for the
@@ -752,7 +784,10 @@ gboolean client_is_direct_child(ObClient *parent, ObClient *child);
 ObClient *client_search_parent(ObClient *self, ObClient *search);
 
 /*! Search for a transient of a client. The transient is returned if it is one,
-  NULL is returned if the given search is not a transient of the client. */
+  NULL is returned if the given search is not a transient of the client.
+  All the transients below a client, or all the parents above a searched for
+  client, are marked on the first search and reused until the transient tree
+  changes, so repeating a search from or for the same client is cheap. */
 ObClient *client_search_transient(ObClient *self, ObClient *search);
 
 /*! Set a client window to be above/below other clients.
@@ -28,6 +28,8 @@
 #include "gettext.h"
 #include "obt/paths.h"
 
+#include <string.h>
+
 gboolean config_focus_new;
 gboolean config_focus_follow;
 guint    config_focus_delay;
@@ -47,6 +49,7 @@ StrutPartial config_margins;
 
 gchar   *config_theme;
 gboolean config_theme_keepborder;
+gboolean config_theme_pixmap_frames;
 guint    config_theme_window_list_icon_size;
 
 gchar   *config_title_layout;
@@ -69,6 +72,7 @@ gboolean         config_resize_redraw;
 gint             config_resize_popup_show;
 ObResizePopupPos config_resize_popup_pos;
 GravityPoint     config_resize_popup_fixed;
+guint            config_resize_update_rate;
 
 ObStackingLayer config_dock_layer;
 gboolean        config_dock_floating;
@@ -106,6 +110,21 @@ gint     config_resist_edge;
 
 GSList *config_per_app_settings;
 
+/*! Per app settings which match a window's class, name or role exactly,
+  keyed by that string.  Each rule is only in one of these, in the first
+  one that it matches exactly, and the lists have the last rule first */
+static GHashTable *app_settings_by_class = NULL;
+static GHashTable *app_settings_by_name = NULL;
+static GHashTable *app_settings_by_role = NULL;
+/*! Per app settings which can not be found by an exact match, with the last
+  rule first */
+static GSList *app_settings_scan = NULL;
+static guint app_settings_count = 0;
+
+/*! A hash of each section of the configuration that was last loaded, keyed
+  by the section's name, to tell what changed on a reconfigure */
+static GHashTable *config_section_hashes = NULL;
+
 ObAppSettings* config_create_app_settings(void)
 {
     ObAppSettings *settings = g_slice_new0(ObAppSettings);
@@ -189,6 +208,77 @@ void config_parse_gravity_coord(xmlNodePtr node, GravityCoord *c)
     g_free(s);
 }
 
+static gboolean pattern_is_exact(const gchar *pattern)
+{
+    return pattern && !strpbrk(pattern, "*?");
+}
+
+static void index_per_app_settings(ObAppSettings *settings,
+                                   const gchar *class, const gchar *name,
+                                   const gchar *role)
+{
+    GHashTable *table;
+    const gchar *key;
+
+    if (pattern_is_exact(class))
+        table = app_settings_by_class, key = class;
+    else if (pattern_is_exact(name))
+        table = app_settings_by_name, key = name;
+    else if (pattern_is_exact(role))
+        table = app_settings_by_role, key = role;
+    else
+        table = NULL, key = NULL;
+
+    settings->order = app_settings_count++;
+
+    if (table) {
+        gpointer oldkey, list;
+
+        if (g_hash_table_lookup_extended(table, key, &oldkey, &list))
+            /* take the list out without freeing it or its key */
+            g_hash_table_steal(table, key);
+        else
+            oldkey = g_strdup(key), list = NULL;
+        g_hash_table_insert(table, oldkey, g_slist_prepend(list, settings));
+    }
+    else
+        app_settings_scan = g_slist_prepend(app_settings_scan, settings);
+}
+
+GSList* config_per_app_settings_candidates(const gchar *class,
+                                           const gchar *name,
+                                           const gchar *role)
+{
+    GSList *lists[4], *ret = NULL;
+    guint i, n = 0;
+
+    if (class &&
+        (lists[n] = g_hash_table_lookup(app_settings_by_class, class)))
+        ++n;
+    if (name && (lists[n] = g_hash_table_lookup(app_settings_by_name, name)))
+        ++n;
+    if (role && (lists[n] = g_hash_table_lookup(app_settings_by_role, role)))
+        ++n;
+    if ((lists[n] = app_settings_scan))
+        ++n;
+
+    /* merge the lists, keeping the rules in the order they were given.
+       the lists have the last rule first, so the merged list is built from
+       its end */
+    while (n) {
+        guint best = 0;
+        for (i = 1; i < n; ++i)
+            if (((ObAppSettings*)lists[i]->data)->order >
+                ((ObAppSettings*)lists[best]->data)->order)
+                best = i;
+
+        ret = g_slist_prepend(ret, lists[best]->data);
+        if (!(lists[best] = g_slist_next(lists[best])))
+            lists[best] = lists[--n];
+    }
+    return ret;
+}
+
 /*
   <applications>
     <application name="aterm">
@@ -419,6 +509,8 @@ static void parse_per_app_settings(xmlNodePtr node, gpointer d)
         if (type_set)
             settings->type = type;
 
+        index_per_app_settings(settings, class, name, role);
+
         g_free(name);
         g_free(class);
         g_free(group_name);
@@ -710,6 +802,8 @@ static void parse_theme(xmlNodePtr node, gpointer d)
     }
     if ((n = obt_xml_find_node(node, "keepBorder")))
         config_theme_keepborder = obt_xml_node_bool(n);
+    if ((n = obt_xml_find_node(node, "pixmapFrames")))
+        config_theme_pixmap_frames = obt_xml_node_bool(n);
     if ((n = obt_xml_find_node(node, "animateIconify")))
         config_animate_iconify = obt_xml_node_bool(n);
     if ((n = obt_xml_find_node(node, "windowListIconSize"))) {
@@ -856,6 +950,8 @@ static void parse_resize(xmlNodePtr node, gpointer d)
             }
         }
     }
+    if ((n = obt_xml_find_node(node, "updateRate")))
+        config_resize_update_rate = MAX(obt_xml_node_int(n), 0);
 }
 
 static void parse_dock(xmlNodePtr node, gpointer d)
@@ -1067,7 +1163,70 @@ static void bind_default_mouse(void)
                    it->mact, actions_parse_string(it->actname));
 }
 
-void config_startup(ObtXmlInst *i)
+/*! Returns a hash of everything in a section of the configuration */
+static guint section_hash(xmlNodePtr node)
+{
+    /* FNV-1a */
+    guint32 h = 2166136261u;
+    xmlBufferPtr buf;
+    const xmlChar *c;
+
+    buf = xmlBufferCreate();
+    xmlNodeDump(buf, node->doc, node, 0, 0);
+    for (c = xmlBufferContent(buf); *c; ++c) {
+        h ^= *c;
+        h *= 16777619u;
+    }
+    xmlBufferFree(buf);
+    return h;
+}
+
+ObConfigPart config_changed_parts(ObtXmlInst *i, gboolean loaded)
+{
+    static const struct {
+        const gchar *name;
+        ObConfigPart part;
+    } sections[] = {
+        { "theme", OB_CONFIG_PART_THEME },
+        { "keyboard", OB_CONFIG_PART_KEYBOARD },
+        { "mouse", OB_CONFIG_PART_MOUSE },
+        { "menu", OB_CONFIG_PART_MENU }
+    };
+    GHashTable *hashes;
+    xmlNodePtr n;
+    ObConfigPart changed = 0;
+    guint k;
+
+    hashes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    if (loaded) {
+        for (n = obt_xml_root(i)->children; n; n = n->next) {
+            guint h;
+
+            if (n->type != XML_ELEMENT_NODE) continue;
+
+            /* sections which appear more than once are hashed together */
+            h = GPOINTER_TO_UINT(g_hash_table_lookup(hashes, n->name));
+            h = h * 31 + section_hash(n);
+            g_hash_table_replace(hashes, g_strdup((const gchar*)n->name),
+                                 GUINT_TO_POINTER(h));
+        }
+    }
+
+    if (!config_section_hashes)
+        changed = OB_CONFIG_PART_ALL;
+    else {
+        for (k = 0; k < G_N_ELEMENTS(sections); ++k)
+            if (g_hash_table_lookup(hashes, sections[k].name) !=
+                g_hash_table_lookup(config_section_hashes, sections[k].name))
+                changed |= sections[k].part;
+        g_hash_table_destroy(config_section_hashes);
+    }
+    config_section_hashes = hashes;
+
+    return changed;
+}
+
+void config_startup(ObtXmlInst *i, ObConfigPart parts)
 {
     config_focus_new = TRUE;
     config_focus_follow = FALSE;
@@ -1097,6 +1256,7 @@ void config_startup(ObtXmlInst *i)
     config_animate_iconify = TRUE;
     config_title_layout = g_strdup("NLIMC");
     config_theme_keepborder = TRUE;
+    config_theme_pixmap_frames = FALSE;
     config_theme_window_list_icon_size = 36;
 
     config_font_activewindow = NULL;
@@ -1120,6 +1280,7 @@ void config_startup(ObtXmlInst *i)
     config_resize_popup_pos = OB_RESIZE_POS_CENTER;
     GRAVITY_COORD_SET(config_resize_popup_fixed.x, 0, FALSE, FALSE);
     GRAVITY_COORD_SET(config_resize_popup_fixed.y, 0, FALSE, FALSE);
+    config_resize_update_rate = 60;
 
     obt_xml_register(i, "resize", parse_resize, NULL);
 
@@ -1138,47 +1299,67 @@ void config_startup(ObtXmlInst *i)
 
     obt_xml_register(i, "dock", parse_dock, NULL);
 
-    translate_key("C-g", &config_keyboard_reset_state,
-                  &config_keyboard_reset_keycode);
-    config_keyboard_rebind_on_mapping_notify = TRUE;
+    if (parts & OB_CONFIG_PART_KEYBOARD) {
+        translate_key("C-g", &config_keyboard_reset_state,
+                      &config_keyboard_reset_keycode);
+        config_keyboard_rebind_on_mapping_notify = TRUE;
 
-    bind_default_keyboard();
+        bind_default_keyboard();
 
-    obt_xml_register(i, "keyboard", parse_keyboard, NULL);
+        obt_xml_register(i, "keyboard", parse_keyboard, NULL);
+    }
 
-    config_mouse_threshold = 8;
-    config_mouse_dclicktime = 500;
-    config_mouse_screenedgetime = 400;
-    config_mouse_screenedgewarp = FALSE;
+    if (parts & OB_CONFIG_PART_MOUSE) {
+        config_mouse_threshold = 8;
+        config_mouse_dclicktime = 500;
+        config_mouse_screenedgetime = 400;
+        config_mouse_screenedgewarp = FALSE;
 
-    bind_default_mouse();
+        bind_default_mouse();
 
-    obt_xml_register(i, "mouse", parse_mouse, NULL);
+        obt_xml_register(i, "mouse", parse_mouse, NULL);
+    }
 
     config_resist_win = 10;
     config_resist_edge = 20;
 
     obt_xml_register(i, "resistance", parse_resistance, NULL);
 
-    config_menu_hide_delay = 250;
-    config_menu_middle = FALSE;
-    config_submenu_show_delay = 100;
-    config_submenu_hide_delay = 400;
-    config_menu_manage_desktops = TRUE;
-    config_menu_files = NULL;
-    config_menu_show_icons = TRUE;
+    if (parts & OB_CONFIG_PART_MENU) {
+        config_menu_hide_delay = 250;
+        config_menu_middle = FALSE;
+        config_submenu_show_delay = 100;
+        config_submenu_hide_delay = 400;
+        config_menu_manage_desktops = TRUE;
+        config_menu_files = NULL;
+        config_menu_show_icons = TRUE;
 
-    obt_xml_register(i, "menu", parse_menu, NULL);
+        obt_xml_register(i, "menu", parse_menu, NULL);
+    }
 
     config_per_app_settings = NULL;
+    app_settings_by_class = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_slist_free);
+    app_settings_by_name = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_slist_free);
+    app_settings_by_role = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_slist_free);
+    app_settings_scan = NULL;
+    app_settings_count = 0;
 
     obt_xml_register(i, "applications", parse_per_app_settings, NULL);
 }
 
-void config_shutdown(void)
+void config_shutdown(ObConfigPart parts)
 {
     GSList *it;
 
+    if (ob_state() == OB_STATE_EXITING) {
+        if (config_section_hashes)
+            g_hash_table_destroy(config_section_hashes);
+        config_section_hashes = NULL;
+    }
+
     g_free(config_theme);
 
     g_free(config_title_layout);
@@ -1194,9 +1375,11 @@ void config_shutdown(void)
         g_free(it->data);
     g_slist_free(config_desktops_names);
 
-    for (it = config_menu_files; it; it = g_slist_next(it))
-        g_free(it->data);
-    g_slist_free(config_menu_files);
+    if (parts & OB_CONFIG_PART_MENU) {
+        for (it = config_menu_files; it; it = g_slist_next(it))
+            g_free(it->data);
+        g_slist_free(config_menu_files);
+    }
 
     for (it = config_per_app_settings; it; it = g_slist_next(it)) {
         ObAppSettings *itd = (ObAppSettings *)it->data;
@@ -1209,4 +1392,11 @@ void config_shutdown(void)
         g_slice_free(ObAppSettings, it->data);
     }
     g_slist_free(config_per_app_settings);
+
+    g_hash_table_destroy(app_settings_by_class);
+    g_hash_table_destroy(app_settings_by_name);
+    g_hash_table_destroy(app_settings_by_role);
+    app_settings_by_class = app_settings_by_name = app_settings_by_role = NULL;
+    g_slist_free(app_settings_scan);
+    app_settings_scan = NULL;
 }
@@ -42,6 +42,8 @@ struct _ObAppSettings
     GPatternSpec *group_name;
     GPatternSpec *title;
     ObClientType  type;
+    /*! The rule's position among the per app settings */
+    guint         order;
 
     GravityPoint position;
     gboolean pos_given;
@@ -113,6 +115,9 @@ extern gint config_resize_popup_show;
 extern ObResizePopupPos config_resize_popup_pos;
 /*! where to place the popup if it's in a fixed position */
 extern GravityPoint config_resize_popup_fixed;
+/*! How many times per second a window being moved or resized with the mouse
+  is updated, or 0 to update it for every motion of the pointer */
+extern guint config_resize_update_rate;
 
 /*! The stacking layer the dock will reside in */
 extern ObStackingLayer config_dock_layer;
@@ -146,6 +151,9 @@ extern gchar *config_theme;
 
 /*! Show the one-pixel border after toggleDecor */
 extern gboolean config_theme_keepborder;
+/*! Draw each window's decorations into a single pixmap, instead of giving
+  each part of them its own window */
+extern gboolean config_theme_pixmap_frames;
 /*! Titlebar button layout */
 extern gchar *config_title_layout;
 /*! Animate windows iconifying and restoring */
@@ -216,8 +224,38 @@ extern GSList *config_menu_files;
 /*! Per app settings */
 extern GSList *config_per_app_settings;
 
-void config_startup(ObtXmlInst *i);
-void config_shutdown(void);
+/*! Returns the per app settings which can match a window with the given
+  class, name and role, in the order they are in config_per_app_settings.
+  Rules which match these properties exactly are only returned when they are
+  equal, so the other properties of each rule still need to be checked.
+  The list must be freed with g_slist_free().
+*/
+GSList* config_per_app_settings_candidates(const gchar *class,
+                                           const gchar *name,
+                                           const gchar *role);
+
+/*! The parts of Openbox which a reconfigure only rebuilds when the settings
+  they are made from have changed */
+typedef enum {
+    OB_CONFIG_PART_THEME    = 1 << 0, /*!< The theme and window decorations */
+    OB_CONFIG_PART_KEYBOARD = 1 << 1, /*!< The key bindings */
+    OB_CONFIG_PART_MOUSE    = 1 << 2, /*!< The mouse bindings */
+    OB_CONFIG_PART_MENU     = 1 << 3, /*!< The menus */
+    OB_CONFIG_PART_ALL      = 0xf
+} ObConfigPart;
+
+/*! Compares the sections of the configuration loaded into @i with the ones
+  loaded last time, and returns the parts whose sections are different.
+  @param loaded FALSE if no configuration file could be loaded into @i
+*/
+ObConfigPart config_changed_parts(ObtXmlInst *i, gboolean loaded);
+
+/*! Sets up the default configuration and registers the sections to parse.
+  The settings for parts that are not in @parts are left as they are. */
+void config_startup(ObtXmlInst *i, ObConfigPart parts);
+/*! Frees the configuration, except for the settings of parts that are not in
+  @parts */
+void config_shutdown(ObConfigPart parts);
 
 /*! Create an ObAppSettings structure with the default values */
 ObAppSettings* config_create_app_settings(void);
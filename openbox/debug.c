@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
 #ifdef HAVE_UNISTD_H
@@ -41,6 +42,35 @@ static guint     ob_handler_prompt_id = 0;
 static GList    *prompt_queue = NULL;
 static gboolean  allow_prompts = TRUE;
 
+/*! The debug messages are saved in here as records, and written out together
+  from the main loop, instead of one at a time while events are handled */
+#define LOG_BUFFER_SIZE 65536
+/*! The longest time a message waits in the buffer, in milliseconds */
+#define LOG_FLUSH_DELAY 100
+/*! The most messages of one type which are logged in a second, the rest are
+  counted and dropped */
+#define LOG_RATE_LIMIT  500
+
+/*! The head of each message in the log buffer, its text follows it */
+typedef struct {
+    guint32 len;
+    guint8  type;
+} LogRecord;
+
+/*! How many messages of one type have been logged in the current second */
+typedef struct {
+    glong second;
+    guint count;
+    guint dropped;
+} LogRate;
+
+static gchar     log_buffer[LOG_BUFFER_SIZE];
+static gsize     log_buffer_len = 0;
+static guint     log_flush_id = 0;
+static LogRate   log_rate[OB_DEBUG_TYPE_NUM];
+
+static void log_flush(void);
+
 static void log_handler(const gchar *log_domain, GLogLevelFlags log_level,
                         const gchar *message, gpointer user_data);
 static void prompt_handler(const gchar *log_domain, GLogLevelFlags log_level,
@@ -84,6 +114,22 @@ void ob_debug_startup(void)
 
 void ob_debug_shutdown(void)
 {
+    ObDebugType i;
+
+    for (i = 0; i < OB_DEBUG_TYPE_NUM; ++i)
+        if (log_rate[i].dropped) {
+            guint dropped = log_rate[i].dropped;
+
+            log_rate[i].count = 0;
+            log_rate[i].dropped = 0;
+            ob_debug_type(i, "%u messages were dropped", dropped);
+        }
+    log_flush();
+    if (log_flush_id) {
+        g_source_remove(log_flush_id);
+        log_flush_id = 0;
+    }
+
     g_log_remove_handler("ObRender", rr_handler_id);
     g_log_remove_handler("Obt", obt_handler_id);
     g_log_remove_handler("Openbox", ob_handler_id);
@@ -101,18 +147,66 @@ void ob_debug_enable(ObDebugType type, gboolean enable)
     enabled_types[type] = enable;
 }
 
+gboolean ob_debug_type_enabled(ObDebugType type)
+{
+    g_assert(type < OB_DEBUG_TYPE_NUM);
+    return enabled_types[type];
+}
+
 static inline void log_print(FILE *out, const gchar* log_domain,
                              const gchar *level, const gchar *message)
 {
-    fprintf(out, "%s", log_domain);
-    fprintf(out, "-");
-    fprintf(out, "%s", level);
-    fprintf(out, ": ");
-    fprintf(out, "%s", message);
-    fprintf(out, "\n");
+    fprintf(out, "%s-%s: %s\n", log_domain, level, message);
     fflush(out);
 }
 
+static const gchar* log_prefix(ObDebugType type)
+{
+    switch (type) {
+    case OB_DEBUG_FOCUS:    return "(FOCUS) ";
+    case OB_DEBUG_APP_BUGS: return "(APPLICATION BUG) ";
+    case OB_DEBUG_SM:       return "(SESSION) ";
+    case OB_DEBUG_MOUSE:    return "(MOUSE) ";
+    default:                return "";
+    }
+}
+
+static void log_write_records(FILE *out)
+{
+    gsize pos = 0;
+
+    while (pos < log_buffer_len) {
+        LogRecord r;
+
+        memcpy(&r, log_buffer + pos, sizeof(LogRecord));
+        pos += sizeof(LogRecord);
+
+        fputs("Openbox-Debug: ", out);
+        fputs(log_prefix(r.type), out);
+        fwrite(log_buffer + pos, 1, r.len, out);
+        fputc('\n', out);
+        pos += r.len;
+    }
+    fflush(out);
+}
+
+/*! Writes out all of the debug messages waiting in the log buffer */
+static void log_flush(void)
+{
+    if (log_buffer_len) {
+        log_write_records(stdout);
+        if (log_file) log_write_records(log_file);
+        log_buffer_len = 0;
+    }
+}
+
+static gboolean log_flush_timeout(gpointer data)
+{
+    log_flush();
+    log_flush_id = 0;
+    return FALSE; /* don't repeat */
+}
+
 static void log_handler(const gchar *log_domain, GLogLevelFlags log_level,
                         const gchar *message, gpointer data)
 {
@@ -129,6 +223,9 @@ static void log_handler(const gchar *log_domain, GLogLevelFlags log_level,
     default:                   g_assert_not_reached(); /* invalid level.. */
     }
 
+    /* keep the messages in the order they were made */
+    log_flush();
+
     log_print(out, log_domain, level, message);
     if (log_file) log_print(log_file, log_domain, level, message);
 }
@@ -142,31 +239,90 @@ static void prompt_handler(const gchar *log_domain, GLogLevelFlags log_level,
         log_handler(log_domain, log_level, message, data);
 }
 
+/*! Formats the message straight into the log buffer.
+  @return FALSE if it did not fit in the space left in the buffer
+*/
+static gboolean log_record(ObDebugType type,
+                           const gchar *format, va_list args)
+{
+    LogRecord r;
+    gsize space;
+    gint len;
+
+    if (log_buffer_len + sizeof(LogRecord) >= LOG_BUFFER_SIZE)
+        return FALSE;
+
+    /* g_vsnprintf needs room for the terminating nul too */
+    space = LOG_BUFFER_SIZE - log_buffer_len - sizeof(LogRecord);
+    len = g_vsnprintf(log_buffer + log_buffer_len + sizeof(LogRecord),
+                      space, format, args);
+    if (len < 0 || (gsize)len >= space)
+        return FALSE;
+
+    r.len = len;
+    r.type = type;
+    memcpy(log_buffer + log_buffer_len, &r, sizeof(LogRecord));
+    log_buffer_len += sizeof(LogRecord) + len;
+
+    if (!log_flush_id)
+        log_flush_id = g_timeout_add(LOG_FLUSH_DELAY, log_flush_timeout,
+                                     NULL);
+    return TRUE;
+}
+
+/*! Returns TRUE if another message of the type can be logged in this
+  second */
+static gboolean log_rate_allow(ObDebugType type)
+{
+    LogRate *rate = &log_rate[type];
+    GTimeVal now;
+
+    g_get_current_time(&now);
+    if (now.tv_sec != rate->second) {
+        guint dropped = rate->dropped;
+
+        rate->second = now.tv_sec;
+        rate->count = 0;
+        rate->dropped = 0;
+        if (dropped)
+            ob_debug_type(type, "%u messages were dropped", dropped);
+    }
+
+    if (rate->count >= LOG_RATE_LIMIT) {
+        ++rate->dropped;
+        return FALSE;
+    }
+    ++rate->count;
+    return TRUE;
+}
+
 static inline void log_argv(ObDebugType type,
                             const gchar *format, va_list args)
 {
-    const gchar *prefix;
-    gchar *message;
+    va_list again, last;
 
     g_assert(type < OB_DEBUG_TYPE_NUM);
     if (!enabled_types[type]) return;
+    if (!log_rate_allow(type)) return;
 
-    switch (type) {
-    case OB_DEBUG_FOCUS:    prefix = "(FOCUS) ";           break;
-    case OB_DEBUG_APP_BUGS: prefix = "(APPLICATION BUG) "; break;
-    case OB_DEBUG_SM:       prefix = "(SESSION) ";         break;
-    default:                prefix = NULL;                 break;
-    }
+    G_VA_COPY(again, args);
+    G_VA_COPY(last, args);
+    if (!log_record(type, format, args)) {
+        /* make room and try again */
+        log_flush();
+        if (!log_record(type, format, again)) {
+            /* it is bigger than the whole buffer */
+            gchar *message = g_strdup_vprintf(format, last);
+            gchar *a = g_strconcat(log_prefix(type), message, NULL);
 
-    message = g_strdup_vprintf(format, args);
-    if (prefix) {
-        gchar *a = message;
-        message = g_strconcat(prefix, message, NULL);
-        g_free(a);
+            log_print(stdout, "Openbox", "Debug", a);
+            if (log_file) log_print(log_file, "Openbox", "Debug", a);
+            g_free(a);
+            g_free(message);
+        }
     }
-
-    g_debug("%s", message);
-    g_free(message);
+    va_end(again);
+    va_end(last);
 }
 
 void ob_debug(const gchar *a, ...)
@@ -31,12 +31,15 @@ typedef enum {
     OB_DEBUG_FOCUS,
     OB_DEBUG_APP_BUGS,
     OB_DEBUG_SM,
+    OB_DEBUG_MOUSE,
     OB_DEBUG_TYPE_NUM
 } ObDebugType;
 
 void ob_debug_type(ObDebugType type, const gchar *a, ...);
 
 void ob_debug_enable(ObDebugType type, gboolean enable);
+/*! Returns TRUE if the debugging output of the given type is shown */
+gboolean ob_debug_type_enabled(ObDebugType type);
 
 void ob_debug_show_prompts(void);
 
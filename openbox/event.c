@@ -927,6 +927,23 @@ static gboolean *context_to_button(ObFrame *f, ObFrameContext con, gboolean pres
     }
 }
 
+/*! Clears the hover state of all of the frame's buttons besides @keep, which
+  may be NULL.  Returns TRUE if any of them changed. */
+static gboolean clear_button_hovers(ObFrame *f, gboolean *keep)
+{
+    gboolean *hovers[] = { &f->max_hover, &f->close_hover, &f->iconify_hover,
+                           &f->desk_hover, &f->shade_hover };
+    gboolean changed = FALSE;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(hovers); ++i)
+        if (hovers[i] != keep && *hovers[i]) {
+            *hovers[i] = FALSE;
+            changed = TRUE;
+        }
+    return changed;
+}
+
 static gboolean more_client_message_event(Window window, Atom msgtype)
 {
     ObtXQueueWindowMessage wm;
@@ -1023,6 +1040,18 @@ static void event_handle_client(ObClient *client, XEvent *e)
 
         con = frame_context(client, e->xmotion.window,
                             e->xmotion.x, e->xmotion.y);
+        if (client->frame->composed && e->xmotion.window ==
+            client->frame->decor)
+        {
+            /* the pieces of a composed frame are not windows, so moving
+               between them crosses no windows, and only motion shows which
+               piece the pointer is over */
+            frame_adjust_pointer(client->frame, con);
+            if (clear_button_hovers(client->frame,
+                                    context_to_button(client->frame, con,
+                                                      FALSE)))
+                frame_adjust_state(client->frame);
+        }
         switch (con) {
         case OB_FRAME_CONTEXT_TITLEBAR:
         case OB_FRAME_CONTEXT_TLCORNER:
@@ -1050,6 +1079,24 @@ static void event_handle_client(ObClient *client, XEvent *e)
         }
         break;
     case LeaveNotify:
+        if (client->frame->composed &&
+            e->xcrossing.window == client->frame->decor)
+        {
+            /* the pointer left every button drawn in the composed frame */
+            gboolean changed = clear_button_hovers(client->frame, NULL);
+            if (e->xcrossing.mode == NotifyGrab) {
+                client->frame->max_press =
+                    client->frame->desk_press =
+                    client->frame->shade_press =
+                    client->frame->iconify_press =
+                    client->frame->close_press = FALSE;
+                changed = TRUE;
+            }
+            if (changed)
+                frame_adjust_state(client->frame);
+            break;
+        }
+
         con = frame_context(client, e->xcrossing.window,
                             e->xcrossing.x, e->xcrossing.y);
         switch (con) {
@@ -1113,6 +1160,9 @@ static void event_handle_client(ObClient *client, XEvent *e)
     {
         con = frame_context(client, e->xcrossing.window,
                             e->xcrossing.x, e->xcrossing.y);
+        if (client->frame->composed &&
+            e->xcrossing.window == client->frame->decor)
+            frame_adjust_pointer(client->frame, con);
         switch (con) {
         case OB_FRAME_CONTEXT_FRAME:
             if (grab_on_keyboard())
@@ -1312,7 +1362,7 @@ static void event_handle_client(ObClient *client, XEvent *e)
 
             /* oldschool fullscreen windows are allowed */
             if (!client_is_oldfullscreen(client, &to)) {
-                Rect *r;
+                const Rect *r;
 
                 r = screen_area(client->desktop, SCREEN_AREA_ALL_MONITORS,
                                 NULL);
@@ -1330,8 +1380,6 @@ static void event_handle_client(ObClient *client, XEvent *e)
                                   client->title, r->x, r->y);
                 }
 
-                g_slice_free(Rect, r);
-
                 /* they still requested a move, so don't change whether a
                    notify is sent or not */
             }
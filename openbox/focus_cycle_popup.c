@@ -61,6 +61,17 @@ struct _ObFocusCyclePopupTarget
     Window iconwin;
     /* This is used when the popup is in list mode */
     Window textwin;
+    /* The target's position in the popup's list of targets */
+    gint pos;
+    /* If the target's windows are mapped */
+    gboolean mapped;
+    /* If the target's windows have been painted yet, and what they were
+       painted with.  They are not painted again until one of these changes */
+    gboolean painted;
+    gint paintx, painty;
+    gint painttextw, painttexth;
+    gint paintalpha;
+    gboolean painthilite;
 };
 
 struct _ObFocusCyclePopup
@@ -76,11 +87,14 @@ struct _ObFocusCyclePopup
 
     GList *targets;
     gint n_targets;
-
-    const ObFocusCyclePopupTarget *last_target;
+    /* Maps an ObClient* to its node in the targets list */
+    GHashTable *target_map;
 
     gint maxtextw;
 
+    /* The size the background was last painted at */
+    gint paintw, painth;
+
     /* How are the list is scrolled, in scroll mode */
     gint scroll;
 
@@ -162,7 +176,7 @@ void focus_cycle_popup_startup(gboolean reconfig)
 
     popup.targets = NULL;
     popup.n_targets = 0;
-    popup.last_target = NULL;
+    popup.target_map = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     /* set up the hilite texture for the icon */
     popup.a_icon->texture[1].data.rgba.width = HILITE_SIZE;
@@ -225,6 +239,8 @@ void focus_cycle_popup_shutdown(gboolean reconfig)
 
         popup.targets = g_list_delete_link(popup.targets, popup.targets);
     }
+    g_hash_table_destroy(popup.target_map);
+    popup.target_map = NULL;
 
     g_free(popup.a_icon->texture[1].data.rgba.data);
     popup.a_icon->texture[1].data.rgba.data = NULL;
@@ -243,6 +259,7 @@ void focus_cycle_popup_shutdown(gboolean reconfig)
 
 static void popup_target_free(ObFocusCyclePopupTarget *t)
 {
+    g_hash_table_remove(popup.target_map, t->client);
     RrImageUnref(t->icon);
     g_free(t->text);
     XDestroyWindow(obt_display, t->iconwin);
@@ -287,26 +304,31 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
         ObClient *ft = it->data;
 
         if (focus_cycle_valid(ft)) {
-            GList *rit;
+            GList *rit = NULL;
 
             /* reuse the target if possible during refresh */
-            for (rit = rtlast; rit; rit = g_list_previous(rit)) {
-                ObFocusCyclePopupTarget *t = rit->data;
-                if (t->client == ft) {
-                    if (rit == rtlast)
-                        rtlast = g_list_previous(rit);
-                    rtargets = g_list_remove_link(rtargets, rit);
+            if (refresh_targets)
+                rit = g_hash_table_lookup(p->target_map, ft);
 
-                    p->targets = g_list_concat(rit, p->targets);
-                    ++n;
+            if (rit) {
+                ObFocusCyclePopupTarget *t = rit->data;
 
-                    if (rit != rtlast)
-                        change = TRUE; /* order changed */
-                    break;
-                }
+                /* the old targets are being used up from the end, so if it
+                   was not the last one left, the order changed */
+                if (rit == rtlast)
+                    rtlast = g_list_previous(rit);
+                else
+                    change = TRUE;
+                /* it was iconified or restored since it was painted */
+                if (t->painted &&
+                    t->paintalpha != (ft->iconic ? OB_ICONIC_ALPHA : 0xff))
+                    change = TRUE;
+                rtargets = g_list_remove_link(rtargets, rit);
+
+                p->targets = g_list_concat(rit, p->targets);
+                ++n;
             }
-
-            if (!rit) {
+            else {
                 gchar *text = popup_get_name(ft);
 
                 /* measure */
@@ -317,7 +339,7 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
                     g_free(text);
                 } else {
                     ObFocusCyclePopupTarget *t =
-                        g_slice_new(ObFocusCyclePopupTarget);
+                        g_slice_new0(ObFocusCyclePopupTarget);
 
                     t->client = ft;
                     t->text = text;
@@ -327,6 +349,7 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
                     t->textwin = create_window(p->bg, 0, 0, NULL);
 
                     p->targets = g_list_prepend(p->targets, t);
+                    g_hash_table_insert(p->target_map, ft, p->targets);
                     ++n;
 
                     change = TRUE; /* added a window */
@@ -345,6 +368,9 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
     }
 
     p->n_targets = n;
+    for (n = 0, it = p->targets; it; ++n, it = g_list_next(it))
+        ((ObFocusCyclePopupTarget*)it->data)->pos = n;
+
     if (refresh_targets)
         /* don't shrink when refreshing */
         p->maxtextw = MAX(p->maxtextw, maxwidth);
@@ -361,7 +387,6 @@ static void popup_cleanup(void)
         popup.targets = g_list_delete_link(popup.targets, popup.targets);
     }
     popup.n_targets = 0;
-    popup.last_target = NULL;
 }
 
 static gchar *popup_get_name(ObClient *c)
@@ -399,13 +424,12 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
     const Rect *screen_area = NULL;
     gint i;
     GList *it;
-    const ObFocusCyclePopupTarget *newtarget;
+    ObFocusCyclePopupTarget *newtarget;
     ObFocusCyclePopupMode mode = p->mode;
     gint icons_per_row;
     gint icon_rows;
     gint textw, texth;
     gint selected_pos;
-    gint last_scroll;
 
     /* vars for icon mode */
     gint icon_mode_textx;
@@ -484,20 +508,12 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
         h += OUTSIDE_BORDER + texth;
 
     /* find the focused target */
-    newtarget = NULL;
-    for (i = 0, it = p->targets; it; ++i, it = g_list_next(it)) {
-        const ObFocusCyclePopupTarget *target = it->data;
-        if (target->client == c) {
-            /* save the target */
-            newtarget = target;
-            break;
-        }
-    }
-    selected_pos = i;
-    g_assert(newtarget != NULL);
+    it = g_hash_table_lookup(p->target_map, c);
+    g_assert(it != NULL);
+    newtarget = it->data;
+    selected_pos = newtarget->pos;
 
     /* scroll the list if needed */
-    last_scroll = p->scroll;
     if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST) {
         const gint top = p->scroll + SCROLL_MARGIN;
         const gint bottom = p->scroll + icon_rows - SCROLL_MARGIN;
@@ -555,6 +571,15 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
         /* position the background but don't draw it */
         XMoveResizeWindow(obt_display, p->bg, x, y, w, h);
 
+        /* the targets' windows show the background through them, so they
+           have to be painted again if it changes */
+        if (w != p->paintw || h != p->painth) {
+            for (it = p->targets; it; it = g_list_next(it))
+                ((ObFocusCyclePopupTarget*)it->data)->painted = FALSE;
+            p->paintw = w;
+            p->painth = h;
+        }
+
         if (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS) {
             /* position the text */
             XMoveResizeWindow(obt_display, p->icon_mode_text,
@@ -608,98 +633,109 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
                 ob_rr_theme->down_arrow_mask->height);
     }
 
-    /* draw the icons and text */
+    /* draw the icons and text.  only the rows which are showing are drawn,
+       and only when something about them changed */
     for (i = 0, it = p->targets; it; ++i, it = g_list_next(it)) {
-        const ObFocusCyclePopupTarget *target = it->data;
-
-        /* have to redraw the targetted icon and last targetted icon
-         * to update the hilite */
-        if (!p->mapped || newtarget == target || p->last_target == target ||
-            last_scroll != p->scroll)
-        {
-            /* row and column start from 0 */
-            const gint row = i / icons_per_row - p->scroll;
-            const gint col = i % icons_per_row;
-            gint iconx, icony;
-            gint list_mode_textx, list_mode_texty;
-            RrAppearance *text;
-
-            /* find the coordinates for the icon */
-            iconx = icons_center_x + l + (col * HILITE_SIZE);
-            icony = t + (showing_arrows ? ob_rr_theme->up_arrow_mask->height
-                                          + OUTSIDE_BORDER
-                         : 0)
-                + (row * MAX(texth, HILITE_SIZE))
-                + MAX(texth - HILITE_SIZE, 0) / 2;
-
-            /* find the dimensions of the text box */
-            list_mode_textx = iconx + HILITE_SIZE + TEXT_BORDER;
-            list_mode_texty = icony;
-
-            /* position the icon */
-            XMoveResizeWindow(obt_display, target->iconwin,
-                              iconx, icony, HILITE_SIZE, HILITE_SIZE);
-
-            /* position the text */
-            if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST)
-                XMoveResizeWindow(obt_display, target->textwin,
-                                  list_mode_textx, list_mode_texty,
-                                  textw, texth);
-
-            /* show/hide the right windows */
-            if (row >= 0 && row < icon_rows) {
-                XMapWindow(obt_display, target->iconwin);
-                if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST)
-                    XMapWindow(obt_display, target->textwin);
-                else
-                    XUnmapWindow(obt_display, target->textwin);
-            } else {
+        ObFocusCyclePopupTarget *target = it->data;
+        /* row and column start from 0 */
+        const gint row = i / icons_per_row - p->scroll;
+        const gint col = i % icons_per_row;
+        const gboolean hilite = target == newtarget;
+        gint iconx, icony, alpha;
+        gint list_mode_textx, list_mode_texty;
+        RrAppearance *text;
+
+        /* only the list scrolls, in icon mode all the rows are showing */
+        if (row < 0 || row >= icon_rows) {
+            if (target->mapped) {
+                XUnmapWindow(obt_display, target->iconwin);
                 XUnmapWindow(obt_display, target->textwin);
-                if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST)
-                    XUnmapWindow(obt_display, target->iconwin);
-                else
-                    XMapWindow(obt_display, target->iconwin);
+                target->mapped = FALSE;
+                /* it has to be moved back into place when it is shown */
+                target->painted = FALSE;
             }
+            continue;
+        }
 
-            /* get the icon from the client */
-            p->a_icon->texture[0].data.image.twidth = ICON_SIZE;
-            p->a_icon->texture[0].data.image.theight = ICON_SIZE;
-            p->a_icon->texture[0].data.image.tx = HILITE_OFFSET;
-            p->a_icon->texture[0].data.image.ty = HILITE_OFFSET;
-            p->a_icon->texture[0].data.image.alpha =
-                target->client->iconic ? OB_ICONIC_ALPHA : 0xff;
-            p->a_icon->texture[0].data.image.image = target->icon;
-
-            /* Draw the hilite? */
-            p->a_icon->texture[1].type = (target == newtarget) ?
-                RR_TEXTURE_RGBA : RR_TEXTURE_NONE;
-
-            /* draw the icon */
-            p->a_icon->surface.parentx = iconx;
-            p->a_icon->surface.parenty = icony;
-            RrPaint(p->a_icon, target->iconwin, HILITE_SIZE, HILITE_SIZE);
-
-            /* draw the text */
-            if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST ||
-                target == newtarget)
-            {
-                text = (target == newtarget) ? p->a_hilite_text : p->a_text;
-                text->texture[0].data.text.string = target->text;
-                text->surface.parentx =
-                    mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
-                    icon_mode_textx : list_mode_textx;
-                text->surface.parenty =
-                    mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
-                    icon_mode_texty : list_mode_texty;
-                RrPaint(text,
-                        (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
-                         p->icon_mode_text : target->textwin),
-                        textw, texth);
-            }
+        /* find the coordinates for the icon */
+        iconx = icons_center_x + l + (col * HILITE_SIZE);
+        icony = t + (showing_arrows ? ob_rr_theme->up_arrow_mask->height
+                                      + OUTSIDE_BORDER
+                     : 0)
+            + (row * MAX(texth, HILITE_SIZE))
+            + MAX(texth - HILITE_SIZE, 0) / 2;
+        alpha = target->client->iconic ? OB_ICONIC_ALPHA : 0xff;
+
+        /* the windows still show what they were painted with last */
+        if (target->painted && target->paintx == iconx &&
+            target->painty == icony && target->painttextw == textw &&
+            target->painttexth == texth && target->paintalpha == alpha &&
+            target->painthilite == hilite)
+            continue;
+
+        /* find the dimensions of the text box */
+        list_mode_textx = iconx + HILITE_SIZE + TEXT_BORDER;
+        list_mode_texty = icony;
+
+        /* position the icon */
+        XMoveResizeWindow(obt_display, target->iconwin,
+                          iconx, icony, HILITE_SIZE, HILITE_SIZE);
+
+        /* position the text */
+        if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST)
+            XMoveResizeWindow(obt_display, target->textwin,
+                              list_mode_textx, list_mode_texty,
+                              textw, texth);
+
+        /* show the right windows */
+        if (!target->mapped) {
+            XMapWindow(obt_display, target->iconwin);
+            if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST)
+                XMapWindow(obt_display, target->textwin);
+            target->mapped = TRUE;
+        }
+
+        /* get the icon from the client */
+        p->a_icon->texture[0].data.image.twidth = ICON_SIZE;
+        p->a_icon->texture[0].data.image.theight = ICON_SIZE;
+        p->a_icon->texture[0].data.image.tx = HILITE_OFFSET;
+        p->a_icon->texture[0].data.image.ty = HILITE_OFFSET;
+        p->a_icon->texture[0].data.image.alpha = alpha;
+        p->a_icon->texture[0].data.image.image = target->icon;
+
+        /* Draw the hilite? */
+        p->a_icon->texture[1].type = hilite ?
+            RR_TEXTURE_RGBA : RR_TEXTURE_NONE;
+
+        /* draw the icon */
+        p->a_icon->surface.parentx = iconx;
+        p->a_icon->surface.parenty = icony;
+        RrPaint(p->a_icon, target->iconwin, HILITE_SIZE, HILITE_SIZE);
+
+        /* draw the text */
+        if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST || hilite) {
+            text = hilite ? p->a_hilite_text : p->a_text;
+            text->texture[0].data.text.string = target->text;
+            text->surface.parentx =
+                mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
+                icon_mode_textx : list_mode_textx;
+            text->surface.parenty =
+                mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
+                icon_mode_texty : list_mode_texty;
+            RrPaint(text,
+                    (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
+                     p->icon_mode_text : target->textwin),
+                    textw, texth);
         }
-    }
 
-    p->last_target = newtarget;
+        target->painted = TRUE;
+        target->paintx = iconx;
+        target->painty = icony;
+        target->painttextw = textw;
+        target->painttexth = texth;
+        target->paintalpha = alpha;
+        target->painthilite = hilite;
+    }
 
     XFlush(obt_display);
 }
@@ -782,43 +818,31 @@ void focus_cycle_popup_single_hide(void)
 
 gboolean focus_cycle_popup_is_showing(ObClient *c)
 {
-    if (popup.mapped) {
-        GList *it;
-
-        for (it = popup.targets; it; it = g_list_next(it)) {
-            ObFocusCyclePopupTarget *t = it->data;
-            if (t->client == c)
-                return TRUE;
-        }
-    }
-    return FALSE;
+    return popup.mapped && g_hash_table_lookup(popup.target_map, c) != NULL;
 }
 
 static ObClient* popup_revert(ObClient *target)
 {
     GList *it, *itt;
 
-    for (it = popup.targets; it; it = g_list_next(it)) {
-        ObFocusCyclePopupTarget *t = it->data;
-        if (t->client == target) {
-            /* move to a previous window if possible */
-            for (itt = it->prev; itt; itt = g_list_previous(itt)) {
-                ObFocusCyclePopupTarget *t2 = itt->data;
-                if (focus_cycle_valid(t2->client))
-                    return t2->client;
-            }
+    if (!(it = g_hash_table_lookup(popup.target_map, target)))
+        return NULL;
 
-            /* otherwise move to a following window if possible */
-            for (itt = it->next; itt; itt = g_list_next(itt)) {
-                ObFocusCyclePopupTarget *t2 = itt->data;
-                if (focus_cycle_valid(t2->client))
-                    return t2->client;
-            }
+    /* move to a previous window if possible */
+    for (itt = it->prev; itt; itt = g_list_previous(itt)) {
+        ObFocusCyclePopupTarget *t2 = itt->data;
+        if (focus_cycle_valid(t2->client))
+            return t2->client;
+    }
 
-            /* otherwise, we can't go anywhere there is nowhere valid to go */
-            return NULL;
-        }
+    /* otherwise move to a following window if possible */
+    for (itt = it->next; itt; itt = g_list_next(itt)) {
+        ObFocusCyclePopupTarget *t2 = itt->data;
+        if (focus_cycle_valid(t2->client))
+            return t2->client;
     }
+
+    /* otherwise, we can't go anywhere there is nowhere valid to go */
     return NULL;
 }
 
@@ -28,6 +28,7 @@
 #include "focus_cycle_indicator.h"
 #include "moveresize.h"
 #include "screen.h"
+#include "spatial.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
@@ -53,6 +54,8 @@ static void set_theme_statics(ObFrame *self);
 static void free_theme_statics(ObFrame *self);
 static gboolean frame_animate_iconify(gpointer self);
 static void frame_adjust_cursors(ObFrame *self);
+static void create_decor_windows(ObFrame *self, gulong mask,
+                                 XSetWindowAttributes *attrib);
 
 static Window createWindow(Window parent, Visual *visual,
                            gulong mask, XSetWindowAttributes *attrib)
@@ -64,6 +67,26 @@ static Window createWindow(Window parent, Visual *visual,
 
 }
 
+/* the windows' sizes are packed into the hash table's values */
+#define PACK_SIZE(w, h) GUINT_TO_POINTER(((guint)(w) << 16) | ((h) & 0xffff))
+#define UNPACK_W(v) ((gint)(GPOINTER_TO_UINT(v) >> 16))
+#define UNPACK_H(v) ((gint)(GPOINTER_TO_UINT(v) & 0xffff))
+
+static void frame_move_resize(ObFrame *self, Window win,
+                              gint x, gint y, gint w, gint h)
+{
+    XMoveResizeWindow(obt_display, win, x, y, w, h);
+    g_hash_table_insert(self->window_sizes, GUINT_TO_POINTER(win),
+                        PACK_SIZE(w, h));
+}
+
+static void frame_resize(ObFrame *self, Window win, gint w, gint h)
+{
+    XResizeWindow(obt_display, win, w, h);
+    g_hash_table_insert(self->window_sizes, GUINT_TO_POINTER(win),
+                        PACK_SIZE(w, h));
+}
+
 static Visual *check_32bit_client(ObClient *c)
 {
     XWindowAttributes wattrib;
@@ -92,6 +115,7 @@ ObFrame *frame_new(ObClient *client)
 
     self = g_slice_new0(ObFrame);
     self->client = client;
+    self->window_sizes = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     visual = check_32bit_client(client);
 
@@ -111,6 +135,26 @@ ObFrame *frame_new(ObClient *client)
     self->window = createWindow(obt_root(ob_screen), visual,
                                 mask, &attrib);
 
+    /* the composed decorations are the frame window's background, so they
+       have to match its depth */
+    self->composed = config_theme_pixmap_frames && !visual;
+    self->cursor_context = OB_FRAME_NUM_CONTEXTS;
+
+    if (self->composed) {
+        XGCValues gcv;
+
+        /* this is made first so that everything else is above it */
+        attrib.event_mask = ELEMENT_EVENTMASK;
+        self->decor = XCreateWindow(obt_display, self->window, 0, 0, 1, 1, 0,
+                                    0, InputOnly, CopyFromParent,
+                                    CWEventMask, &attrib);
+        XMapWindow(obt_display, self->decor);
+
+        gcv.graphics_exposures = False;
+        self->gc = XCreateGC(obt_display, self->window,
+                             GCGraphicsExposures, &gcv);
+    }
+
     /* create the visible decor windows */
 
     mask = 0;
@@ -123,63 +167,11 @@ ObFrame *frame_new(ObClient *client)
     self->backback = createWindow(self->window, NULL, mask, &attrib);
     self->backfront = createWindow(self->backback, NULL, mask, &attrib);
 
-    mask |= CWEventMask;
-    attrib.event_mask = ELEMENT_EVENTMASK;
-    self->innerleft = createWindow(self->window, NULL, mask, &attrib);
-    self->innertop = createWindow(self->window, NULL, mask, &attrib);
-    self->innerright = createWindow(self->window, NULL, mask, &attrib);
-    self->innerbottom = createWindow(self->window, NULL, mask, &attrib);
-
-    self->innerblb = createWindow(self->innerbottom, NULL, mask, &attrib);
-    self->innerbrb = createWindow(self->innerbottom, NULL, mask, &attrib);
-    self->innerbll = createWindow(self->innerleft, NULL, mask, &attrib);
-    self->innerbrr = createWindow(self->innerright, NULL, mask, &attrib);
-
-    self->title = createWindow(self->window, NULL, mask, &attrib);
-    self->titleleft = createWindow(self->window, NULL, mask, &attrib);
-    self->titletop = createWindow(self->window, NULL, mask, &attrib);
-    self->titletopleft = createWindow(self->window, NULL, mask, &attrib);
-    self->titletopright = createWindow(self->window, NULL, mask, &attrib);
-    self->titleright = createWindow(self->window, NULL, mask, &attrib);
-    self->titlebottom = createWindow(self->window, NULL, mask, &attrib);
-
-    self->topresize = createWindow(self->title, NULL, mask, &attrib);
-    self->tltresize = createWindow(self->title, NULL, mask, &attrib);
-    self->tllresize = createWindow(self->title, NULL, mask, &attrib);
-    self->trtresize = createWindow(self->title, NULL, mask, &attrib);
-    self->trrresize = createWindow(self->title, NULL, mask, &attrib);
-
-    self->left = createWindow(self->window, NULL, mask, &attrib);
-    self->right = createWindow(self->window, NULL, mask, &attrib);
-
-    self->label = createWindow(self->title, NULL, mask, &attrib);
-    self->max = createWindow(self->title, NULL, mask, &attrib);
-    self->close = createWindow(self->title, NULL, mask, &attrib);
-    self->desk = createWindow(self->title, NULL, mask, &attrib);
-    self->shade = createWindow(self->title, NULL, mask, &attrib);
-    self->icon = createWindow(self->title, NULL, mask, &attrib);
-    self->iconify = createWindow(self->title, NULL, mask, &attrib);
-
-    self->handle = createWindow(self->window, NULL, mask, &attrib);
-    self->lgrip = createWindow(self->handle, NULL, mask, &attrib);
-    self->rgrip = createWindow(self->handle, NULL, mask, &attrib);
-
-    self->handleleft = createWindow(self->handle, NULL, mask, &attrib);
-    self->handleright = createWindow(self->handle, NULL, mask, &attrib);
-
-    self->handletop = createWindow(self->window, NULL, mask, &attrib);
-    self->handlebottom = createWindow(self->window, NULL, mask, &attrib);
-    self->lgripleft = createWindow(self->window, NULL, mask, &attrib);
-    self->lgriptop = createWindow(self->window, NULL, mask, &attrib);
-    self->lgripbottom = createWindow(self->window, NULL, mask, &attrib);
-    self->rgripright = createWindow(self->window, NULL, mask, &attrib);
-    self->rgriptop = createWindow(self->window, NULL, mask, &attrib);
-    self->rgripbottom = createWindow(self->window, NULL, mask, &attrib);
+    if (!self->composed)
+        create_decor_windows(self, mask, &attrib);
 
     self->focused = FALSE;
 
-    /* the other stuff is shown based on decor settings */
-    XMapWindow(obt_display, self->label);
     XMapWindow(obt_display, self->backback);
     XMapWindow(obt_display, self->backfront);
 
@@ -197,29 +189,92 @@ ObFrame *frame_new(ObClient *client)
     return self;
 }
 
+/*! Create a window for each part of the decorations */
+static void create_decor_windows(ObFrame *self, gulong mask,
+                                 XSetWindowAttributes *attrib)
+{
+    mask |= CWEventMask;
+    attrib->event_mask = ELEMENT_EVENTMASK;
+    self->innerleft = createWindow(self->window, NULL, mask, attrib);
+    self->innertop = createWindow(self->window, NULL, mask, attrib);
+    self->innerright = createWindow(self->window, NULL, mask, attrib);
+    self->innerbottom = createWindow(self->window, NULL, mask, attrib);
+
+    self->innerblb = createWindow(self->innerbottom, NULL, mask, attrib);
+    self->innerbrb = createWindow(self->innerbottom, NULL, mask, attrib);
+    self->innerbll = createWindow(self->innerleft, NULL, mask, attrib);
+    self->innerbrr = createWindow(self->innerright, NULL, mask, attrib);
+
+    self->title = createWindow(self->window, NULL, mask, attrib);
+    self->titleleft = createWindow(self->window, NULL, mask, attrib);
+    self->titletop = createWindow(self->window, NULL, mask, attrib);
+    self->titletopleft = createWindow(self->window, NULL, mask, attrib);
+    self->titletopright = createWindow(self->window, NULL, mask, attrib);
+    self->titleright = createWindow(self->window, NULL, mask, attrib);
+    self->titlebottom = createWindow(self->window, NULL, mask, attrib);
+
+    self->topresize = createWindow(self->title, NULL, mask, attrib);
+    self->tltresize = createWindow(self->title, NULL, mask, attrib);
+    self->tllresize = createWindow(self->title, NULL, mask, attrib);
+    self->trtresize = createWindow(self->title, NULL, mask, attrib);
+    self->trrresize = createWindow(self->title, NULL, mask, attrib);
+
+    self->left = createWindow(self->window, NULL, mask, attrib);
+    self->right = createWindow(self->window, NULL, mask, attrib);
+
+    self->label = createWindow(self->title, NULL, mask, attrib);
+    self->max = createWindow(self->title, NULL, mask, attrib);
+    self->close = createWindow(self->title, NULL, mask, attrib);
+    self->desk = createWindow(self->title, NULL, mask, attrib);
+    self->shade = createWindow(self->title, NULL, mask, attrib);
+    self->icon = createWindow(self->title, NULL, mask, attrib);
+    self->iconify = createWindow(self->title, NULL, mask, attrib);
+
+    self->handle = createWindow(self->window, NULL, mask, attrib);
+    self->lgrip = createWindow(self->handle, NULL, mask, attrib);
+    self->rgrip = createWindow(self->handle, NULL, mask, attrib);
+
+    self->handleleft = createWindow(self->handle, NULL, mask, attrib);
+    self->handleright = createWindow(self->handle, NULL, mask, attrib);
+
+    self->handletop = createWindow(self->window, NULL, mask, attrib);
+    self->handlebottom = createWindow(self->window, NULL, mask, attrib);
+    self->lgripleft = createWindow(self->window, NULL, mask, attrib);
+    self->lgriptop = createWindow(self->window, NULL, mask, attrib);
+    self->lgripbottom = createWindow(self->window, NULL, mask, attrib);
+    self->rgripright = createWindow(self->window, NULL, mask, attrib);
+    self->rgriptop = createWindow(self->window, NULL, mask, attrib);
+    self->rgripbottom = createWindow(self->window, NULL, mask, attrib);
+
+    /* the other stuff is shown based on decor settings */
+    XMapWindow(obt_display, self->label);
+}
+
 static void set_theme_statics(ObFrame *self)
 {
+    if (self->composed) return;
+
     /* set colors/appearance/sizes for stuff that doesn't change */
-    XResizeWindow(obt_display, self->max,
-                  ob_rr_theme->button_size, ob_rr_theme->button_size);
-    XResizeWindow(obt_display, self->iconify,
-                  ob_rr_theme->button_size, ob_rr_theme->button_size);
-    XResizeWindow(obt_display, self->icon,
-                  ob_rr_theme->button_size + 2, ob_rr_theme->button_size + 2);
-    XResizeWindow(obt_display, self->close,
-                  ob_rr_theme->button_size, ob_rr_theme->button_size);
-    XResizeWindow(obt_display, self->desk,
-                  ob_rr_theme->button_size, ob_rr_theme->button_size);
-    XResizeWindow(obt_display, self->shade,
-                  ob_rr_theme->button_size, ob_rr_theme->button_size);
-    XResizeWindow(obt_display, self->tltresize,
-                  ob_rr_theme->grip_width, ob_rr_theme->paddingy + 1);
-    XResizeWindow(obt_display, self->trtresize,
-                  ob_rr_theme->grip_width, ob_rr_theme->paddingy + 1);
-    XResizeWindow(obt_display, self->tllresize,
-                  ob_rr_theme->paddingx + 1, ob_rr_theme->title_height);
-    XResizeWindow(obt_display, self->trrresize,
-                  ob_rr_theme->paddingx + 1, ob_rr_theme->title_height);
+    frame_resize(self, self->max,
+                 ob_rr_theme->button_size, ob_rr_theme->button_size);
+    frame_resize(self, self->iconify,
+                 ob_rr_theme->button_size, ob_rr_theme->button_size);
+    frame_resize(self, self->icon,
+                 ob_rr_theme->button_size + 2, ob_rr_theme->button_size + 2);
+    frame_resize(self, self->close,
+                 ob_rr_theme->button_size, ob_rr_theme->button_size);
+    frame_resize(self, self->desk,
+                 ob_rr_theme->button_size, ob_rr_theme->button_size);
+    frame_resize(self, self->shade,
+                 ob_rr_theme->button_size, ob_rr_theme->button_size);
+    frame_resize(self, self->tltresize,
+                 ob_rr_theme->grip_width, ob_rr_theme->paddingy + 1);
+    frame_resize(self, self->trtresize,
+                 ob_rr_theme->grip_width, ob_rr_theme->paddingy + 1);
+    frame_resize(self, self->tllresize,
+                 ob_rr_theme->paddingx + 1, ob_rr_theme->title_height);
+    frame_resize(self, self->trrresize,
+                 ob_rr_theme->paddingx + 1, ob_rr_theme->title_height);
 }
 
 static void free_theme_statics(ObFrame *self)
@@ -233,6 +288,11 @@ void frame_free(ObFrame *self)
     XDestroyWindow(obt_display, self->window);
     if (self->colormap)
         XFreeColormap(obt_display, self->colormap);
+    if (self->pixmap)
+        XFreePixmap(obt_display, self->pixmap);
+    if (self->gc)
+        XFreeGC(obt_display, self->gc);
+    g_hash_table_destroy(self->window_sizes);
 
     g_slice_free(ObFrame, self);
 }
@@ -401,12 +461,12 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
 
         /* position/size and map/unmap all the windows */
 
-        if (!fake) {
+        if (!fake && !self->composed) {
             gint innercornerheight =
                 ob_rr_theme->grip_width - self->size.bottom;
 
             if (self->cbwidth_l) {
-                XMoveResizeWindow(obt_display, self->innerleft,
+                frame_move_resize(self, self->innerleft,
                                   self->size.left - self->cbwidth_l,
                                   self->size.top,
                                   self->cbwidth_l, self->client->area.height);
@@ -416,7 +476,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XUnmapWindow(obt_display, self->innerleft);
 
             if (self->cbwidth_l && innercornerheight > 0) {
-                XMoveResizeWindow(obt_display, self->innerbll,
+                frame_move_resize(self, self->innerbll,
                                   0,
                                   self->client->area.height - 
                                   (ob_rr_theme->grip_width -
@@ -429,7 +489,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XUnmapWindow(obt_display, self->innerbll);
 
             if (self->cbwidth_r) {
-                XMoveResizeWindow(obt_display, self->innerright,
+                frame_move_resize(self, self->innerright,
                                   self->size.left + self->client->area.width,
                                   self->size.top,
                                   self->cbwidth_r, self->client->area.height);
@@ -439,7 +499,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XUnmapWindow(obt_display, self->innerright);
 
             if (self->cbwidth_r && innercornerheight > 0) {
-                XMoveResizeWindow(obt_display, self->innerbrr,
+                frame_move_resize(self, self->innerbrr,
                                   0,
                                   self->client->area.height - 
                                   (ob_rr_theme->grip_width -
@@ -452,7 +512,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XUnmapWindow(obt_display, self->innerbrr);
 
             if (self->cbwidth_t) {
-                XMoveResizeWindow(obt_display, self->innertop,
+                frame_move_resize(self, self->innertop,
                                   self->size.left - self->cbwidth_l,
                                   self->size.top - self->cbwidth_t,
                                   self->client->area.width +
@@ -464,18 +524,18 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XUnmapWindow(obt_display, self->innertop);
 
             if (self->cbwidth_b) {
-                XMoveResizeWindow(obt_display, self->innerbottom,
+                frame_move_resize(self, self->innerbottom,
                                   self->size.left - self->cbwidth_l,
                                   self->size.top + self->client->area.height,
                                   self->client->area.width +
                                   self->cbwidth_l + self->cbwidth_r,
                                   self->cbwidth_b);
 
-                XMoveResizeWindow(obt_display, self->innerblb,
+                frame_move_resize(self, self->innerblb,
                                   0, 0,
                                   ob_rr_theme->grip_width + self->bwidth,
                                   self->cbwidth_b);
-                XMoveResizeWindow(obt_display, self->innerbrb,
+                frame_move_resize(self, self->innerbrb,
                                   self->client->area.width +
                                   self->cbwidth_l + self->cbwidth_r -
                                   (ob_rr_theme->grip_width + self->bwidth),
@@ -498,16 +558,16 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 /* height of titleleft and titleright */
                 titlesides = (!self->max_horz ? ob_rr_theme->grip_width : 0);
 
-                XMoveResizeWindow(obt_display, self->titletop,
+                frame_move_resize(self, self->titletop,
                                   ob_rr_theme->grip_width + self->bwidth, 0,
                                   /* width + bwidth*2 - bwidth*2 - grips*2 */
                                   self->width - ob_rr_theme->grip_width * 2,
                                   self->bwidth);
-                XMoveResizeWindow(obt_display, self->titletopleft,
+                frame_move_resize(self, self->titletopleft,
                                   0, 0,
                                   ob_rr_theme->grip_width + self->bwidth,
                                   self->bwidth);
-                XMoveResizeWindow(obt_display, self->titletopright,
+                frame_move_resize(self, self->titletopright,
                                   self->client->area.width +
                                   self->size.left + self->size.right -
                                   ob_rr_theme->grip_width - self->bwidth,
@@ -516,11 +576,11 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                                   self->bwidth);
 
                 if (titlesides > 0) {
-                    XMoveResizeWindow(obt_display, self->titleleft,
+                    frame_move_resize(self, self->titleleft,
                                       0, self->bwidth,
                                       self->bwidth,
                                       titlesides);
-                    XMoveResizeWindow(obt_display, self->titleright,
+                    frame_move_resize(self, self->titleright,
                                       self->client->area.width +
                                       self->size.left + self->size.right -
                                       self->bwidth,
@@ -540,7 +600,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XMapWindow(obt_display, self->titletopright);
 
                 if (self->decorations & OB_FRAME_DECOR_TITLEBAR) {
-                    XMoveResizeWindow(obt_display, self->titlebottom,
+                    frame_move_resize(self, self->titlebottom,
                                       (self->max_horz ? 0 : self->bwidth),
                                       ob_rr_theme->title_height + self->bwidth,
                                       self->width,
@@ -560,7 +620,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
             }
 
             if (self->decorations & OB_FRAME_DECOR_TITLEBAR) {
-                XMoveResizeWindow(obt_display, self->title,
+                frame_move_resize(self, self->title,
                                   (self->max_horz ? 0 : self->bwidth),
                                   self->bwidth,
                                   self->width, ob_rr_theme->title_height);
@@ -568,7 +628,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 XMapWindow(obt_display, self->title);
 
                 if (self->decorations & OB_FRAME_DECOR_GRIPS) {
-                    XMoveResizeWindow(obt_display, self->topresize,
+                    frame_move_resize(self, self->topresize,
                                       ob_rr_theme->grip_width,
                                       0,
                                       self->width - ob_rr_theme->grip_width *2,
@@ -601,11 +661,11 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
             /* layout the title bar elements */
             layout_title(self);
 
-        if (!fake) {
+        if (!fake && !self->composed) {
             gint sidebwidth = self->max_horz ? 0 : self->bwidth;
 
             if (self->bwidth && self->size.bottom) {
-                XMoveResizeWindow(obt_display, self->handlebottom,
+                frame_move_resize(self, self->handlebottom,
                                   ob_rr_theme->grip_width +
                                   self->bwidth + sidebwidth,
                                   self->size.top + self->client->area.height +
@@ -616,7 +676,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
 
 
                 if (sidebwidth) {
-                    XMoveResizeWindow(obt_display, self->lgripleft,
+                    frame_move_resize(self, self->lgripleft,
                                       0,
                                       self->size.top +
                                       self->client->area.height +
@@ -628,7 +688,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                                       (!self->max_horz ?
                                        ob_rr_theme->grip_width :
                                        self->size.bottom - self->cbwidth_b));
-                    XMoveResizeWindow(obt_display, self->rgripright,
+                    frame_move_resize(self, self->rgripright,
                                   self->size.left +
                                       self->client->area.width +
                                       self->size.right - self->bwidth,
@@ -650,13 +710,13 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                     XUnmapWindow(obt_display, self->rgripright);
                 }
 
-                XMoveResizeWindow(obt_display, self->lgripbottom,
+                frame_move_resize(self, self->lgripbottom,
                                   sidebwidth,
                                   self->size.top + self->client->area.height +
                                   self->size.bottom - self->bwidth,
                                   ob_rr_theme->grip_width + self->bwidth,
                                   self->bwidth);
-                XMoveResizeWindow(obt_display, self->rgripbottom,
+                frame_move_resize(self, self->rgripbottom,
                                   self->size.left + self->client->area.width +
                                   self->size.right - self->bwidth - sidebwidth-
                                   ob_rr_theme->grip_width,
@@ -672,7 +732,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 if (self->decorations & OB_FRAME_DECOR_HANDLE &&
                     ob_rr_theme->handle_height > 0)
                 {
-                    XMoveResizeWindow(obt_display, self->handletop,
+                    frame_move_resize(self, self->handletop,
                                       ob_rr_theme->grip_width +
                                       self->bwidth + sidebwidth,
                                       FRAME_HANDLE_Y(self),
@@ -682,12 +742,12 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                     XMapWindow(obt_display, self->handletop);
 
                     if (self->decorations & OB_FRAME_DECOR_GRIPS) {
-                        XMoveResizeWindow(obt_display, self->handleleft,
+                        frame_move_resize(self, self->handleleft,
                                           ob_rr_theme->grip_width,
                                           0,
                                           self->bwidth,
                                           ob_rr_theme->handle_height);
-                        XMoveResizeWindow(obt_display, self->handleright,
+                        frame_move_resize(self, self->handleright,
                                           self->width -
                                           ob_rr_theme->grip_width -
                                           self->bwidth,
@@ -695,13 +755,13 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                                           self->bwidth,
                                           ob_rr_theme->handle_height);
 
-                        XMoveResizeWindow(obt_display, self->lgriptop,
+                        frame_move_resize(self, self->lgriptop,
                                           sidebwidth,
                                           FRAME_HANDLE_Y(self),
                                           ob_rr_theme->grip_width +
                                           self->bwidth,
                                           self->bwidth);
-                        XMoveResizeWindow(obt_display, self->rgriptop,
+                        frame_move_resize(self, self->rgriptop,
                                           self->size.left +
                                           self->client->area.width +
                                           self->size.right - self->bwidth -
@@ -747,18 +807,18 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
             if (self->decorations & OB_FRAME_DECOR_HANDLE &&
                 ob_rr_theme->handle_height > 0)
             {
-                XMoveResizeWindow(obt_display, self->handle,
+                frame_move_resize(self, self->handle,
                                   sidebwidth,
                                   FRAME_HANDLE_Y(self) + self->bwidth,
                                   self->width, ob_rr_theme->handle_height);
                 XMapWindow(obt_display, self->handle);
 
                 if (self->decorations & OB_FRAME_DECOR_GRIPS) {
-                    XMoveResizeWindow(obt_display, self->lgrip,
+                    frame_move_resize(self, self->lgrip,
                                       0, 0,
                                       ob_rr_theme->grip_width,
                                       ob_rr_theme->handle_height);
-                    XMoveResizeWindow(obt_display, self->rgrip,
+                    frame_move_resize(self, self->rgrip,
                                       self->width - ob_rr_theme->grip_width,
                                       0,
                                       ob_rr_theme->grip_width,
@@ -781,7 +841,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 (self->client->area.height + self->size.top +
                  self->size.bottom) > ob_rr_theme->grip_width * 2)
             {
-                XMoveResizeWindow(obt_display, self->left,
+                frame_move_resize(self, self->left,
                                   0,
                                   self->bwidth + ob_rr_theme->grip_width,
                                   self->bwidth,
@@ -797,7 +857,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                 (self->client->area.height + self->size.top +
                  self->size.bottom) > ob_rr_theme->grip_width * 2)
             {
-                XMoveResizeWindow(obt_display, self->right,
+                frame_move_resize(self, self->right,
                                   self->client->area.width + self->cbwidth_l +
                                   self->cbwidth_r + self->bwidth,
                                   self->bwidth + ob_rr_theme->grip_width,
@@ -810,7 +870,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
             } else
                 XUnmapWindow(obt_display, self->right);
 
-            XMoveResizeWindow(obt_display, self->backback,
+            frame_move_resize(self, self->backback,
                               self->size.left, self->size.top,
                               self->client->area.width,
                               self->client->area.height);
@@ -834,6 +894,8 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
         frame_client_gravity(self, &self->area.x, &self->area.y);
     }
 
+    spatial_update(self->client);
+
     if (!fake) {
         if (!frame_iconify_animating(self))
             /* move and resize the top level frame.
@@ -842,11 +904,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                but don't do this during an iconify animation. it will be
                reflected afterwards.
             */
-            XMoveResizeWindow(obt_display, self->window,
-                              self->area.x,
-                              self->area.y,
-                              self->area.width,
-                              self->area.height);
+            client_configure_frame_window(self->client);
 
         /* when the client has StaticGravity, it likes to move around.
            also this correctly positions the client when it maps.
@@ -856,6 +914,10 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
                     self->size.left, self->size.top);
 
         if (resized) {
+            if (self->composed)
+                frame_resize(self, self->decor,
+                             self->area.width, self->area.height);
+
             self->need_render = TRUE;
             framerender_frame(self);
             frame_adjust_shape(self);
@@ -879,11 +941,11 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
         if (focus_cycle_target == self->client)
             focus_cycle_update_indicator(self->client);
     }
-    if (resized && (self->decorations & OB_FRAME_DECOR_TITLEBAR) &&
-        self->label_width)
+    if (resized && !self->composed &&
+        (self->decorations & OB_FRAME_DECOR_TITLEBAR) && self->label_width)
     {
-        XResizeWindow(obt_display, self->label, self->label_width,
-                      ob_rr_theme->label_height);
+        frame_resize(self, self->label, self->label_width,
+                     ob_rr_theme->label_height);
     }
 }
 
@@ -901,6 +963,13 @@ static void frame_adjust_cursors(ObFrame *self)
         gboolean sh = self->client->shaded;
         XSetWindowAttributes a;
 
+        if (self->composed) {
+            /* the cursor is picked when the pointer moves, so just make sure
+               that it gets picked again */
+            self->cursor_context = OB_FRAME_NUM_CONTEXTS;
+            return;
+        }
+
         /* these ones turn off when max vert, and some when shaded */
         a.cursor = ob_cursor(r && topbot && !sh ?
                              OB_CURSOR_NORTH : OB_CURSOR_NONE);
@@ -955,7 +1024,7 @@ static void frame_adjust_cursors(ObFrame *self)
 void frame_adjust_client_area(ObFrame *self)
 {
     /* adjust the window which is there to prevent flashing on unmap */
-    XMoveResizeWindow(obt_display, self->backfront, 0, 0,
+    frame_move_resize(self, self->backfront, 0, 0,
                       self->client->area.width,
                       self->client->area.height);
 }
@@ -1016,48 +1085,52 @@ void frame_grab_client(ObFrame *self)
     window_add(&self->window, CLIENT_AS_WINDOW(self->client));
     window_add(&self->backback, CLIENT_AS_WINDOW(self->client));
     window_add(&self->backfront, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerleft, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innertop, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerright, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerbottom, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerblb, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerbll, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerbrb, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->innerbrr, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->title, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->label, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->max, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->close, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->desk, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->shade, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->icon, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->iconify, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->handle, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->lgrip, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->rgrip, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->topresize, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->tltresize, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->tllresize, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->trtresize, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->trrresize, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->left, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->right, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->titleleft, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->titletop, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->titletopleft, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->titletopright, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->titleright, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->titlebottom, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->handleleft, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->handletop, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->handleright, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->handlebottom, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->lgripleft, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->lgriptop, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->lgripbottom, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->rgripright, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->rgriptop, CLIENT_AS_WINDOW(self->client));
-    window_add(&self->rgripbottom, CLIENT_AS_WINDOW(self->client));
+    if (self->composed)
+        window_add(&self->decor, CLIENT_AS_WINDOW(self->client));
+    else {
+        window_add(&self->innerleft, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innertop, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innerright, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innerbottom, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innerblb, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innerbll, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innerbrb, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->innerbrr, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->title, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->label, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->max, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->close, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->desk, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->shade, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->icon, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->iconify, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->handle, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->lgrip, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->rgrip, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->topresize, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->tltresize, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->tllresize, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->trtresize, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->trrresize, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->left, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->right, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->titleleft, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->titletop, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->titletopleft, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->titletopright, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->titleright, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->titlebottom, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->handleleft, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->handletop, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->handleright, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->handlebottom, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->lgripleft, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->lgriptop, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->lgripbottom, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->rgripright, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->rgriptop, CLIENT_AS_WINDOW(self->client));
+        window_add(&self->rgripbottom, CLIENT_AS_WINDOW(self->client));
+    }
 }
 
 static gboolean find_reparent(XEvent *e, gpointer data)
@@ -1088,48 +1161,52 @@ void frame_release_client(ObFrame *self)
     window_remove(self->window);
     window_remove(self->backback);
     window_remove(self->backfront);
-    window_remove(self->innerleft);
-    window_remove(self->innertop);
-    window_remove(self->innerright);
-    window_remove(self->innerbottom);
-    window_remove(self->innerblb);
-    window_remove(self->innerbll);
-    window_remove(self->innerbrb);
-    window_remove(self->innerbrr);
-    window_remove(self->title);
-    window_remove(self->label);
-    window_remove(self->max);
-    window_remove(self->close);
-    window_remove(self->desk);
-    window_remove(self->shade);
-    window_remove(self->icon);
-    window_remove(self->iconify);
-    window_remove(self->handle);
-    window_remove(self->lgrip);
-    window_remove(self->rgrip);
-    window_remove(self->topresize);
-    window_remove(self->tltresize);
-    window_remove(self->tllresize);
-    window_remove(self->trtresize);
-    window_remove(self->trrresize);
-    window_remove(self->left);
-    window_remove(self->right);
-    window_remove(self->titleleft);
-    window_remove(self->titletop);
-    window_remove(self->titletopleft);
-    window_remove(self->titletopright);
-    window_remove(self->titleright);
-    window_remove(self->titlebottom);
-    window_remove(self->handleleft);
-    window_remove(self->handletop);
-    window_remove(self->handleright);
-    window_remove(self->handlebottom);
-    window_remove(self->lgripleft);
-    window_remove(self->lgriptop);
-    window_remove(self->lgripbottom);
-    window_remove(self->rgripright);
-    window_remove(self->rgriptop);
-    window_remove(self->rgripbottom);
+    if (self->composed)
+        window_remove(self->decor);
+    else {
+        window_remove(self->innerleft);
+        window_remove(self->innertop);
+        window_remove(self->innerright);
+        window_remove(self->innerbottom);
+        window_remove(self->innerblb);
+        window_remove(self->innerbll);
+        window_remove(self->innerbrb);
+        window_remove(self->innerbrr);
+        window_remove(self->title);
+        window_remove(self->label);
+        window_remove(self->max);
+        window_remove(self->close);
+        window_remove(self->desk);
+        window_remove(self->shade);
+        window_remove(self->icon);
+        window_remove(self->iconify);
+        window_remove(self->handle);
+        window_remove(self->lgrip);
+        window_remove(self->rgrip);
+        window_remove(self->topresize);
+        window_remove(self->tltresize);
+        window_remove(self->tllresize);
+        window_remove(self->trtresize);
+        window_remove(self->trrresize);
+        window_remove(self->left);
+        window_remove(self->right);
+        window_remove(self->titleleft);
+        window_remove(self->titletop);
+        window_remove(self->titletopleft);
+        window_remove(self->titletopright);
+        window_remove(self->titleright);
+        window_remove(self->titlebottom);
+        window_remove(self->handleleft);
+        window_remove(self->handletop);
+        window_remove(self->handleright);
+        window_remove(self->handlebottom);
+        window_remove(self->lgripleft);
+        window_remove(self->lgriptop);
+        window_remove(self->lgripbottom);
+        window_remove(self->rgripright);
+        window_remove(self->rgriptop);
+        window_remove(self->rgripbottom);
+    }
 
     if (self->flash_timer) g_source_remove(self->flash_timer);
 }
@@ -1247,6 +1324,9 @@ static void layout_title(ObFrame *self)
         }
     }
 
+    /* composed frames find the elements from the positions above */
+    if (self->composed) return;
+
     /* position and map the elements */
     if (self->icon_on) {
         XMapWindow(obt_display, self->icon);
@@ -1390,6 +1470,215 @@ ObFrameContext frame_context_from_string(const gchar *name)
     return OB_FRAME_CONTEXT_NONE;
 }
 
+/*! Find the context for a click in the corners of the titlebar of a window
+  that is fully maximized, where the user is treated as clicking the button
+  that is in the corner.  The coordinates are relative to the frame. */
+static ObFrameContext maximized_title_context(ObFrame *self, gint fx, gint fy)
+{
+    /* figure out if we're over the area that should be considered a
+       button */
+    if (fy < self->bwidth + ob_rr_theme->paddingy + 1 +
+        ob_rr_theme->button_size)
+    {
+        if (fx < (self->bwidth + ob_rr_theme->paddingx + 1 +
+                  ob_rr_theme->button_size))
+        {
+            if (self->leftmost != OB_FRAME_CONTEXT_NONE)
+                return self->leftmost;
+        }
+        else if (fx >= (self->area.width -
+                        (self->bwidth + ob_rr_theme->paddingx + 1 +
+                         ob_rr_theme->button_size)))
+        {
+            if (self->rightmost != OB_FRAME_CONTEXT_NONE)
+                return self->rightmost;
+        }
+    }
+
+    /* there is no resizing maximized windows so make them the titlebar
+       context */
+    return OB_FRAME_CONTEXT_TITLEBAR;
+}
+
+#define IN_BOX(x, y, bx, by, bw, bh) \
+    ((x) >= (bx) && (x) < (bx) + (bw) && (y) >= (by) && (y) < (by) + (bh))
+
+/*! Find which part of composed decorations is at a point, relative to the
+  frame.  This gives the same contexts as the windows that the decorations are
+  otherwise made of, looking at them from the top of their stacking order
+  down.  @titlearea is set to TRUE if the point is in one of the windows
+  around the titlebar that act like buttons when the window is maximized. */
+static ObFrameContext composed_context(ObFrame *self, gint x, gint y,
+                                       gboolean *titlearea)
+{
+    const gint grip = ob_rr_theme->grip_width;
+    const gint bw = self->bwidth;
+    const gint sidebw = self->max_horz ? 0 : bw;
+    const gint fw = self->area.width;
+    const gint fh = self->client->area.height +
+        self->size.top + self->size.bottom;
+    const gint handley = FRAME_HANDLE_Y(self);
+
+    *titlearea = FALSE;
+
+    if (self->decorations & OB_FRAME_DECOR_TITLEBAR &&
+        IN_BOX(x, y, sidebw, bw, self->width, ob_rr_theme->title_height))
+    {
+        const gint tx = x - sidebw, ty = y - bw;
+        const gint bs = ob_rr_theme->button_size;
+        const gint by = ob_rr_theme->paddingy + 1;
+
+        if (self->iconify_on && IN_BOX(tx, ty, self->iconify_x, by, bs, bs))
+            return OB_FRAME_CONTEXT_ICONIFY;
+        if (self->icon_on && IN_BOX(tx, ty, self->icon_x, by - 1,
+                                    bs + 2, bs + 2))
+            return OB_FRAME_CONTEXT_ICON;
+        if (self->shade_on && IN_BOX(tx, ty, self->shade_x, by, bs, bs))
+            return OB_FRAME_CONTEXT_SHADE;
+        if (self->desk_on && IN_BOX(tx, ty, self->desk_x, by, bs, bs))
+            return OB_FRAME_CONTEXT_ALLDESKTOPS;
+        if (self->close_on && IN_BOX(tx, ty, self->close_x, by, bs, bs))
+            return OB_FRAME_CONTEXT_CLOSE;
+        if (self->max_on && IN_BOX(tx, ty, self->max_x, by, bs, bs))
+            return OB_FRAME_CONTEXT_MAXIMIZE;
+        if (self->label_on && self->label_width > 0 &&
+            IN_BOX(tx, ty, self->label_x, by - 1, self->label_width,
+                   ob_rr_theme->label_height))
+            return OB_FRAME_CONTEXT_TITLEBAR;
+
+        if (self->decorations & OB_FRAME_DECOR_GRIPS) {
+            if (tx >= self->width - ob_rr_theme->paddingx - 1 ||
+                (tx >= self->width - grip && ty < by))
+                return OB_FRAME_CONTEXT_TRCORNER;
+            if (tx < ob_rr_theme->paddingx + 1 || (tx < grip && ty < by))
+                return OB_FRAME_CONTEXT_TLCORNER;
+            if (ty < by)
+                return OB_FRAME_CONTEXT_TOP;
+        }
+
+        *titlearea = TRUE;
+        return OB_FRAME_CONTEXT_TITLEBAR;
+    }
+
+    if (self->decorations & OB_FRAME_DECOR_HANDLE &&
+        ob_rr_theme->handle_height > 0 &&
+        IN_BOX(x, y, sidebw, handley + bw, self->width,
+               ob_rr_theme->handle_height))
+    {
+        const gint hx = x - sidebw;
+
+        if (self->decorations & OB_FRAME_DECOR_GRIPS) {
+            if (hx < grip + bw)
+                return OB_FRAME_CONTEXT_BLCORNER;
+            if (hx >= self->width - grip - bw)
+                return OB_FRAME_CONTEXT_BRCORNER;
+        }
+        return OB_FRAME_CONTEXT_BOTTOM;
+    }
+
+    /* the inner border around the client */
+    if (IN_BOX(x, y, self->size.left - self->cbwidth_l,
+               self->size.top - self->cbwidth_t,
+               self->client->area.width + self->cbwidth_l + self->cbwidth_r,
+               self->client->area.height + self->cbwidth_t + self->cbwidth_b))
+    {
+        const gint ix = x - (self->size.left - self->cbwidth_l);
+        const gint iw = self->client->area.width +
+            self->cbwidth_l + self->cbwidth_r;
+        const gint cornerh = grip - self->size.bottom;
+
+        if (y < self->size.top)
+            return OB_FRAME_CONTEXT_TITLEBAR;
+        if (y >= self->size.top + self->client->area.height) {
+            if (ix < grip + bw)
+                return OB_FRAME_CONTEXT_BLCORNER;
+            if (ix >= iw - (grip + bw))
+                return OB_FRAME_CONTEXT_BRCORNER;
+            return OB_FRAME_CONTEXT_BOTTOM;
+        }
+        if (x < self->size.left)
+            return (cornerh > 0 && y >= self->size.top +
+                    self->client->area.height - cornerh ?
+                    OB_FRAME_CONTEXT_BLCORNER : OB_FRAME_CONTEXT_LEFT);
+        if (x >= self->size.left + self->client->area.width)
+            return (cornerh > 0 && y >= self->size.top +
+                    self->client->area.height - cornerh ?
+                    OB_FRAME_CONTEXT_BRCORNER : OB_FRAME_CONTEXT_RIGHT);
+        /* it's the client, which is above us anyways */
+        return OB_FRAME_CONTEXT_NONE;
+    }
+
+    if (!bw || x < 0 || x >= fw || y < 0 || y >= fh)
+        return OB_FRAME_CONTEXT_NONE;
+
+    /* the outer border */
+    if (y < bw) {
+        *titlearea = TRUE;
+        if (x < grip + bw) return OB_FRAME_CONTEXT_TLCORNER;
+        if (x >= fw - (grip + bw)) return OB_FRAME_CONTEXT_TRCORNER;
+        return OB_FRAME_CONTEXT_TOP;
+    }
+    if (self->decorations & OB_FRAME_DECOR_TITLEBAR &&
+        y < bw * 2 + ob_rr_theme->title_height &&
+        y >= bw + ob_rr_theme->title_height &&
+        x >= sidebw && x < sidebw + self->width)
+        return OB_FRAME_CONTEXT_TITLEBAR;
+    if (self->size.bottom) {
+        /* the bottom edge */
+        if (y >= fh - bw) {
+            if (x < sidebw + grip + bw)
+                return OB_FRAME_CONTEXT_BLCORNER;
+            if (x >= fw - (sidebw + grip + bw))
+                return OB_FRAME_CONTEXT_BRCORNER;
+            return OB_FRAME_CONTEXT_BOTTOM;
+        }
+        /* the top of the handle, which only has corners with the grips */
+        if (self->decorations & OB_FRAME_DECOR_HANDLE &&
+            ob_rr_theme->handle_height > 0 &&
+            y >= handley && y < handley + bw)
+        {
+            if (x >= sidebw + grip + bw && x < fw - (sidebw + grip + bw))
+                return OB_FRAME_CONTEXT_BOTTOM;
+            if (self->decorations & OB_FRAME_DECOR_GRIPS &&
+                x >= sidebw && x < fw - sidebw)
+                return (x < fw / 2 ?
+                        OB_FRAME_CONTEXT_BLCORNER : OB_FRAME_CONTEXT_BRCORNER);
+        }
+    }
+    if (!self->max_horz && (x < bw || x >= fw - bw)) {
+        const gboolean l = x < bw;
+
+        if (y < bw + grip) {
+            *titlearea = TRUE;
+            return l ? OB_FRAME_CONTEXT_TLCORNER : OB_FRAME_CONTEXT_TRCORNER;
+        }
+        if (self->size.bottom && y >= fh - grip)
+            return l ? OB_FRAME_CONTEXT_BLCORNER : OB_FRAME_CONTEXT_BRCORNER;
+        if (fh > grip * 2 && y < fh - grip + bw)
+            return l ? OB_FRAME_CONTEXT_LEFT : OB_FRAME_CONTEXT_RIGHT;
+    }
+    return OB_FRAME_CONTEXT_NONE;
+}
+
+gboolean frame_window_size(ObFrame *self, Window win, gint *w, gint *h)
+{
+    gpointer size;
+
+    if (win == self->window) {
+        *w = self->area.width;
+        *h = self->area.height;
+        return TRUE;
+    }
+    if (g_hash_table_lookup_extended(self->window_sizes,
+                                     GUINT_TO_POINTER(win), NULL, &size))
+    {
+        *w = UNPACK_W(size);
+        *h = UNPACK_H(size);
+        return TRUE;
+    }
+    return FALSE;
+}
+
 ObFrameContext frame_context(ObClient *client, Window win, gint x, gint y)
 {
     ObFrame *self;
@@ -1416,6 +1705,19 @@ ObFrameContext frame_context(ObClient *client, Window win, gint x, gint y)
 
     self = client->frame;
 
+    if (self->composed && win == self->decor) {
+        gboolean titlearea;
+        ObFrameContext con;
+
+        con = composed_context(self, x, y, &titlearea);
+        if (self->max_horz && self->max_vert && titlearea)
+            return maximized_title_context(self, x, y);
+        if ((self->max_vert || self->shaded) && con == OB_FRAME_CONTEXT_TOP)
+            /* can't resize vertically when max vert or shaded */
+            return OB_FRAME_CONTEXT_TITLEBAR;
+        return con;
+    }
+
     /* when the user clicks in the corners of the titlebar and the client
        is fully maximized, then treat it like they clicked in the
        button that is there */
@@ -1446,29 +1748,7 @@ ObFrameContext frame_context(ObClient *client, Window win, gint x, gint y)
         else if (win == self->titleright)
             fx += self->area.width - self->bwidth;
 
-        /* figure out if we're over the area that should be considered a
-           button */
-        if (fy < self->bwidth + ob_rr_theme->paddingy + 1 +
-            ob_rr_theme->button_size)
-        {
-            if (fx < (self->bwidth + ob_rr_theme->paddingx + 1 +
-                      ob_rr_theme->button_size))
-            {
-                if (self->leftmost != OB_FRAME_CONTEXT_NONE)
-                    return self->leftmost;
-            }
-            else if (fx >= (self->area.width -
-                            (self->bwidth + ob_rr_theme->paddingx + 1 +
-                             ob_rr_theme->button_size)))
-            {
-                if (self->rightmost != OB_FRAME_CONTEXT_NONE)
-                    return self->rightmost;
-            }
-        }
-
-        /* there is no resizing maximized windows so make them the titlebar
-           context */
-        return OB_FRAME_CONTEXT_TITLEBAR;
+        return maximized_title_context(self, fx, fy);
     }
     else if (self->max_vert &&
              (win == self->titletop || win == self->topresize))
@@ -1526,6 +1806,53 @@ ObFrameContext frame_context(ObClient *client, Window win, gint x, gint y)
     return OB_FRAME_CONTEXT_NONE;
 }
 
+void frame_adjust_pointer(ObFrame *self, ObFrameContext context)
+{
+    gboolean r, topbot, sh;
+    ObCursor cur;
+
+    if (!self->composed || context == self->cursor_context) return;
+    self->cursor_context = context;
+
+    /* these match the cursors that frame_adjust_cursors() gives to the
+       windows for each context */
+    r = (self->functions & OB_CLIENT_FUNC_RESIZE) &&
+        !(self->max_horz && self->max_vert);
+    topbot = !self->max_vert;
+    sh = self->shaded;
+
+    switch (context) {
+    case OB_FRAME_CONTEXT_TOP:
+        cur = r && topbot && !sh ? OB_CURSOR_NORTH : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_BOTTOM:
+        cur = r && topbot ? OB_CURSOR_SOUTH : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_TLCORNER:
+        cur = r ? (sh ? OB_CURSOR_WEST : OB_CURSOR_NORTHWEST) : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_TRCORNER:
+        cur = r ? (sh ? OB_CURSOR_EAST : OB_CURSOR_NORTHEAST) : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_LEFT:
+        cur = r ? OB_CURSOR_WEST : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_RIGHT:
+        cur = r ? OB_CURSOR_EAST : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_BLCORNER:
+        cur = r ? OB_CURSOR_SOUTHWEST : OB_CURSOR_NONE;
+        break;
+    case OB_FRAME_CONTEXT_BRCORNER:
+        cur = r ? OB_CURSOR_SOUTHEAST : OB_CURSOR_NONE;
+        break;
+    default:
+        cur = OB_CURSOR_NONE;
+        break;
+    }
+    XDefineCursor(obt_display, self->decor, ob_cursor(cur));
+}
+
 void frame_client_gravity(ObFrame *self, gint *x, gint *y)
 {
     /* horizontal */
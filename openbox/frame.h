@@ -93,6 +93,25 @@ struct _ObFrame
     guint     functions;
     guint     decorations;
 
+    /*! When TRUE, the decorations are all drawn into one pixmap which is the
+      frame window's background, and the windows for each part of them below
+      are never created.  Decided when the frame is made. */
+    gboolean  composed;
+    /*! An input-only window under the client, which gets the pointer events
+      for all of the decorations when they are composed */
+    Window    decor;
+    Pixmap    pixmap;     /*!< The composed decorations */
+    gint      pixmap_w;
+    gint      pixmap_h;
+    GC        gc;         /*!< For drawing into the pixmap */
+    /*! The context that the decor window's cursor was last set for, or
+      OB_FRAME_NUM_CONTEXTS when it needs to be set again */
+    ObFrameContext cursor_context;
+
+    /*! The size that each of the frame's windows was last given, so it does
+      not have to be asked for from the server. Window -> packed size */
+    GHashTable *window_sizes;
+
     Window    title;
     Window    label;
     Window    max;
@@ -238,6 +257,16 @@ gboolean frame_next_context_from_string(gchar *names, ObFrameContext *cx);
 ObFrameContext frame_context(struct _ObClient *self, Window win,
                              gint x, gint y);
 
+/*! Gets the size of one of the frame's windows without asking the server.
+  @return FALSE if @win is not one of the frame's windows
+*/
+gboolean frame_window_size(ObFrame *self, Window win, gint *w, gint *h);
+
+/*! Show the cursor for the context that the pointer is in.  This only needs
+  to be called for composed frames, where the decorations don't have windows
+  of their own to hold their cursors. */
+void frame_adjust_pointer(ObFrame *self, ObFrameContext context);
+
 /*! Applies gravity to the client's position to find where the frame should
   be positioned.
   @return The proper coordinates for the frame, based on the client.
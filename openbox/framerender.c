@@ -31,6 +31,19 @@ static void framerender_iconify(ObFrame *self, RrAppearance *a);
 static void framerender_desk(ObFrame *self, RrAppearance *a);
 static void framerender_shade(ObFrame *self, RrAppearance *a);
 static void framerender_close(ObFrame *self, RrAppearance *a);
+static void framerender_element(ObFrame *self, RrAppearance *a, Window win,
+                                gint x, gint y, gint w, gint h);
+static void compose_begin(ObFrame *self);
+static void compose_fill(ObFrame *self, RrColor *color,
+                         gint x, gint y, gint w, gint h);
+static void compose_end(ObFrame *self);
+
+/* where the titlebar and handle are in the frame, for composed frames */
+#define TITLE_X(f) ((f)->max_horz ? 0 : (f)->bwidth)
+#define TITLE_Y(f) ((f)->bwidth)
+#define HANDLE_X(f) ((f)->max_horz ? 0 : (f)->bwidth)
+#define HANDLE_Y(f) ((f)->size.top + (f)->client->area.height + \
+                     (f)->cbwidth_b + (f)->bwidth)
 
 void framerender_frame(ObFrame *self)
 {
@@ -42,7 +55,9 @@ void framerender_frame(ObFrame *self)
         return;
     self->need_render = FALSE;
 
-    {
+    if (self->composed)
+        compose_begin(self);
+    else {
         gulong px;
 
         px = (self->focused ?
@@ -244,37 +259,47 @@ void framerender_frame(ObFrame *self)
         }
         clear = ob_rr_theme->a_clear;
 
-        RrPaint(t, self->title, self->width, ob_rr_theme->title_height);
+        framerender_element(self, t, self->title, TITLE_X(self),
+                            TITLE_Y(self), self->width,
+                            ob_rr_theme->title_height);
 
-        clear->surface.parent = t;
-        clear->surface.parenty = 0;
+        /* composed frames have no resize windows in the titlebar to fill */
+        if (!self->composed) {
+            clear->surface.parent = t;
+            clear->surface.parenty = 0;
 
-        clear->surface.parentx = ob_rr_theme->grip_width;
+            clear->surface.parentx = ob_rr_theme->grip_width;
 
-        RrPaint(clear, self->topresize,
-                self->width - ob_rr_theme->grip_width * 2,
-                ob_rr_theme->paddingy + 1);
+            RrPaintCached(ob_rr_frame_cache, clear, self->topresize,
+                          self->width - ob_rr_theme->grip_width * 2,
+                          ob_rr_theme->paddingy + 1);
 
-        clear->surface.parentx = 0;
+            clear->surface.parentx = 0;
 
-        if (ob_rr_theme->grip_width > 0)
-            RrPaint(clear, self->tltresize,
-                    ob_rr_theme->grip_width, ob_rr_theme->paddingy + 1);
-        if (ob_rr_theme->title_height > 0)
-            RrPaint(clear, self->tllresize,
-                    ob_rr_theme->paddingx + 1, ob_rr_theme->title_height);
+            if (ob_rr_theme->grip_width > 0)
+                RrPaintCached(ob_rr_frame_cache, clear, self->tltresize,
+                              ob_rr_theme->grip_width,
+                              ob_rr_theme->paddingy + 1);
+            if (ob_rr_theme->title_height > 0)
+                RrPaintCached(ob_rr_frame_cache, clear, self->tllresize,
+                              ob_rr_theme->paddingx + 1,
+                              ob_rr_theme->title_height);
 
-        clear->surface.parentx = self->width - ob_rr_theme->grip_width;
+            clear->surface.parentx = self->width - ob_rr_theme->grip_width;
 
-        if (ob_rr_theme->grip_width > 0)
-            RrPaint(clear, self->trtresize,
-                    ob_rr_theme->grip_width, ob_rr_theme->paddingy + 1);
+            if (ob_rr_theme->grip_width > 0)
+                RrPaintCached(ob_rr_frame_cache, clear, self->trtresize,
+                              ob_rr_theme->grip_width,
+                              ob_rr_theme->paddingy + 1);
 
-        clear->surface.parentx = self->width - (ob_rr_theme->paddingx + 1);
+            clear->surface.parentx =
+                self->width - (ob_rr_theme->paddingx + 1);
 
-        if (ob_rr_theme->title_height > 0)
-            RrPaint(clear, self->trrresize,
-                    ob_rr_theme->paddingx + 1, ob_rr_theme->title_height);
+            if (ob_rr_theme->title_height > 0)
+                RrPaintCached(ob_rr_frame_cache, clear, self->trrresize,
+                              ob_rr_theme->paddingx + 1,
+                              ob_rr_theme->title_height);
+        }
 
         /* set parents for any parent relative guys */
         l->surface.parent = t;
@@ -312,6 +337,16 @@ void framerender_frame(ObFrame *self)
         framerender_desk(self, d);
         framerender_shade(self, s);
         framerender_close(self, c);
+
+        /* the separator under the titlebar, which is the border's color
+           already when the window is shaded */
+        if (self->composed && self->bwidth && !self->client->shaded)
+            compose_fill(self, (self->focused ?
+                                ob_rr_theme->title_separator_focused_color :
+                                ob_rr_theme->title_separator_unfocused_color),
+                         TITLE_X(self),
+                         TITLE_Y(self) + ob_rr_theme->title_height,
+                         self->width, self->bwidth);
     }
 
     if (self->decorations & OB_FRAME_DECOR_HANDLE &&
@@ -322,7 +357,9 @@ void framerender_frame(ObFrame *self)
         h = (self->focused ?
              ob_rr_theme->a_focused_handle : ob_rr_theme->a_unfocused_handle);
 
-        RrPaint(h, self->handle, self->width, ob_rr_theme->handle_height);
+        framerender_element(self, h, self->handle, HANDLE_X(self),
+                            HANDLE_Y(self), self->width,
+                            ob_rr_theme->handle_height);
 
         if (self->decorations & OB_FRAME_DECOR_GRIPS) {
             g = (self->focused ?
@@ -334,17 +371,44 @@ void framerender_frame(ObFrame *self)
             g->surface.parentx = 0;
             g->surface.parenty = 0;
 
-            RrPaint(g, self->lgrip,
-                    ob_rr_theme->grip_width, ob_rr_theme->handle_height);
+            framerender_element(self, g, self->lgrip, HANDLE_X(self),
+                                HANDLE_Y(self), ob_rr_theme->grip_width,
+                                ob_rr_theme->handle_height);
 
             g->surface.parentx = self->width - ob_rr_theme->grip_width;
             g->surface.parenty = 0;
 
-            RrPaint(g, self->rgrip,
-                    ob_rr_theme->grip_width, ob_rr_theme->handle_height);
+            framerender_element(self, g, self->rgrip,
+                                HANDLE_X(self) + g->surface.parentx,
+                                HANDLE_Y(self), ob_rr_theme->grip_width,
+                                ob_rr_theme->handle_height);
+
+            if (self->composed && self->bwidth) {
+                /* the lines between the grips and the handle */
+                RrColor *bc = (self->focused ?
+                    (self->client->undecorated ?
+                     ob_rr_theme->frame_undecorated_focused_border_color :
+                     ob_rr_theme->frame_focused_border_color) :
+                    (self->client->undecorated ?
+                     ob_rr_theme->frame_undecorated_unfocused_border_color :
+                     ob_rr_theme->frame_unfocused_border_color));
+
+                compose_fill(self, bc,
+                             HANDLE_X(self) + ob_rr_theme->grip_width,
+                             HANDLE_Y(self), self->bwidth,
+                             ob_rr_theme->handle_height);
+                compose_fill(self, bc,
+                             HANDLE_X(self) + self->width -
+                             ob_rr_theme->grip_width - self->bwidth,
+                             HANDLE_Y(self), self->bwidth,
+                             ob_rr_theme->handle_height);
+            }
         }
     }
 
+    if (self->composed)
+        compose_end(self);
+
     XFlush(obt_display);
 }
 
@@ -353,7 +417,10 @@ static void framerender_label(ObFrame *self, RrAppearance *a)
     if (!self->label_on) return;
     /* set the texture's text! */
     a->texture[0].data.text.string = self->client->title;
-    RrPaint(a, self->label, self->label_width, ob_rr_theme->label_height);
+    framerender_element(self, a, self->label,
+                        TITLE_X(self) + self->label_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy,
+                        self->label_width, ob_rr_theme->label_height);
 }
 
 static void framerender_icon(ObFrame *self, RrAppearance *a)
@@ -374,39 +441,129 @@ static void framerender_icon(ObFrame *self, RrAppearance *a)
         a->texture[0].type = RR_TEXTURE_NONE;
     }
 
-    RrPaint(a, self->icon,
-            ob_rr_theme->button_size + 2, ob_rr_theme->button_size + 2);
+    framerender_element(self, a, self->icon,
+                        TITLE_X(self) + self->icon_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy,
+                        ob_rr_theme->button_size + 2,
+                        ob_rr_theme->button_size + 2);
 }
 
 static void framerender_max(ObFrame *self, RrAppearance *a)
 {
     if (!self->max_on) return;
-    RrPaint(a, self->max, ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_element(self, a, self->max,
+                        TITLE_X(self) + self->max_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy + 1,
+                        ob_rr_theme->button_size, ob_rr_theme->button_size);
 }
 
 static void framerender_iconify(ObFrame *self, RrAppearance *a)
 {
     if (!self->iconify_on) return;
-    RrPaint(a, self->iconify,
-            ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_element(self, a, self->iconify,
+                        TITLE_X(self) + self->iconify_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy + 1,
+                        ob_rr_theme->button_size, ob_rr_theme->button_size);
 }
 
 static void framerender_desk(ObFrame *self, RrAppearance *a)
 {
     if (!self->desk_on) return;
-    RrPaint(a, self->desk, ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_element(self, a, self->desk,
+                        TITLE_X(self) + self->desk_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy + 1,
+                        ob_rr_theme->button_size, ob_rr_theme->button_size);
 }
 
 static void framerender_shade(ObFrame *self, RrAppearance *a)
 {
     if (!self->shade_on) return;
-    RrPaint(a, self->shade,
-            ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_element(self, a, self->shade,
+                        TITLE_X(self) + self->shade_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy + 1,
+                        ob_rr_theme->button_size, ob_rr_theme->button_size);
 }
 
 static void framerender_close(ObFrame *self, RrAppearance *a)
 {
     if (!self->close_on) return;
-    RrPaint(a, self->close,
-            ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_element(self, a, self->close,
+                        TITLE_X(self) + self->close_x,
+                        TITLE_Y(self) + ob_rr_theme->paddingy + 1,
+                        ob_rr_theme->button_size, ob_rr_theme->button_size);
+}
+
+/*! Paints a piece of the frame. Frames made of windows paint it into its
+  window, and composed frames copy it into their pixmap at x, y. */
+static void framerender_element(ObFrame *self, RrAppearance *a, Window win,
+                                gint x, gint y, gint w, gint h)
+{
+    Pixmap p;
+
+    if (!self->composed) {
+        RrPaintCached(ob_rr_frame_cache, a, win, w, h);
+        return;
+    }
+
+    if ((p = RrPaintCachedPixmap(ob_rr_frame_cache, a, w, h)))
+        XCopyArea(obt_display, p, self->pixmap, self->gc, 0, 0, w, h, x, y);
+}
+
+static void compose_fill(ObFrame *self, RrColor *color,
+                         gint x, gint y, gint w, gint h)
+{
+    if (w <= 0 || h <= 0) return;
+    XSetForeground(obt_display, self->gc, RrColorPixel(color));
+    XFillRectangle(obt_display, self->pixmap, self->gc, x, y, w, h);
+}
+
+/*! Gets the frame's pixmap ready to draw into, and fills in the borders */
+static void compose_begin(ObFrame *self)
+{
+    const gint w = MAX(self->area.width, 1), h = MAX(self->area.height, 1);
+
+    if (self->pixmap && (self->pixmap_w != w || self->pixmap_h != h)) {
+        XFreePixmap(obt_display, self->pixmap);
+        self->pixmap = None;
+    }
+    if (!self->pixmap) {
+        self->pixmap = XCreatePixmap(obt_display, self->window, w, h,
+                                     RrDepth(ob_rr_inst));
+        self->pixmap_w = w;
+        self->pixmap_h = h;
+    }
+
+    /* the outer border goes everywhere that nothing else is drawn */
+    compose_fill(self, (self->focused ?
+                        (self->client->undecorated ?
+                         ob_rr_theme->frame_undecorated_focused_border_color :
+                         ob_rr_theme->frame_focused_border_color) :
+                        (self->client->undecorated ?
+                         ob_rr_theme->frame_undecorated_unfocused_border_color :
+                         ob_rr_theme->frame_unfocused_border_color)),
+                 0, 0, w, h);
+    /* and the inner border surrounds the client */
+    compose_fill(self, (self->focused ?
+                        ob_rr_theme->cb_focused_color :
+                        ob_rr_theme->cb_unfocused_color),
+                 self->size.left - self->cbwidth_l,
+                 self->size.top - self->cbwidth_t,
+                 self->client->area.width + self->cbwidth_l +
+                 self->cbwidth_r,
+                 self->client->area.height + self->cbwidth_t +
+                 self->cbwidth_b);
+
+    /* backback shows while the client catches up with a resize */
+    XSetWindowBackground(obt_display, self->backback,
+                         RrColorPixel(self->focused ?
+                                      ob_rr_theme->cb_focused_color :
+                                      ob_rr_theme->cb_unfocused_color));
+    XClearWindow(obt_display, self->backback);
+}
+
+/*! Shows what was drawn into the frame's pixmap */
+static void compose_end(ObFrame *self)
+{
+    XSetWindowBackgroundPixmap(obt_display, self->window, self->pixmap);
+    XClearWindow(obt_display, self->window);
 }
@@ -37,6 +37,8 @@
 #include "obt/xml.h"
 #include "obt/paths.h"
 
+#include <sys/stat.h>
+
 typedef struct _ObMenuParseState ObMenuParseState;
 
 struct _ObMenuParseState
@@ -45,7 +47,35 @@ struct _ObMenuParseState
     ObMenu *pipe_creator;
 };
 
+typedef struct _ObMenuPipe ObMenuPipe;
+
+struct _ObMenuPipe
+{
+    ObMenu *menu;
+    GIOChannel *channel;
+    guint watch;
+    ObtXmlPush *parser;
+    /* set when the output is found to not be valid xml */
+    gboolean bad;
+    /* the entry shown in the menu until the command is done */
+    ObMenuEntry *loading;
+};
+
+/*! A menu file which was loaded, to tell later if it has changed */
+typedef struct _ObMenuFile ObMenuFile;
+
+struct _ObMenuFile
+{
+    gchar *path;
+    time_t mtime;
+    off_t size;
+};
+
 static GHashTable *menu_hash = NULL;
+/*! The ObMenuFiles the menus were loaded from */
+static GSList *menu_files = NULL;
+/*! Set when a menu file could not be loaded */
+static gboolean menu_files_missing = FALSE;
 static ObtXmlInst *menu_parse_inst;
 static ObMenuParseState menu_parse_state;
 static gboolean menu_can_hide = FALSE;
@@ -59,6 +89,37 @@ static gunichar parse_shortcut(const gchar *label, gboolean allow_shortcut,
                                gchar **strippedlabel, guint *position,
                                gboolean *always_show);
 
+static void menu_file_loaded(ObtXmlInst *i)
+{
+    ObMenuFile *f;
+    struct stat st;
+
+    if (!obt_xml_path(i) || stat(obt_xml_path(i), &st) != 0) return;
+
+    f = g_slice_new(ObMenuFile);
+    f->path = g_strdup(obt_xml_path(i));
+    f->mtime = st.st_mtime;
+    f->size = st.st_size;
+    menu_files = g_slist_prepend(menu_files, f);
+}
+
+gboolean menu_files_changed(void)
+{
+    GSList *it;
+
+    if (menu_files_missing) return TRUE;
+
+    for (it = menu_files; it; it = g_slist_next(it)) {
+        ObMenuFile *f = it->data;
+        struct stat st;
+
+        if (stat(f->path, &st) != 0 ||
+            st.st_mtime != f->mtime || st.st_size != f->size)
+            return TRUE;
+    }
+    return FALSE;
+}
+
 void menu_startup(gboolean reconfig)
 {
     gboolean loaded = FALSE;
@@ -88,6 +149,7 @@ void menu_startup(gboolean reconfig)
                                      "openbox_menu"))
         {
             loaded = TRUE;
+            menu_file_loaded(menu_parse_inst);
             obt_xml_tree_from_root(menu_parse_inst);
             obt_xml_close(menu_parse_inst);
         }
@@ -96,12 +158,15 @@ void menu_startup(gboolean reconfig)
                                    "openbox_menu"))
         {
             loaded = TRUE;
+            menu_file_loaded(menu_parse_inst);
             obt_xml_tree_from_root(menu_parse_inst);
             obt_xml_close(menu_parse_inst);
         }
-        else
+        else {
+            menu_files_missing = TRUE;
             g_message(_("Unable to find a valid menu file \"%s\""),
                       (const gchar*)it->data);
+        }
     }
     if (!loaded) {
         if (obt_xml_load_config_file(menu_parse_inst,
@@ -109,11 +174,14 @@ void menu_startup(gboolean reconfig)
                                      "menu.xml",
                                      "openbox_menu"))
         {
+            menu_file_loaded(menu_parse_inst);
             obt_xml_tree_from_root(menu_parse_inst);
             obt_xml_close(menu_parse_inst);
-        } else
+        } else {
+            menu_files_missing = TRUE;
             g_message(_("Unable to find a valid menu file \"%s\""),
                       "menu.xml");
+        }
     }
 
     g_assert(menu_parse_state.parent == NULL);
@@ -124,6 +192,14 @@ void menu_shutdown(gboolean reconfig)
     obt_xml_instance_unref(menu_parse_inst);
     menu_parse_inst = NULL;
 
+    while (menu_files) {
+        ObMenuFile *f = menu_files->data;
+        g_free(f->path);
+        g_slice_free(ObMenuFile, f);
+        menu_files = g_slist_delete_link(menu_files, menu_files);
+    }
+    menu_files_missing = FALSE;
+
     menu_frame_hide_all();
 
     client_list_combined_menu_shutdown(reconfig);
@@ -133,56 +209,169 @@ void menu_shutdown(gboolean reconfig)
     menu_hash = NULL;
 }
 
-static gboolean menu_pipe_submenu(gpointer key, gpointer val, gpointer data)
+static gboolean menu_cache_expired(ObMenu *menu)
+{
+    GTimeVal now;
+
+    if (menu->cache_timeout < 0) return FALSE;
+    if (menu->cache_timeout == 0) return TRUE;
+
+    g_get_current_time(&now);
+    /* if the clock went backwards then we can't tell how old it is */
+    return (now.tv_sec < menu->cache_time.tv_sec ||
+            now.tv_sec - menu->cache_time.tv_sec >= menu->cache_timeout);
+}
+
+void menu_clear_pipe_caches(void)
+{
+    GList *menus, *it;
+    GSList *expired = NULL, *doomed = NULL, *sit;
+
+    menus = g_hash_table_get_values(menu_hash);
+
+    for (it = menus; it; it = g_list_next(it)) {
+        ObMenu *menu = it->data;
+
+        /* leave menus alone while their command is still running */
+        if (menu->execute && menu->entries && !menu->pipe &&
+            menu_cache_expired(menu))
+            expired = g_slist_prepend(expired, menu);
+    }
+
+    /* find the submenus made by the expired pipe-menus, and by pipe-menus
+       inside of them.  gather them all up first, since the pipe_creator
+       pointers can't be followed once the menus start going away */
+    for (it = menus; it; it = g_list_next(it)) {
+        ObMenu *menu = it->data, *c;
+
+        for (c = menu->pipe_creator; c; c = c->pipe_creator)
+            if (g_slist_find(expired, c)) {
+                doomed = g_slist_prepend(doomed, menu);
+                break;
+            }
+    }
+
+    /* empty the expired pipe menus */
+    for (sit = expired; sit; sit = g_slist_next(sit))
+        if (!g_slist_find(doomed, sit->data))
+            menu_clear_entries(sit->data);
+    /* delete their submenus */
+    for (sit = doomed; sit; sit = g_slist_next(sit))
+        menu_free(sit->data);
+
+    g_list_free(menus);
+    g_slist_free(expired);
+    g_slist_free(doomed);
+}
+
+static void menu_pipe_free(ObMenuPipe *p)
 {
-    ObMenu *menu = val;
-    return menu->pipe_creator != NULL;
+    p->menu->pipe = NULL;
+
+    if (p->watch) g_source_remove(p->watch);
+    g_io_channel_unref(p->channel);
+    obt_xml_push_free(p->parser);
+    g_slice_free(ObMenuPipe, p);
 }
 
-static void clear_cache(gpointer key, gpointer val, gpointer data)
+static void menu_pipe_finish(ObMenuPipe *p)
 {
-    ObMenu *menu = val;
-    if (menu->execute)
-        menu_clear_entries(menu);
+    ObMenu *self = p->menu;
+    GList *it;
+
+    /* take out the placeholder, a visible frame may still have it */
+    menu_entry_remove(p->loading);
+    self->more_menu->entries = self->entries; /* keep it in sync */
+
+    if (!p->bad && obt_xml_load_push(menu_parse_inst, p->parser,
+                                     "openbox_pipe_menu"))
+    {
+        menu_parse_state.pipe_creator = self;
+        menu_parse_state.parent = self;
+        obt_xml_tree_from_root(menu_parse_inst);
+        obt_xml_close(menu_parse_inst);
+    } else {
+        g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
+    }
+    g_get_current_time(&self->cache_time);
+
+    /* show the new entries in place of the placeholder.  this is done before
+       letting go of the pipe so that an empty menu won't run it again */
+    for (it = menu_frame_visible; it; it = g_list_next(it)) {
+        ObMenuFrame *f = it->data;
+        if (f->menu == self)
+            menu_frame_refresh(f);
+    }
+
+    menu_pipe_free(p);
 }
 
-void menu_clear_pipe_caches(void)
+static gboolean menu_pipe_read(GIOChannel *source, GIOCondition cond,
+                               gpointer data)
 {
-    /* delete any pipe menus' submenus */
-    g_hash_table_foreach_remove(menu_hash, menu_pipe_submenu, NULL);
-    /* empty the top level pipe menus */
-    g_hash_table_foreach(menu_hash, clear_cache, NULL);
+    ObMenuPipe *p = data;
+    gchar buf[4096];
+    gsize n = 0;
+    GIOStatus st;
+
+    /* read one buffer at a time, so that a command with a lot to say doesn't
+       keep us from doing anything else */
+    st = g_io_channel_read_chars(source, buf, sizeof(buf), &n, NULL);
+    if (n && !p->bad)
+        p->bad = !obt_xml_push_chunk(p->parser, buf, n);
+
+    if (st == G_IO_STATUS_NORMAL || st == G_IO_STATUS_AGAIN)
+        return TRUE; /* wait for more */
+
+    /* the command is done, or broke */
+    p->watch = 0;
+    menu_pipe_finish(p);
+    return FALSE; /* remove the source */
 }
 
 void menu_pipe_execute(ObMenu *self)
 {
-    gchar *output;
+    ObMenuPipe *p;
+    gchar **argv = NULL;
+    gint out;
     GError *err = NULL;
 
     if (!self->execute)
         return;
     if (self->entries) /* the entries are already created and cached */
         return;
+    if (self->pipe) /* the command is already running */
+        return;
 
-    if (!g_spawn_command_line_sync(self->execute, &output, NULL, NULL, &err)) {
+    if (!g_shell_parse_argv(self->execute, NULL, &argv, &err) ||
+        !g_spawn_async_with_pipes(NULL, argv, NULL, G_SPAWN_SEARCH_PATH,
+                                  NULL, NULL, NULL, NULL, &out, NULL, &err))
+    {
         g_message(_("Failed to execute command for pipe-menu \"%s\": %s"),
                   self->execute, err->message);
         g_error_free(err);
+        g_strfreev(argv);
         return;
     }
+    g_strfreev(argv);
 
-    if (obt_xml_load_mem(menu_parse_inst, output, strlen(output),
-                         "openbox_pipe_menu"))
-    {
-        menu_parse_state.pipe_creator = self;
-        menu_parse_state.parent = self;
-        obt_xml_tree_from_root(menu_parse_inst);
-        obt_xml_close(menu_parse_inst);
-    } else {
-        g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
-    }
+    p = g_slice_new(ObMenuPipe);
+    p->menu = self;
+    p->parser = obt_xml_push_new();
+    p->bad = FALSE;
+
+    p->channel = g_io_channel_unix_new(out);
+    g_io_channel_set_close_on_unref(p->channel, TRUE);
+    g_io_channel_set_encoding(p->channel, NULL, NULL);
+    g_io_channel_set_flags(p->channel, G_IO_FLAG_NONBLOCK, NULL);
+    p->watch = g_io_add_watch(p->channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                              menu_pipe_read, p);
+
+    /* show something in the menu until the command is done */
+    p->loading = menu_add_normal(self, -1, _("Loading..."), NULL, FALSE);
+    p->loading->data.normal.enabled = FALSE;
 
-    g_free(output);
+    self->pipe = p;
 }
 
 static ObMenu* menu_from_name(gchar *name)
@@ -350,6 +539,7 @@ static void parse_menu(xmlNodePtr node, gpointer data)
             menu->pipe_creator = state->pipe_creator;
             if (obt_xml_attr_string(node, "execute", &script)) {
                 menu->execute = obt_paths_expand_tilde(script);
+                obt_xml_attr_int(node, "cache", &menu->cache_timeout);
             } else {
                 ObMenu *old;
 
@@ -434,6 +624,8 @@ static void menu_destroy_hash_value(ObMenu *self)
     if (self->destroy_func)
         self->destroy_func(self, self->data);
 
+    if (self->pipe)
+        menu_pipe_free(self->pipe);
     menu_clear_entries(self);
     g_free(self->name);
     g_free(self->title);
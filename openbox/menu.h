@@ -28,6 +28,7 @@
 struct _ObClient;
 struct _ObMenuFrame;
 struct _ObMenuEntryFrame;
+struct _ObMenuPipe;
 
 typedef struct _ObMenu ObMenu;
 typedef struct _ObMenuEntry ObMenuEntry;
@@ -74,6 +75,13 @@ struct _ObMenu
 
     /* Command to execute to rebuild the menu */
     gchar *execute;
+    /* Seconds to keep the entries made by execute for.  0 rebuilds them each
+       time a menu is shown, and less than 0 keeps them until reconfigure */
+    gint cache_timeout;
+    /* When the entries were made by execute */
+    GTimeVal cache_time;
+    /* The running command which is building the menu, or NULL */
+    struct _ObMenuPipe *pipe;
 
     /* ObMenuEntry list */
     GList *entries;
@@ -167,6 +175,10 @@ struct _ObMenuEntry
 void menu_startup(gboolean reconfig);
 void menu_shutdown(gboolean reconfig);
 
+/*! Returns TRUE if any of the files the menus were loaded from have changed,
+  or could not be loaded */
+gboolean menu_files_changed(void);
+
 void menu_entry_ref(ObMenuEntry *self);
 void menu_entry_unref(ObMenuEntry *self);
 
@@ -174,9 +186,11 @@ ObMenu* menu_new(const gchar *name, const gchar *title,
                  gboolean allow_shortcut_selection, gpointer data);
 void menu_free(ObMenu *menu);
 
-/*! Repopulate a pipe-menu by running its command */
+/*! Repopulate a pipe-menu by running its command.  The command runs in the
+  background, and the menu shows a placeholder entry until it finishes */
 void menu_pipe_execute(ObMenu *self);
-/*! Clear a pipe-menu's entries */
+/*! Clear the entries of pipe-menus which have been kept for longer than their
+  cache timeout */
 void menu_clear_pipe_caches(void);
 
 void menu_show_all_shortcuts(ObMenu *self, gboolean show);
@@ -45,6 +45,9 @@ GList *menu_frame_visible;
 GHashTable *menu_frame_map;
 
 static RrAppearance *a_sep;
+/*! Entry frames which are not in use, and whose windows are kept to be used
+  for the next entry frames that are made */
+static GSList *spare_entries = NULL;
 static guint submenu_show_timer = 0;
 static guint submenu_hide_timer = 0;
 
@@ -100,6 +103,15 @@ void menu_frame_shutdown(gboolean reconfig)
 {
     RrAppearanceFree(a_sep);
 
+    while (spare_entries) {
+        ObMenuEntryFrame *e = spare_entries->data;
+
+        /* this destroys all of its windows */
+        XDestroyWindow(obt_display, e->window);
+        g_slice_free(ObMenuEntryFrame, e);
+        spare_entries = g_slist_delete_link(spare_entries, spare_entries);
+    }
+
     if (reconfig) return;
 
     client_remove_destroy_notify(client_dest);
@@ -169,31 +181,45 @@ static ObMenuEntryFrame* menu_entry_frame_new(ObMenuEntry *entry,
                                               ObMenuFrame *frame)
 {
     ObMenuEntryFrame *self;
-    XSetWindowAttributes attr;
 
-    self = g_slice_new0(ObMenuEntryFrame);
+    if (spare_entries) {
+        /* reuse the windows from an entry frame that has gone away */
+        self = spare_entries->data;
+        spare_entries = g_slist_delete_link(spare_entries, spare_entries);
+
+        XReparentWindow(obt_display, self->window, frame->window, 0, 0);
+    }
+    else {
+        XSetWindowAttributes attr;
+
+        self = g_slice_new(ObMenuEntryFrame);
+
+        attr.event_mask = ENTRY_EVENTMASK;
+        self->window = createWindow(frame->window, CWEventMask, &attr);
+        self->text = createWindow(self->window, 0, NULL);
+        /* every entry frame has an icon and a bullet, so that its windows
+           can be used for any type of entry.  they are only mapped when the
+           entry shows them */
+        self->icon = createWindow(self->window, 0, NULL);
+        self->bullet = createWindow(self->window, 0, NULL);
+
+        XMapWindow(obt_display, self->text);
+    }
+
     self->entry = entry;
     self->frame = frame;
+    self->ignore_enters = 0;
+    RECT_SET(self->area, 0, 0, 0, 0);
+    self->border = 0;
 
     menu_entry_ref(entry);
 
-    attr.event_mask = ENTRY_EVENTMASK;
-    self->window = createWindow(self->frame->window, CWEventMask, &attr);
-    self->text = createWindow(self->window, 0, NULL);
     g_hash_table_insert(menu_frame_map, &self->window, self);
     g_hash_table_insert(menu_frame_map, &self->text, self);
-    if ((entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
-        (entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
-        self->icon = createWindow(self->window, 0, NULL);
-        g_hash_table_insert(menu_frame_map, &self->icon, self);
-    }
-    if (entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
-        self->bullet = createWindow(self->window, 0, NULL);
-        g_hash_table_insert(menu_frame_map, &self->bullet, self);
-    }
+    g_hash_table_insert(menu_frame_map, &self->icon, self);
+    g_hash_table_insert(menu_frame_map, &self->bullet, self);
 
     XMapWindow(obt_display, self->window);
-    XMapWindow(obt_display, self->text);
 
     window_add(&self->window, MENUFRAME_AS_WINDOW(self->frame));
 
@@ -205,22 +231,22 @@ static void menu_entry_frame_free(ObMenuEntryFrame *self)
     if (self) {
         window_remove(self->window);
 
-        XDestroyWindow(obt_display, self->text);
-        XDestroyWindow(obt_display, self->window);
         g_hash_table_remove(menu_frame_map, &self->text);
         g_hash_table_remove(menu_frame_map, &self->window);
-        if ((self->entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
-            (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
-            XDestroyWindow(obt_display, self->icon);
-            g_hash_table_remove(menu_frame_map, &self->icon);
-        }
-        if (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
-            XDestroyWindow(obt_display, self->bullet);
-            g_hash_table_remove(menu_frame_map, &self->bullet);
-        }
+        g_hash_table_remove(menu_frame_map, &self->icon);
+        g_hash_table_remove(menu_frame_map, &self->bullet);
+
+        /* keep the windows for another entry frame.  they are taken out of
+           the menu frame's window, which may be destroyed along with
+           everything inside it */
+        XUnmapWindow(obt_display, self->window);
+        XReparentWindow(obt_display, self->window, obt_root(ob_screen), 0, 0);
 
         menu_entry_unref(self->entry);
-        g_slice_free(ObMenuEntryFrame, self);
+        self->entry = NULL;
+        self->frame = NULL;
+
+        spare_entries = g_slist_prepend(spare_entries, self);
     }
 }
 
@@ -630,7 +656,7 @@ static void menu_entry_frame_render(ObMenuEntryFrame *self)
 
 /*! this code is taken from the menu_frame_render. if that changes, this won't
   work.. */
-static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
+static gint menu_entry_frame_get_height(ObMenuEntry *entry,
                                         gboolean first_entry,
                                         gboolean last_entry)
 {
@@ -639,8 +665,8 @@ static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
 
     h += 2*PADDING;
 
-    if (self)
-        t = self->entry->type;
+    if (entry)
+        t = entry->type;
     else
         /* this is the More... entry, it's NORMAL type */
         t = OB_MENU_ENTRY_TYPE_NORMAL;
@@ -651,7 +677,7 @@ static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
         h += ob_rr_theme->menu_font_height;
         break;
     case OB_MENU_ENTRY_TYPE_SEPARATOR:
-        if (self->entry->data.separator.label != NULL) {
+        if (entry->data.separator.label != NULL) {
             h += ob_rr_theme->menu_title_height +
                 (ob_rr_theme->mbwidth - PADDING) * 2;
 
@@ -850,106 +876,93 @@ void menu_frame_render(ObMenuFrame *self)
 
 static void menu_frame_update(ObMenuFrame *self)
 {
-    GList *mit, *fit;
+    GList *mit, *start;
     const Rect *a;
-    gint h;
+    gint h, more_h, n, n_fit;
 
     menu_pipe_execute(self->menu);
     menu_find_submenus(self->menu);
 
     self->selected = NULL;
 
-    /* start at show_from */
-    mit = g_list_nth(self->menu->entries, self->show_from);
-
-    /* go through the menu's and frame's entries and connect the frame entries
-       to the menu entries */
-    for (fit = self->entries; mit && fit;
-         mit = g_list_next(mit), fit = g_list_next(fit))
-    {
-        ObMenuEntryFrame *f = fit->data;
-        f->entry = mit->data;
-    }
-
-    /* if there are more menu entries than in the frame, add them */
-    while (mit) {
-        ObMenuEntryFrame *e = menu_entry_frame_new(mit->data, self);
-        self->entries = g_list_append(self->entries, e);
-        mit = g_list_next(mit);
-    }
-
-    /* if there are more frame entries than menu entries then get rid of
-       them */
-    while (fit) {
-        GList *n = g_list_next(fit);
-        menu_entry_frame_free(fit->data);
-        self->entries = g_list_delete_link(self->entries, fit);
-        fit = n;
+    /* start over with new entry frames.  the old ones' windows are reused
+       for them */
+    while (self->entries) {
+        menu_entry_frame_free(self->entries->data);
+        self->entries = g_list_delete_link(self->entries, self->entries);
     }
 
     /* * make the menu fit on the screen */
 
-    /* calculate the height of the menu */
-    h = 0;
-    for (fit = self->entries; fit; fit = g_list_next(fit))
-        h += menu_entry_frame_get_height(fit->data,
-                                         fit == self->entries,
-                                         g_list_next(fit) == NULL);
-    /* add the border at the top and bottom */
-    h += ob_rr_theme->mbwidth * 2;
-
     a = screen_physical_area_monitor(self->monitor);
 
-    if (h > a->height) {
-        GList *flast, *tmp;
-        gboolean last_entry = TRUE;
-
-        /* take the height of our More... entry into account */
-        h += menu_entry_frame_get_height(NULL, FALSE, TRUE);
+    /* start at show_from */
+    start = g_list_nth(self->menu->entries, self->show_from);
+
+    /* count the entries that fit on the screen, without looking any further
+       than the screen is tall.  n_fit is how many of them fit along with a
+       More... entry, if they don't all fit */
+    more_h = menu_entry_frame_get_height(NULL, FALSE, TRUE);
+    /* the border at the top and bottom */
+    h = ob_rr_theme->mbwidth * 2;
+    n = n_fit = 0;
+    for (mit = start; mit; mit = g_list_next(mit)) {
+        h += menu_entry_frame_get_height(mit->data, mit == start,
+                                         g_list_next(mit) == NULL);
+        if (h > a->height)
+            break;
+        ++n;
+        if (h + more_h <= a->height)
+            n_fit = n;
+    }
 
-        /* start at the end of the entries */
-        flast = g_list_last(self->entries);
+    /* if they don't all fit, leave at least 1 though */
+    if (mit)
+        n = MAX(n_fit, 1);
 
-        /* pull out all the entries from the frame that don't
-           fit on the screen, leaving at least 1 though */
-        while (h > a->height && g_list_previous(flast) != NULL) {
-            /* update the height, without this entry */
-            h -= menu_entry_frame_get_height(flast->data, FALSE, last_entry);
+    /* make frames for the entries that are shown */
+    for (mit = start; mit && n; mit = g_list_next(mit), --n) {
+        ObMenuEntryFrame *e = menu_entry_frame_new(mit->data, self);
+        self->entries = g_list_prepend(self->entries, e);
+    }
+    self->entries = g_list_reverse(self->entries);
+
+    if (mit) {
+        ObMenuEntry *more_entry;
+        ObMenuEntryFrame *more_frame;
+        /* make the More... menu entry frame which will display in this
+           frame.
+           if self->menu->more_menu is NULL that means that this is already
+           More... menu, so just use ourself.
+        */
+        more_entry = menu_get_more((self->menu->more_menu ?
+                                    self->menu->more_menu :
+                                    self->menu),
+                                   /* continue where we left off */
+                                   self->show_from +
+                                   g_list_length(self->entries));
+        more_frame = menu_entry_frame_new(more_entry, self);
+        /* make it get deleted when the menu frame goes away */
+        menu_entry_unref(more_entry);
+
+        /* add our More... entry to the frame */
+        self->entries = g_list_append(self->entries, more_frame);
+    }
 
-            /* destroy the entry we're not displaying */
-            tmp = flast;
-            flast = g_list_previous(flast);
-            menu_entry_frame_free(tmp->data);
-            self->entries = g_list_delete_link(self->entries, tmp);
+    menu_frame_render(self);
+}
 
-            /* only the first one that we see is the last entry in the menu */
-            last_entry = FALSE;
-        };
+void menu_frame_refresh(ObMenuFrame *self)
+{
+    gint dx, dy;
 
-        {
-            ObMenuEntry *more_entry;
-            ObMenuEntryFrame *more_frame;
-            /* make the More... menu entry frame which will display in this
-               frame.
-               if self->menu->more_menu is NULL that means that this is already
-               More... menu, so just use ourself.
-            */
-            more_entry = menu_get_more((self->menu->more_menu ?
-                                        self->menu->more_menu :
-                                        self->menu),
-                                       /* continue where we left off */
-                                       self->show_from +
-                                       g_list_length(self->entries));
-            more_frame = menu_entry_frame_new(more_entry, self);
-            /* make it get deleted when the menu frame goes away */
-            menu_entry_unref(more_entry);
-
-            /* add our More... entry to the frame */
-            self->entries = g_list_append(self->entries, more_frame);
-        }
-    }
+    /* the menu's entries have been replaced, so its entry frames are made
+       over */
+    menu_frame_update(self);
 
-    menu_frame_render(self);
+    /* it may have grown off the screen */
+    menu_frame_move_on_screen(self, self->area.x, self->area.y, &dx, &dy);
+    menu_frame_move(self, self->area.x + dx, self->area.y + dy);
 }
 
 static gboolean menu_frame_is_visible(ObMenuFrame *self)
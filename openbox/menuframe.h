@@ -130,6 +130,9 @@ void menu_frame_hide_all(void);
 void menu_frame_hide_all_client(struct _ObClient *client);
 
 void menu_frame_render(ObMenuFrame *self);
+/*! Rebuild the frame after its menu's entries have changed while it is
+  shown */
+void menu_frame_refresh(ObMenuFrame *self);
 
 void menu_frame_select(ObMenuFrame *self, ObMenuEntryFrame *entry,
                        gboolean immediate);
@@ -0,0 +1,195 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   monitor_map.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "monitor_map.h"
+
+#include <stdlib.h>
+
+/* The edges of all the monitors cut the screen into a grid of cells.  Each
+   cell is either on no monitor, or it belongs to the first monitor that covers
+   it, counting in order of preference.  The cells that belong to a monitor are
+   the pixels that are counted for it and for no monitor after it, so no pixel
+   is ever counted twice, no matter how the monitors overlap. */
+
+typedef struct _ObMonitorCell ObMonitorCell;
+
+struct _ObMonitorCell {
+    Rect area;
+    /*! The monitor's place in the order of preference */
+    guint rank;
+};
+
+struct _ObMonitorMap {
+    guint n;
+    /*! The monitors, in the order they were given */
+    Rect *monitors;
+    /*! The monitors' indices in order of preference */
+    guint *order;
+    ObMonitorCell *cells;
+    guint ncells;
+    /*! Space to add up the pixels of a search belonging to each monitor */
+    glong *owned;
+};
+
+static int compare_ints(const void *a, const void *b)
+{
+    const gint ia = *(const gint*)a, ib = *(const gint*)b;
+    return ia < ib ? -1 : (ia > ib ? 1 : 0);
+}
+
+/*! Sorts the edges and removes the repeats, returning how many are left */
+static guint unique_edges(gint *edges, guint n)
+{
+    guint i, j;
+
+    if (n == 0) return 0;
+
+    qsort(edges, n, sizeof(gint), compare_ints);
+    for (i = j = 1; i < n; ++i)
+        if (edges[i] != edges[j-1])
+            edges[j++] = edges[i];
+    return j;
+}
+
+ObMonitorMap* monitor_map_new(const Rect *monitors, guint n, guint primary)
+{
+    ObMonitorMap *map;
+    gint *xs, *ys;
+    guint nx, ny, i, j, r;
+
+    map = g_slice_new(ObMonitorMap);
+    map->n = n;
+    map->monitors = g_memdup(monitors, n * sizeof(Rect));
+    map->order = g_new(guint, n);
+    map->owned = g_new(glong, n);
+
+    r = 0;
+    if (primary < n)
+        map->order[r++] = primary;
+    for (i = 0; i < n; ++i)
+        if (i != primary)
+            map->order[r++] = i;
+
+    xs = g_new(gint, n * 2);
+    ys = g_new(gint, n * 2);
+    for (i = nx = ny = 0; i < n; ++i) {
+        /* a monitor with no area never has any of a search on it */
+        if (monitors[i].width <= 0 || monitors[i].height <= 0) continue;
+        xs[nx++] = monitors[i].x;
+        xs[nx++] = monitors[i].x + monitors[i].width;
+        ys[ny++] = monitors[i].y;
+        ys[ny++] = monitors[i].y + monitors[i].height;
+    }
+    nx = unique_edges(xs, nx);
+    ny = unique_edges(ys, ny);
+
+    map->cells = g_new(ObMonitorCell, nx && ny ? (nx - 1) * (ny - 1) : 0);
+    map->ncells = 0;
+    for (j = 0; j + 1 < ny; ++j)
+        for (i = 0; i + 1 < nx; ++i) {
+            Rect cell;
+
+            RECT_SET(cell, xs[i], ys[j], xs[i+1] - xs[i], ys[j+1] - ys[j]);
+            for (r = 0; r < n; ++r)
+                if (RECT_CONTAINS_RECT(monitors[map->order[r]], cell)) {
+                    map->cells[map->ncells].area = cell;
+                    map->cells[map->ncells].rank = r;
+                    ++map->ncells;
+                    break;
+                }
+        }
+
+    g_free(xs);
+    g_free(ys);
+    return map;
+}
+
+void monitor_map_free(ObMonitorMap *map)
+{
+    if (map) {
+        g_free(map->monitors);
+        g_free(map->order);
+        g_free(map->cells);
+        g_free(map->owned);
+        g_slice_free(ObMonitorMap, map);
+    }
+}
+
+guint monitor_map_find(ObMonitorMap *map, const Rect *search)
+{
+    guint i, r;
+    guint mostpx_index = map->n;
+    glong mostpx = 0;
+    glong before;
+    guint closest_distance_index = map->n;
+    guint closest_distance = G_MAXUINT;
+
+    for (r = 0; r < map->n; ++r)
+        map->owned[r] = 0;
+    for (i = 0; i < map->ncells; ++i) {
+        const ObMonitorCell *cell = &map->cells[i];
+
+        if (RECT_INTERSECTS_RECT(cell->area, *search)) {
+            Rect on_cell;
+
+            RECT_SET_INTERSECTION(on_cell, cell->area, *search);
+            map->owned[cell->rank] += (glong)RECT_AREA(on_cell);
+        }
+    }
+
+    /* each monitor gets the pixels of the search that are on it, less all the
+       pixels that were counted for the monitors before it, whether they are on
+       this monitor or not */
+    before = 0;
+    for (r = 0; r < map->n; ++r) {
+        const Rect *monitor = &map->monitors[map->order[r]];
+        Rect on_monitor;
+        glong area;
+
+        if (!RECT_INTERSECTS_RECT(*monitor, *search)) continue;
+
+        RECT_SET_INTERSECTION(on_monitor, *monitor, *search);
+        area = (glong)RECT_AREA(on_monitor) - before;
+        if (area > mostpx) {
+            mostpx = area;
+            mostpx_index = map->order[r];
+        }
+        before += map->owned[r];
+    }
+
+    if (mostpx_index < map->n)
+        return mostpx_index;
+
+    /* none of the monitors have any of the search area on them, so use the
+       closest one.  an empty search can touch a monitor without having any
+       pixels on it, but that monitor is not a candidate. */
+    for (i = 0; i < map->n; ++i) {
+        guint distance;
+
+        if (RECT_INTERSECTS_RECT(map->monitors[i], *search)) continue;
+
+        distance = rect_manhatten_distance(map->monitors[i], *search);
+        if (distance < closest_distance) {
+            closest_distance = distance;
+            closest_distance_index = i;
+        }
+    }
+
+    g_assert(closest_distance_index < map->n);
+    return closest_distance_index;
+}
@@ -0,0 +1,45 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   monitor_map.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef ob__monitor_map_h
+#define ob__monitor_map_h
+
+#include "geom.h"
+
+#include <glib.h>
+
+/*! The monitors cut up into disjoint pieces, so that it can be found which
+  monitor holds the most of a rectangle without counting any pixel twice */
+typedef struct _ObMonitorMap ObMonitorMap;
+
+/*! Build a map of the monitors.
+  @monitors An array of @n monitor areas
+  @primary The monitor which is counted first, and so is preferred where
+           monitors overlap. Can be @n or more for none.
+*/
+ObMonitorMap* monitor_map_new(const Rect *monitors, guint n, guint primary);
+void monitor_map_free(ObMonitorMap *map);
+
+/*! Returns the monitor which has the most of the @search area on it, where
+  any part of it that is on more than one monitor only counts for the first.
+  Monitors are counted in order, with the primary monitor first.  If no monitor
+  has any of @search on it, the closest monitor is returned.  This does not
+  allocate any memory. */
+guint monitor_map_find(ObMonitorMap *map, const Rect *search);
+
+#endif
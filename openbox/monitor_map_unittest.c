@@ -0,0 +1,195 @@
+#include "obt/unittest_base.h"
+
+#include "openbox/monitor_map.h"
+
+#include <glib.h>
+
+/* screen_find_monitor used to count the pixels on each monitor by adding and
+   subtracting the overlaps of everything it had counted so far.  This is that
+   algorithm, to check the map against. */
+
+typedef struct {
+    Rect r;
+    gboolean subtract;
+} RefRectArithmetic;
+
+static guint ref_find(const Rect* monitors, guint n, guint primary,
+                      const Rect* search)
+{
+    guint i;
+    guint mostpx_index = n;
+    glong mostpx = 0;
+    guint closest_distance_index = n;
+    guint closest_distance = G_MAXUINT;
+    GSList *counted = NULL, *it;
+
+    if (primary < n && RECT_INTERSECTS_RECT(monitors[primary], *search)) {
+        RefRectArithmetic* ra = g_new(RefRectArithmetic, 1);
+        RECT_SET_INTERSECTION(ra->r, monitors[primary], *search);
+        ra->subtract = TRUE;
+        if (RECT_AREA(ra->r) > mostpx) {
+            mostpx = RECT_AREA(ra->r);
+            mostpx_index = primary;
+        }
+        counted = g_slist_prepend(counted, ra);
+    }
+
+    for (i = 0; i < n; ++i) {
+        Rect on_current_monitor;
+        glong area;
+
+        if (!RECT_INTERSECTS_RECT(monitors[i], *search)) {
+            guint distance = rect_manhatten_distance(monitors[i], *search);
+            if (distance < closest_distance) {
+                closest_distance = distance;
+                closest_distance_index = i;
+            }
+            continue;
+        }
+        if (i == primary)
+            continue;
+
+        RECT_SET_INTERSECTION(on_current_monitor, monitors[i], *search);
+        area = RECT_AREA(on_current_monitor);
+        for (it = counted; it; it = g_slist_next(it)) {
+            RefRectArithmetic* ra = it->data;
+            Rect intersection;
+            RECT_SET_INTERSECTION(intersection, ra->r, *search);
+            if (ra->subtract) area -= RECT_AREA(intersection);
+            else area += RECT_AREA(intersection);
+        }
+        if (area > mostpx) {
+            mostpx = area;
+            mostpx_index = i;
+        }
+
+        for (it = counted; it; it = g_slist_next(it)) {
+            RefRectArithmetic* saved = it->data;
+            if (!RECT_INTERSECTS_RECT(saved->r, on_current_monitor))
+                continue;
+            RefRectArithmetic* reverse = g_new(RefRectArithmetic, 1);
+            RECT_SET_INTERSECTION(reverse->r, saved->r, on_current_monitor);
+            reverse->subtract = !saved->subtract;
+            counted = g_slist_prepend(counted, reverse);
+        }
+        RefRectArithmetic* ra = g_new(RefRectArithmetic, 1);
+        ra->r = on_current_monitor;
+        ra->subtract = TRUE;
+        counted = g_slist_prepend(counted, ra);
+    }
+
+    while (counted) {
+        g_free(counted->data);
+        counted = g_slist_delete_link(counted, counted);
+    }
+
+    return mostpx_index < n ? mostpx_index : closest_distance_index;
+}
+
+static void side_by_side() {
+    TEST_START();
+
+    Rect monitors[2], search;
+    ObMonitorMap* map;
+
+    RECT_SET(monitors[0], 0, 0, 1920, 1080);
+    RECT_SET(monitors[1], 1920, 0, 1280, 1024);
+    map = monitor_map_new(monitors, 2, 2);
+
+    /* mostly on the right */
+    RECT_SET(search, 1800, 100, 400, 300);
+    EXPECT_INT_EQ(1, monitor_map_find(map, &search));
+    /* mostly on the left */
+    RECT_SET(search, 1600, 100, 400, 300);
+    EXPECT_INT_EQ(0, monitor_map_find(map, &search));
+    /* below the right monitor, where there is no monitor at all */
+    RECT_SET(search, 2000, 1050, 100, 100);
+    EXPECT_INT_EQ(1, monitor_map_find(map, &search));
+    /* off the screen entirely, closest to the left */
+    RECT_SET(search, -500, 200, 100, 100);
+    EXPECT_INT_EQ(0, monitor_map_find(map, &search));
+
+    monitor_map_free(map);
+
+    TEST_END();
+}
+
+static void cloned_monitors() {
+    TEST_START();
+
+    Rect monitors[3], search;
+    ObMonitorMap* map;
+
+    RECT_SET(monitors[0], 0, 0, 1024, 768);
+    RECT_SET(monitors[1], 0, 0, 1024, 768);
+    RECT_SET(monitors[2], 1024, 0, 1024, 768);
+    RECT_SET(search, 100, 100, 200, 200);
+
+    /* a pixel is only counted for the first monitor it is on */
+    map = monitor_map_new(monitors, 3, 3);
+    EXPECT_INT_EQ(0, monitor_map_find(map, &search));
+    monitor_map_free(map);
+
+    /* unless the other one is the primary monitor */
+    map = monitor_map_new(monitors, 3, 1);
+    EXPECT_INT_EQ(1, monitor_map_find(map, &search));
+    monitor_map_free(map);
+
+    TEST_END();
+}
+
+static void random_rect(GRand* rand, Rect* r, gint max)
+{
+    /* snap to a coarse grid some of the time, so that edges line up */
+    gint step = g_rand_boolean(rand) ? 64 : 1;
+    RECT_SET(*r,
+             g_rand_int_range(rand, -max / 4, max) / step * step,
+             g_rand_int_range(rand, -max / 4, max) / step * step,
+             g_rand_int_range(rand, 0, max / 2) / step * step,
+             g_rand_int_range(rand, 0, max / 2) / step * step);
+}
+
+static void random_layouts() {
+    TEST_START();
+
+    GRand* rand = g_rand_new_with_seed(1);
+    int i, j;
+
+    for (i = 0; i < 500; ++i) {
+        guint n = g_rand_int_range(rand, 1, 9);
+        guint primary = g_rand_int_range(rand, 0, n + 2);
+        Rect monitors[n];
+        ObMonitorMap* map;
+        guint k;
+
+        for (k = 0; k < n; ++k) {
+            random_rect(rand, &monitors[k], 4000);
+            if (k > 0 && g_rand_int_range(rand, 0, 4) == 0)
+                /* cloned outputs */
+                monitors[k] = monitors[g_rand_int_range(rand, 0, k)];
+        }
+
+        map = monitor_map_new(monitors, n, primary);
+        for (j = 0; j < 50; ++j) {
+            Rect search;
+            random_rect(rand, &search, 4000);
+            EXPECT_INT_EQ(ref_find(monitors, n, primary, &search),
+                          monitor_map_find(map, &search));
+        }
+        monitor_map_free(map);
+    }
+
+    g_rand_free(rand);
+
+    TEST_END();
+}
+
+void run_monitor_map_unittest() {
+    unittest_start_suite("monitor_map");
+
+    side_by_side();
+    cloned_monitors();
+    random_layouts();
+
+    unittest_end_suite();
+}
@@ -27,6 +27,7 @@
 #include "translate.h"
 #include "mouse.h"
 #include "gettext.h"
+#include "debug.h"
 #include "obt/display.h"
 
 #include <glib.h>
@@ -206,6 +207,69 @@ void mouse_replay_pointer(void)
     }
 }
 
+/*! Asks the server if a button release was inside the window it happened in.
+  @return FALSE if the window is gone */
+static gboolean server_release_inside(XButtonEvent *e, gboolean *inside)
+{
+    gint junk1, junk2;
+    Window wjunk;
+    guint ujunk, b, w, h;
+
+    /* this can cause errors to occur when the window closes */
+    obt_display_ignore_errors(TRUE);
+    junk1 = XGetGeometry(obt_display, e->window,
+                         &wjunk, &junk1, &junk2, &w, &h, &b, &ujunk);
+    obt_display_ignore_errors(FALSE);
+    if (junk1)
+        *inside = (e->x >= (signed)-b &&
+                   e->y >= (signed)-b &&
+                   e->x < (signed)(w+b) &&
+                   e->y < (signed)(h+b));
+    return junk1;
+}
+
+/*! Finds if a button release was inside the window it happened in, from the
+  sizes that the window's client and frame were last given.  The server is
+  only asked about windows that aren't known.
+  @return FALSE if the window is gone */
+static gboolean release_inside(ObClient *client, XButtonEvent *e,
+                               gboolean *inside)
+{
+    gint w, h;
+
+    if (e->window == obt_root(ob_screen)) {
+        /* the pointer can't leave the root window */
+        *inside = TRUE;
+        return TRUE;
+    }
+
+    if (client && e->window == client->window) {
+        /* the client's border width is always 0 while it is managed */
+        w = client->area.width;
+        h = client->area.height;
+    }
+    else if (!client || !client->frame ||
+             !frame_window_size(client->frame, e->window, &w, &h))
+        return server_release_inside(e, inside);
+
+    *inside = e->x >= 0 && e->y >= 0 && e->x < w && e->y < h;
+
+    if (ob_debug_type_enabled(OB_DEBUG_MOUSE)) {
+        gboolean server_inside;
+
+        if (!server_release_inside(e, &server_inside))
+            ob_debug_type(OB_DEBUG_MOUSE, "Release in window 0x%lx which "
+                          "is gone", e->window);
+        else if (server_inside != *inside)
+            ob_debug_type(OB_DEBUG_MOUSE, "Release at %d,%d in window 0x%lx "
+                          "is %s its size %dx%d, but the server says it "
+                          "is %s", e->x, e->y, e->window,
+                          *inside ? "inside" : "outside", w, h,
+                          server_inside ? "inside" : "outside");
+    }
+    return TRUE;
+}
+
 gboolean mouse_event(ObClient *client, XEvent *e)
 {
     static Time ltime;
@@ -278,20 +342,9 @@ gboolean mouse_event(ObClient *client, XEvent *e)
 
         if (e->xbutton.button == button) {
             /* clicks are only valid if its released over the window */
-            gint junk1, junk2;
-            Window wjunk;
-            guint ujunk, b, w, h;
-            /* this can cause errors to occur when the window closes */
-            obt_display_ignore_errors(TRUE);
-            junk1 = XGetGeometry(obt_display, e->xbutton.window,
-                                 &wjunk, &junk1, &junk2, &w, &h, &b, &ujunk);
-            obt_display_ignore_errors(FALSE);
-            if (junk1) {
-                if (e->xbutton.x >= (signed)-b &&
-                    e->xbutton.y >= (signed)-b &&
-                    e->xbutton.x < (signed)(w+b) &&
-                    e->xbutton.y < (signed)(h+b))
-                {
+            gboolean inside;
+            if (release_inside(client, &e->xbutton, &inside)) {
+                if (inside) {
                     click = TRUE;
                     /* double clicks happen if there were 2 in a row! */
                     if (lbutton == button &&
@@ -69,12 +69,22 @@ static guint waiting_for_sync;
 static guint sync_timer = 0;
 #endif
 
+/* the latest position of the pointer, which is waiting for the next frame
+   to be applied */
+static gboolean update_pending = FALSE;
+static gint update_x, update_y;
+static guint update_timer = 0;
+/* how many pointer motions were followed and skipped during the move or
+   resize */
+static guint updates_applied, updates_dropped;
+
 static ObPopup *popup = NULL;
 
 static void do_move(gboolean keyboard, gint keydist);
 static void do_resize(void);
 static void do_edge_warp(gint x, gint y);
 static void cancel_edge_warp();
+static void finish_updates(gboolean apply);
 #ifdef SYNC
 static gboolean sync_timeout_func(gpointer data);
 #endif
@@ -311,6 +321,8 @@ void moveresize_start(ObClient *c, gint x, gint y, guint b, guint32 cnr)
 
 void moveresize_end(gboolean cancel)
 {
+    finish_updates(!cancel);
+
     ungrab_keyboard();
     ungrab_pointer();
 
@@ -725,6 +737,7 @@ static void move_with_keys(KeySym sym, guint state)
         XEvent ce;
         while (xqueue_remove_local(&ce, xqueue_match_type,
                                    GINT_TO_POINTER(MotionNotify)));
+        update_pending = FALSE;
     }
     screen_pointer_pos(&px, &py);
 
@@ -917,6 +930,7 @@ static void resize_with_keys(KeySym sym, guint state)
         XEvent ce;
         while (xqueue_remove_local(&ce, xqueue_match_type,
                                    GINT_TO_POINTER(MotionNotify)));
+        update_pending = FALSE;
     }
     screen_pointer_pos(&px, &py);
 
@@ -931,6 +945,175 @@ static void resize_with_keys(KeySym sym, guint state)
 
 }
 
+/*! Moves or resizes the window to follow the pointer */
+static void do_motion(gint x, gint y)
+{
+    ++updates_applied;
+
+    if (moving) {
+        cur_x = start_cx + x - start_x;
+        cur_y = start_cy + y - start_y;
+        do_move(FALSE, 0);
+        do_edge_warp(x, y);
+    } else {
+        gint dw, dh;
+        ObDirection dir;
+
+        if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT)) {
+            dw = -(x - start_x);
+            dh = -(y - start_y);
+            dir = OB_DIRECTION_NORTHWEST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP)) {
+            dw = 0;
+            dh = -(y - start_y);
+            dir = OB_DIRECTION_NORTH;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT)) {
+            dw = (x - start_x);
+            dh = -(y - start_y);
+            dir = OB_DIRECTION_NORTHEAST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_RIGHT)) {
+            dw = (x - start_x);
+            dh = 0;
+            dir = OB_DIRECTION_EAST;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMRIGHT)) {
+            dw = (x - start_x);
+            dh = (y - start_y);
+            dir = OB_DIRECTION_SOUTHEAST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOM))
+        {
+            dw = 0;
+            dh = (y - start_y);
+            dir = OB_DIRECTION_SOUTH;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT)) {
+            dw = -(x - start_x);
+            dh = (y - start_y);
+            dir = OB_DIRECTION_SOUTHWEST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT)) {
+            dw = -(x - start_x);
+            dh = 0;
+            dir = OB_DIRECTION_WEST;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_KEYBOARD)) {
+            dw = (x - start_x);
+            dh = (y - start_y);
+            dir = OB_DIRECTION_SOUTHEAST;
+        } else
+            g_assert_not_reached();
+
+        /* override the client's max state if desired */
+        if (ABS(dw) >= config_resist_edge) {
+            if (moveresize_client->max_horz) {
+                /* unmax horz */
+                was_max_horz = TRUE;
+                pre_max_area.x = moveresize_client->pre_max_area.x;
+                pre_max_area.width = moveresize_client->pre_max_area.width;
+
+                moveresize_client->pre_max_area.x = cur_x;
+                moveresize_client->pre_max_area.width = cur_w;
+                client_maximize(moveresize_client, FALSE, 1);
+            }
+        }
+        else if (was_max_horz && !moveresize_client->max_horz) {
+            /* remax horz and put the premax back */
+            client_maximize(moveresize_client, TRUE, 1);
+            moveresize_client->pre_max_area.x = pre_max_area.x;
+            moveresize_client->pre_max_area.width = pre_max_area.width;
+        }
+
+        if (ABS(dh) >= config_resist_edge) {
+            if (moveresize_client->max_vert) {
+                /* unmax vert */
+                was_max_vert = TRUE;
+                pre_max_area.y = moveresize_client->pre_max_area.y;
+                pre_max_area.height =
+                    moveresize_client->pre_max_area.height;
+
+                moveresize_client->pre_max_area.y = cur_y;
+                moveresize_client->pre_max_area.height = cur_h;
+                client_maximize(moveresize_client, FALSE, 2);
+            }
+        }
+        else if (was_max_vert && !moveresize_client->max_vert) {
+            /* remax vert and put the premax back */
+            client_maximize(moveresize_client, TRUE, 2);
+            moveresize_client->pre_max_area.y = pre_max_area.y;
+            moveresize_client->pre_max_area.height = pre_max_area.height;
+        }
+
+        dw -= cur_w - start_cw;
+        dh -= cur_h - start_ch;
+
+        calc_resize(FALSE, 0, &dw, &dh, dir);
+        cur_w += dw;
+        cur_h += dh;
+
+        if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT))
+        {
+            cur_x -= dw;
+        }
+        if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT))
+        {
+            cur_y -= dh;
+        }
+
+        do_resize();
+    }
+}
+
+static gboolean update_timeout_func(gpointer data)
+{
+    if (!update_pending) {
+        update_timer = 0;
+        return FALSE; /* nothing moved, stop until it does */
+    }
+
+    update_pending = FALSE;
+    do_motion(update_x, update_y);
+    return TRUE; /* wait for the next frame */
+}
+
+/*! Follows the pointer, no more often than config_resize_update_rate */
+static void queue_motion(gint x, gint y)
+{
+    if (!config_resize_update_rate)
+        do_motion(x, y);
+    else if (update_timer) {
+        /* an update was made this frame, so wait for the next one */
+        if (update_pending)
+            ++updates_dropped;
+        update_pending = TRUE;
+        update_x = x;
+        update_y = y;
+    } else {
+        do_motion(x, y);
+        update_timer = g_timeout_add(MAX(1000 / config_resize_update_rate, 1),
+                                     update_timeout_func, NULL);
+    }
+}
+
+/*! Stops pacing the updates, and applies the last pointer position if
+  @apply is TRUE */
+static void finish_updates(gboolean apply)
+{
+    if (update_timer) g_source_remove(update_timer);
+    update_timer = 0;
+
+    if (update_pending && apply)
+        do_motion(update_x, update_y);
+    update_pending = FALSE;
+
+    ob_debug("Followed the pointer with %u updates, skipping %u motions",
+             updates_applied, updates_dropped);
+    updates_applied = updates_dropped = 0;
+}
+
 gboolean moveresize_event(XEvent *e)
 {
     gboolean used = FALSE;
@@ -950,121 +1133,18 @@ gboolean moveresize_event(XEvent *e)
             used = TRUE;
         }
     } else if (e->type == MotionNotify) {
-        if (moving) {
-            cur_x = start_cx + e->xmotion.x_root - start_x;
-            cur_y = start_cy + e->xmotion.y_root - start_y;
-            do_move(FALSE, 0);
-            do_edge_warp(e->xmotion.x_root, e->xmotion.y_root);
-        } else {
-            gint dw, dh;
-            ObDirection dir;
-
-            if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT)) {
-                dw = -(e->xmotion.x_root - start_x);
-                dh = -(e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_NORTHWEST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP)) {
-                dw = 0;
-                dh = -(e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_NORTH;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = -(e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_NORTHEAST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_RIGHT)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = 0;
-                dir = OB_DIRECTION_EAST;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMRIGHT)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTHEAST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOM))
-            {
-                dw = 0;
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTH;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT)) {
-                dw = -(e->xmotion.x_root - start_x);
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTHWEST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT)) {
-                dw = -(e->xmotion.x_root - start_x);
-                dh = 0;
-                dir = OB_DIRECTION_WEST;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_KEYBOARD)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTHEAST;
-            } else
-                g_assert_not_reached();
-
-            /* override the client's max state if desired */
-            if (ABS(dw) >= config_resist_edge) {
-                if (moveresize_client->max_horz) {
-                    /* unmax horz */
-                    was_max_horz = TRUE;
-                    pre_max_area.x = moveresize_client->pre_max_area.x;
-                    pre_max_area.width = moveresize_client->pre_max_area.width;
-
-                    moveresize_client->pre_max_area.x = cur_x;
-                    moveresize_client->pre_max_area.width = cur_w;
-                    client_maximize(moveresize_client, FALSE, 1);
-                }
-            }
-            else if (was_max_horz && !moveresize_client->max_horz) {
-                /* remax horz and put the premax back */
-                client_maximize(moveresize_client, TRUE, 1);
-                moveresize_client->pre_max_area.x = pre_max_area.x;
-                moveresize_client->pre_max_area.width = pre_max_area.width;
-            }
-
-            if (ABS(dh) >= config_resist_edge) {
-                if (moveresize_client->max_vert) {
-                    /* unmax vert */
-                    was_max_vert = TRUE;
-                    pre_max_area.y = moveresize_client->pre_max_area.y;
-                    pre_max_area.height =
-                        moveresize_client->pre_max_area.height;
-
-                    moveresize_client->pre_max_area.y = cur_y;
-                    moveresize_client->pre_max_area.height = cur_h;
-                    client_maximize(moveresize_client, FALSE, 2);
-                }
-            }
-            else if (was_max_vert && !moveresize_client->max_vert) {
-                /* remax vert and put the premax back */
-                client_maximize(moveresize_client, TRUE, 2);
-                moveresize_client->pre_max_area.y = pre_max_area.y;
-                moveresize_client->pre_max_area.height = pre_max_area.height;
-            }
-
-            dw -= cur_w - start_cw;
-            dh -= cur_h - start_ch;
-
-            calc_resize(FALSE, 0, &dw, &dh, dir);
-            cur_w += dw;
-            cur_h += dh;
-
-            if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT))
-            {
-                cur_x -= dw;
-            }
-            if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT))
-            {
-                cur_y -= dh;
-            }
-
-            do_resize();
+        XEvent ce;
+        gint x = e->xmotion.x_root, y = e->xmotion.y_root;
+
+        /* skip over the motion events that are already waiting, only the
+           latest position of the pointer matters */
+        while (xqueue_peek_local(&ce) && ce.type == MotionNotify) {
+            xqueue_next_local(&ce);
+            x = ce.xmotion.x_root;
+            y = ce.xmotion.y_root;
+            ++updates_dropped;
         }
+        queue_motion(x, y);
         used = TRUE;
     } else if (e->type == KeyPress) {
         KeySym sym = obt_keyboard_keypress_to_keysym(e);
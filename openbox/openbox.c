@@ -42,6 +42,7 @@
 #include "config.h"
 #include "ping.h"
 #include "prompt.h"
+#include "spatial.h"
 #include "gettext.h"
 #include "obrender/render.h"
 #include "obrender/theme.h"
@@ -84,6 +85,7 @@
 
 RrInstance   *ob_rr_inst;
 RrImageCache *ob_rr_icons;
+RrPaintCache *ob_rr_frame_cache;
 RrTheme      *ob_rr_theme;
 GMainLoop    *ob_main_loop;
 gint          ob_screen;
@@ -113,6 +115,8 @@ static void parse_env();
 static void parse_args(gint *argc, gchar **argv);
 static Cursor load_cursor(const gchar *name, guint fontval);
 static void run_startup_cmd(void);
+static void debug_font_caches(const RrTheme *theme);
+static void shutdown_subsystems(gboolean reconfig, ObConfigPart parts);
 
 gint main(gint argc, gchar **argv)
 {
@@ -185,6 +189,11 @@ gint main(gint argc, gchar **argv)
        and the alt-tab icon
     */
     ob_rr_icons = RrImageCacheNew(3);
+    /* Keeping the painted titlebars and handles around means that a focus
+       change only needs to swap window backgrounds. This is enough for a
+       focused and unfocused titlebar for a few dozen maximized windows on a
+       large monitor */
+    ob_rr_frame_cache = RrPaintCacheNew(ob_rr_inst, 16 * 1024 * 1024);
 
     XSynchronize(obt_display, xsync);
 
@@ -226,27 +235,52 @@ gint main(gint argc, gchar **argv)
         do {
             gchar *xml_error_string = NULL;
             ObPrompt *xmlprompt = NULL;
-
-            if (reconfigure) obt_keyboard_reload();
+            ObConfigPart parts;
+            GTimer *timer = NULL;
+            gdouble t_down = 0, t_theme = 0;
 
             {
                 ObtXmlInst *i;
+                gboolean loaded;
 
-                /* startup the parsing so everything can register sections
-                   of the rc */
                 i = obt_xml_instance_new();
 
+                /* load user options */
+                loaded =
+                    (config_file &&
+                     obt_xml_load_file(i, config_file, "openbox_config")) ||
+                    obt_xml_load_config_file(i, "openbox", "rc.xml",
+                                             "openbox_config");
+
+                /* find what the new options change. everything is built
+                   the first time through */
+                parts = config_changed_parts(i, loaded);
+                if (!reconfigure)
+                    parts = OB_CONFIG_PART_ALL;
+                else {
+                    if (RrThemeFileChanged(ob_rr_theme))
+                        parts |= OB_CONFIG_PART_THEME;
+                    if (menu_files_changed())
+                        parts |= OB_CONFIG_PART_MENU;
+                    /* everything holds onto pieces of the theme */
+                    if (parts & OB_CONFIG_PART_THEME)
+                        parts = OB_CONFIG_PART_ALL;
+
+                    timer = g_timer_new();
+                    shutdown_subsystems(TRUE, parts);
+                    t_down = g_timer_elapsed(timer, NULL);
+
+                    obt_keyboard_reload();
+                }
+
                 /* register all the available actions */
                 actions_startup(reconfigure);
-                /* start up config which sets up with the parser */
-                config_startup(i);
+                /* start up config which sets up with the parser, so
+                   everything can register sections of the rc */
+                config_startup(i, parts);
 
-                /* parse/load user options */
-                if ((config_file &&
-                     obt_xml_load_file(i, config_file, "openbox_config")) ||
-                    obt_xml_load_config_file(i, "openbox", "rc.xml",
-                                             "openbox_config"))
-                {
+                /* parse user options */
+                if (loaded) {
                     obt_xml_tree_from_root(i);
                     obt_xml_close(i);
                 }
@@ -278,7 +312,7 @@ gint main(gint argc, gchar **argv)
             }
 
             /* load the theme specified in the rc file */
-            {
+            if (parts & OB_CONFIG_PART_THEME) {
                 RrTheme *theme;
                 if ((theme = RrThemeNew(ob_rr_inst, config_theme, TRUE,
                                         config_font_activewindow,
@@ -288,6 +322,9 @@ gint main(gint argc, gchar **argv)
                                         config_font_activeosd,
                                         config_font_inactiveosd)))
                 {
+                    /* nothing painted with the old theme is useful now */
+                    RrPaintCacheClear(ob_rr_frame_cache);
+                    debug_font_caches(ob_rr_theme);
                     RrThemeFree(ob_rr_theme);
                     ob_rr_theme = theme;
                 }
@@ -297,14 +334,17 @@ gint main(gint argc, gchar **argv)
                 OBT_PROP_SETS(obt_root(ob_screen), OB_THEME,
                               ob_rr_theme->name);
             }
+            if (timer) t_theme = g_timer_elapsed(timer, NULL) - t_down;
 
-            if (reconfigure) {
+            if (reconfigure && (parts & OB_CONFIG_PART_THEME)) {
                 GList *it;
 
                 /* update all existing windows for the new theme */
                 for (it = client_list; it; it = g_list_next(it)) {
                     ObClient *c = it->data;
                     frame_adjust_theme(c->frame);
+                    /* the icon sizes that are read depend on the theme */
+                    client_update_icons(c);
                 }
             }
             event_startup(reconfigure);
@@ -320,13 +360,17 @@ gint main(gint argc, gchar **argv)
             grab_startup(reconfigure);
             group_startup(reconfigure);
             ping_startup(reconfigure);
+            spatial_startup(reconfigure);
             client_startup(reconfigure);
             dock_startup(reconfigure);
             moveresize_startup(reconfigure);
-            keyboard_startup(reconfigure);
-            mouse_startup(reconfigure);
+            if (parts & OB_CONFIG_PART_KEYBOARD)
+                keyboard_startup(reconfigure);
+            if (parts & OB_CONFIG_PART_MOUSE)
+                mouse_startup(reconfigure);
             menu_frame_startup(reconfigure);
-            menu_startup(reconfigure);
+            if (parts & OB_CONFIG_PART_MENU)
+                menu_startup(reconfigure);
             prompt_startup(reconfigure);
 
             if (!reconfigure) {
@@ -347,7 +391,7 @@ gint main(gint argc, gchar **argv)
                 {
                     client_focus(WINDOW_AS_CLIENT(w));
                 }
-            } else {
+            } else if (parts & OB_CONFIG_PART_THEME) {
                 GList *it;
 
                 /* redecorate all existing windows */
@@ -364,6 +408,19 @@ gint main(gint argc, gchar **argv)
                 }
             }
 
+            if (timer) {
+                ob_debug("Reconfigured in %.1fms (%.1fms shutting down, "
+                         "%.1fms loading the theme), rebuilt:%s%s%s%s",
+                         g_timer_elapsed(timer, NULL) * 1000,
+                         t_down * 1000, t_theme * 1000,
+                         parts & OB_CONFIG_PART_THEME ?
+                         " theme decorations" : "",
+                         parts & OB_CONFIG_PART_KEYBOARD ? " keyboard" : "",
+                         parts & OB_CONFIG_PART_MOUSE ? " mouse" : "",
+                         parts & OB_CONFIG_PART_MENU ? " menus" : "");
+                g_timer_destroy(timer);
+            }
+
             ob_set_state(OB_STATE_RUNNING);
 
             if (!reconfigure && startup_cmd) run_startup_cmd();
@@ -388,36 +445,20 @@ gint main(gint argc, gchar **argv)
                 xmlprompt = NULL;
             }
 
-            if (!reconfigure)
+            /* when reconfiguring, things are shut down once it's known
+               which of them need to be rebuilt */
+            if (!reconfigure) {
                 window_unmanage_all();
-
-            prompt_shutdown(reconfigure);
-            menu_shutdown(reconfigure);
-            menu_frame_shutdown(reconfigure);
-            mouse_shutdown(reconfigure);
-            keyboard_shutdown(reconfigure);
-            moveresize_shutdown(reconfigure);
-            dock_shutdown(reconfigure);
-            client_shutdown(reconfigure);
-            ping_shutdown(reconfigure);
-            group_shutdown(reconfigure);
-            grab_shutdown(reconfigure);
-            screen_shutdown(reconfigure);
-            focus_cycle_popup_shutdown(reconfigure);
-            focus_cycle_indicator_shutdown(reconfigure);
-            focus_cycle_shutdown(reconfigure);
-            focus_shutdown(reconfigure);
-            window_shutdown(reconfigure);
-            sn_shutdown(reconfigure);
-            event_shutdown(reconfigure);
-            config_shutdown();
-            actions_shutdown(reconfigure);
+                shutdown_subsystems(FALSE, OB_CONFIG_PART_ALL);
+            }
         } while (reconfigure);
     }
 
     XSync(obt_display, FALSE);
 
+    debug_font_caches(ob_rr_theme);
     RrThemeFree(ob_rr_theme);
+    RrPaintCacheUnref(ob_rr_frame_cache);
     RrImageCacheUnref(ob_rr_icons);
     RrInstanceFree(ob_rr_inst);
 
@@ -549,6 +590,7 @@ static void print_help(void)
     g_print(_("  --debug             Display debugging output\n"));
     g_print(_("  --debug-focus       Display debugging output for focus handling\n"));
     g_print(_("  --debug-session     Display debugging output for session management\n"));
+    g_print(_("  --debug-mouse       Check mouse clicks against the X server\n"));
     g_print(_("  --debug-xinerama    Split the display into fake xinerama screens\n"));
     g_print(_("\nPlease report bugs at %s\n"), PACKAGE_BUGREPORT);
 }
@@ -588,6 +630,63 @@ static void run_startup_cmd(void)
     }
 }
 
+static void debug_font_cache(const gchar *name, const RrFont *font)
+{
+    gulong hits, misses;
+
+    RrFontCacheStats(font, &hits, &misses);
+    ob_debug("Font cache for %s: %lu hits, %lu misses",
+             name, hits, misses);
+}
+
+/*! Shows how well the theme's fonts reused the strings they laid out */
+static void debug_font_caches(const RrTheme *theme)
+{
+    if (!theme) return;
+
+    debug_font_cache("the active window", theme->win_font_focused);
+    debug_font_cache("inactive windows", theme->win_font_unfocused);
+    debug_font_cache("menu titles", theme->menu_title_font);
+    debug_font_cache("menu items", theme->menu_font);
+    debug_font_cache("the active on-screen display",
+                     theme->osd_font_hilite);
+    debug_font_cache("inactive on-screen displays",
+                     theme->osd_font_unhilite);
+}
+
+/*! Shuts everything down, except for the parts which are not in @parts, which
+  are kept as they are through a reconfigure */
+static void shutdown_subsystems(gboolean reconfig, ObConfigPart parts)
+{
+    prompt_shutdown(reconfig);
+    if (parts & OB_CONFIG_PART_MENU)
+        menu_shutdown(reconfig);
+    else
+        menu_frame_hide_all();
+    menu_frame_shutdown(reconfig);
+    if (parts & OB_CONFIG_PART_MOUSE)
+        mouse_shutdown(reconfig);
+    if (parts & OB_CONFIG_PART_KEYBOARD)
+        keyboard_shutdown(reconfig);
+    moveresize_shutdown(reconfig);
+    dock_shutdown(reconfig);
+    client_shutdown(reconfig);
+    spatial_shutdown(reconfig);
+    ping_shutdown(reconfig);
+    group_shutdown(reconfig);
+    grab_shutdown(reconfig);
+    screen_shutdown(reconfig);
+    focus_cycle_popup_shutdown(reconfig);
+    focus_cycle_indicator_shutdown(reconfig);
+    focus_cycle_shutdown(reconfig);
+    focus_shutdown(reconfig);
+    window_shutdown(reconfig);
+    sn_shutdown(reconfig);
+    event_shutdown(reconfig);
+    config_shutdown(parts);
+    actions_shutdown(reconfig);
+}
+
 static void parse_env(void)
 {
     const gchar *id;
@@ -653,6 +752,9 @@ static void parse_args(gint *argc, gchar **argv)
         else if (!strcmp(argv[i], "--debug-session")) {
             ob_debug_enable(OB_DEBUG_SM, TRUE);
         }
+        else if (!strcmp(argv[i], "--debug-mouse")) {
+            ob_debug_enable(OB_DEBUG_MOUSE, TRUE);
+        }
         else if (!strcmp(argv[i], "--debug-xinerama")) {
             ob_debug_xinerama = TRUE;
         }
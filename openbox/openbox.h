@@ -29,6 +29,7 @@
 
 extern RrInstance *ob_rr_inst;
 extern RrImageCache *ob_rr_icons;
+extern RrPaintCache *ob_rr_frame_cache;
 extern RrTheme    *ob_rr_theme;
 
 extern GMainLoop *ob_main_loop;
@@ -25,9 +25,10 @@
 #include "config.h"
 #include "dock.h"
 #include "debug.h"
+#include "spatial.h"
 #include "place_overlap.h"
 
-static Rect *choose_pointer_monitor(ObClient *c)
+static const Rect *choose_pointer_monitor(ObClient *c)
 {
     return screen_area(c->desktop, screen_monitor_pointer(), NULL);
 }
@@ -154,10 +155,11 @@ gint cmp_background(const void *a, const void *b)
 }
 
 /*! Pick a monitor to place a window on. */
-static Rect* choose_monitor(ObClient *c, gboolean client_to_be_foregrounded,
-                            ObAppSettings *settings)
+static const Rect* choose_monitor(ObClient *c,
+                                  gboolean client_to_be_foregrounded,
+                                  ObAppSettings *settings)
 {
-    Rect *area;
+    const Rect *area;
     ObPlaceHead *choice;
     guint i;
     ObClient *p;
@@ -259,7 +261,7 @@ static gboolean place_under_mouse(ObClient *client, gint *x, gint *y,
 {
     gint l, r, t, b;
     gint px, py;
-    Rect *area;
+    const Rect *area;
 
     if (config_place_policy != OB_PLACE_POLICY_MOUSE)
         return FALSE;
@@ -280,12 +282,11 @@ static gboolean place_under_mouse(ObClient *client, gint *x, gint *y,
     *y = py - frame_size.height / 2;
     *y = MIN(MAX(*y, t), b);
 
-    g_slice_free(Rect, area);
-
     return TRUE;
 }
 
-static gboolean place_per_app_setting_position(ObClient *client, Rect *screen,
+static gboolean place_per_app_setting_position(ObClient *client,
+                                               const Rect *screen,
                                                gint *x, gint *y,
                                                ObAppSettings *settings,
                                                Size frame_size)
@@ -301,7 +302,8 @@ static gboolean place_per_app_setting_position(ObClient *client, Rect *screen,
     return TRUE;
 }
 
-static void place_per_app_setting_size(ObClient *client, Rect *screen,
+static void place_per_app_setting_size(ObClient *client,
+                                       const Rect *screen,
                                        gint *w, gint *h,
                                        ObAppSettings *settings)
 {
@@ -334,7 +336,7 @@ static void place_per_app_setting_size(ObClient *client, Rect *screen,
     }
 }
 
-static gboolean place_transient_splash(ObClient *client, Rect *area,
+static gboolean place_transient_splash(ObClient *client, const Rect *area,
                                        gint *x, gint *y, Size frame_size)
 {
     if (client->type == OB_CLIENT_TYPE_DIALOG) {
@@ -381,7 +383,8 @@ static gboolean place_transient_splash(ObClient *client, Rect *area,
     return FALSE;
 }
 
-static gboolean place_least_overlap(ObClient *c, Rect *head, int *x, int *y,
+static gboolean place_least_overlap(ObClient *c, const Rect *head,
+                                    int *x, int *y,
                                     Size frame_size)
 {
     /* Assemble the list of windows that could overlap with @c in the user's
@@ -402,27 +405,23 @@ static gboolean place_least_overlap(ObClient *c, Rect *head, int *x, int *y,
     }
 
     if (!ignore_windows) {
-        GList* it;
-        for (it = client_list; it != NULL; it = g_list_next(it)) {
+        GSList* it, *next;
+
+        /* windows that are not on the monitor can't overlap with anything
+           placed on it */
+        potential_overlap_clients = spatial_clients_near(
+            c->desktop != DESKTOP_ALL ? c->desktop : screen_desktop, head, 0);
+        for (it = potential_overlap_clients; it != NULL; it = next) {
             ObClient* maybe_client = (ObClient*)it->data;
-            if (maybe_client == c)
-                continue;
-            if (maybe_client->iconic)
+            next = g_slist_next(it);
+            if (maybe_client == c ||
+                maybe_client->iconic ||
+                !client_occupies_space(maybe_client))
+            {
+                potential_overlap_clients = g_slist_delete_link(
+                    potential_overlap_clients, it);
                 continue;
-            if (!client_occupies_space(maybe_client))
-                continue;
-            if (c->desktop != DESKTOP_ALL) {
-                if (maybe_client->desktop != c->desktop &&
-                    maybe_client->desktop != DESKTOP_ALL)
-                    continue;
-            } else {
-                if (maybe_client->desktop != screen_desktop &&
-                    maybe_client->desktop != DESKTOP_ALL)
-                    continue;
             }
-
-            potential_overlap_clients = g_slist_prepend(
-                potential_overlap_clients, maybe_client);
             n_client_rects += 1;
         }
     }
@@ -443,7 +442,8 @@ static gboolean place_least_overlap(ObClient *c, Rect *head, int *x, int *y,
         g_slist_free(potential_overlap_clients);
 
         place_overlap_find_least_placement(client_rects, n_client_rects, head,
-                                           &frame_size, &result);
+                                           &frame_size, config_place_center,
+                                           &result);
         *x = result.x;
         *y = result.y;
     }
@@ -472,7 +472,7 @@ gboolean place_client(ObClient *client, gboolean client_to_be_foregrounded,
                       Rect* client_area, ObAppSettings *settings)
 {
     gboolean ret;
-    Rect *monitor_area;
+    const Rect *monitor_area;
     int *x, *y, *w, *h;
     Size frame_size;
 
@@ -500,8 +500,6 @@ gboolean place_client(ObClient *client, gboolean client_to_be_foregrounded,
         place_least_overlap(client, monitor_area, x, y, frame_size);
     g_assert(ret);
 
-    g_slice_free(Rect, monitor_area);
-
     /* get where the client should be */
     frame_frame_gravity(client->frame, x, y);
     return TRUE;
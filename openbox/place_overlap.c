@@ -16,7 +16,6 @@
    See the COPYING file for a copy of the GNU General Public License.
 */
 
-#include "config.h"
 #include "geom.h"
 #include "place_overlap.h"
 #include "obt/bsearch.h"
@@ -31,22 +30,62 @@ static void make_grid(const Rect* client_rects,
                       int* y_edges,
                       int max_edges);
 
-static int best_direction(const Point* grid_point,
-                          const Rect* client_rects,
-                          int n_client_rects,
-                          const Rect* monitor,
-                          const Size* req_size,
-                          Point* best_top_left);
-
-static int total_overlap(const Rect* client_rects,
-                         int n_client_rects,
-                         const Rect* proposed_rect);
+/* The area covered by the windows, summed over the grid formed by their
+   edges.  This gives the overlap of any rectangle with the windows in
+   O(log n) instead of looking at each window. */
+typedef struct _OverlapTable {
+    int nx;
+    int ny;
+    /* The edges of the windows clipped to the monitor, sorted and unique */
+    int* xs;
+    int* ys;
+    /* How many windows cover the grid cell whose top-left corner is at
+       (xs[i], ys[j]), at index i * ny + j.  Zero on the last row and
+       column, which have no cells. */
+    int* cover;
+    /* The area covered left of xs[i] and above ys[j] */
+    gint64* area;
+    /* The area covered in column i above ys[j] per pixel of width */
+    gint64* above;
+    /* The area covered in row j left of xs[i] per pixel of height */
+    gint64* left;
+} OverlapTable;
+
+/* A position in the OverlapTable, found once and used for many lookups */
+typedef struct _TableCoord {
+    /* The last edge at or before the position */
+    int at;
+    /* How far the position is past that edge */
+    int off;
+} TableCoord;
+
+static void overlap_table_init(OverlapTable* t,
+                               const Rect* client_rects,
+                               int n_client_rects,
+                               const Rect* monitor);
+
+static void overlap_table_clear(OverlapTable* t);
+
+static void table_coord(const int* edges,
+                        int n_edges,
+                        int value,
+                        TableCoord* coord);
+
+static gint64 best_direction(const Point* grid_point,
+                             const OverlapTable* table,
+                             const TableCoord* x_coords,
+                             const TableCoord* y_coords,
+                             const Rect* monitor,
+                             const Size* req_size,
+                             Point* best_top_left);
+
+static gint64 total_overlap(const OverlapTable* table,
+                            const Rect* proposed_rect);
 
 static void center_in_field(Point* grid_point,
                             const Size* req_size,
                             const Rect *monitor,
-                            const Rect* client_rects,
-                            int n_client_rects,
+                            const OverlapTable* table,
                             const int* x_edges,
                             const int* y_edges,
                             int max_edges);
@@ -57,28 +96,47 @@ void place_overlap_find_least_placement(const Rect* client_rects,
                                         int n_client_rects,
                                         const Rect *monitor,
                                         const Size* req_size,
+                                        gboolean center,
                                         Point* result)
 {
     POINT_SET(*result, monitor->x, monitor->y);
-    int overlap = G_MAXINT;
+    gint64 overlap = G_MAXINT64;
     int max_edges = 2 * (n_client_rects + 1);
 
     int x_edges[max_edges];
     int y_edges[max_edges];
     make_grid(client_rects, n_client_rects, monitor,
             x_edges, y_edges, max_edges);
+    OverlapTable table;
+    overlap_table_init(&table, client_rects, n_client_rects, monitor);
+    /* Where the top, the grid point and the bottom of the window fall in
+       the table, for each of the grid's rows */
+    TableCoord y_coords[max_edges][3];
     int i;
+    for (i = 0; i < max_edges && y_edges[i] != G_MAXINT; ++i) {
+        table_coord(table.ys, table.ny, y_edges[i] - req_size->height,
+                    &y_coords[i][0]);
+        table_coord(table.ys, table.ny, y_edges[i], &y_coords[i][1]);
+        table_coord(table.ys, table.ny, y_edges[i] + req_size->height,
+                    &y_coords[i][2]);
+    }
     for (i = 0; i < max_edges; ++i) {
         if (x_edges[i] == G_MAXINT)
             break;
+        TableCoord x_coords[3];
+        table_coord(table.xs, table.nx, x_edges[i] - req_size->width,
+                    &x_coords[0]);
+        table_coord(table.xs, table.nx, x_edges[i], &x_coords[1]);
+        table_coord(table.xs, table.nx, x_edges[i] + req_size->width,
+                    &x_coords[2]);
         int j;
         for (j = 0; j < max_edges; ++j) {
             if (y_edges[j] == G_MAXINT)
                 break;
             Point grid_point = {.x = x_edges[i], .y = y_edges[j]};
             Point best_top_left;
-            int this_overlap =
-                best_direction(&grid_point, client_rects, n_client_rects,
+            gint64 this_overlap =
+                best_direction(&grid_point, &table, x_coords, y_coords[j],
                         monitor, req_size, &best_top_left);
             if (this_overlap < overlap) {
                 overlap = this_overlap;
@@ -90,16 +148,16 @@ void place_overlap_find_least_placement(const Rect* client_rects,
         if (overlap == 0)
             break;
     }
-    if (config_place_center && overlap == 0) {
+    if (center && overlap == 0) {
         center_in_field(result,
                         req_size,
                         monitor,
-                        client_rects,
-                        n_client_rects,
+                        &table,
                         x_edges,
                         y_edges,
                         max_edges);
     }
+    overlap_table_clear(&table);
 }
 
 static int compare_ints(const void* a,
@@ -156,22 +214,6 @@ static void make_grid(const Rect* client_rects,
     uniquify(y_edges, n_edges);
 }
 
-static int total_overlap(const Rect* client_rects,
-                         int n_client_rects,
-                         const Rect* proposed_rect)
-{
-    int overlap = 0;
-    int i;
-    for (i = 0; i < n_client_rects; ++i) {
-        if (!RECT_INTERSECTS_RECT(*proposed_rect, client_rects[i]))
-            continue;
-        Rect rtemp;
-        RECT_SET_INTERSECTION(rtemp, *proposed_rect, client_rects[i]);
-        overlap += RECT_AREA(rtemp);
-    }
-    return overlap;
-}
-
 static int find_first_grid_position_greater_or_equal(int search_value,
                                                      const int* edges,
                                                      int max_edges)
@@ -191,6 +233,156 @@ static int find_first_grid_position_greater_or_equal(int search_value,
     return BSEARCH_AT() + 1;
 }                         
 
+static void overlap_table_init(OverlapTable* t,
+                               const Rect* client_rects,
+                               int n_client_rects,
+                               const Rect* monitor)
+{
+    int n_edges = 0;
+    int i, j;
+
+    t->xs = g_new(int, 2 * (n_client_rects + 1));
+    t->ys = g_new(int, 2 * (n_client_rects + 1));
+    for (i = 0; i < n_client_rects; ++i) {
+        if (!RECT_INTERSECTS_RECT(client_rects[i], *monitor))
+            continue;
+        Rect r;
+        RECT_SET_INTERSECTION(r, client_rects[i], *monitor);
+        t->xs[n_edges] = r.x;
+        t->ys[n_edges++] = r.y;
+        t->xs[n_edges] = r.x + r.width;
+        t->ys[n_edges++] = r.y + r.height;
+    }
+    t->xs[n_edges] = monitor->x;
+    t->ys[n_edges++] = monitor->y;
+    t->xs[n_edges] = monitor->x + monitor->width;
+    t->ys[n_edges++] = monitor->y + monitor->height;
+    qsort(t->xs, n_edges, sizeof(int), compare_ints);
+    qsort(t->ys, n_edges, sizeof(int), compare_ints);
+    uniquify(t->xs, n_edges);
+    uniquify(t->ys, n_edges);
+    for (t->nx = 0; t->nx < n_edges && t->xs[t->nx] != G_MAXINT; ++t->nx);
+    for (t->ny = 0; t->ny < n_edges && t->ys[t->ny] != G_MAXINT; ++t->ny);
+
+    const int nx = t->nx;
+    const int ny = t->ny;
+    t->cover = g_new0(int, nx * ny);
+    t->area = g_new(gint64, nx * ny);
+    t->above = g_new(gint64, nx * ny);
+    t->left = g_new(gint64, nx * ny);
+
+    /* Mark the corners of each window, then add them up across the grid to
+       find how many windows cover each cell. */
+    for (i = 0; i < n_client_rects; ++i) {
+        if (!RECT_INTERSECTS_RECT(client_rects[i], *monitor))
+            continue;
+        Rect r;
+        RECT_SET_INTERSECTION(r, client_rects[i], *monitor);
+        int x1 = find_first_grid_position_greater_or_equal(r.x, t->xs, nx);
+        int y1 = find_first_grid_position_greater_or_equal(r.y, t->ys, ny);
+        int x2 = find_first_grid_position_greater_or_equal(r.x + r.width,
+                                                           t->xs, nx);
+        int y2 = find_first_grid_position_greater_or_equal(r.y + r.height,
+                                                           t->ys, ny);
+        ++t->cover[x1 * ny + y1];
+        --t->cover[x2 * ny + y1];
+        --t->cover[x1 * ny + y2];
+        ++t->cover[x2 * ny + y2];
+    }
+    for (i = 0; i < nx; ++i)
+        for (j = 0; j < ny; ++j) {
+            if (i > 0)
+                t->cover[i * ny + j] += t->cover[(i - 1) * ny + j];
+            if (j > 0)
+                t->cover[i * ny + j] += t->cover[i * ny + j - 1];
+            if (i > 0 && j > 0)
+                t->cover[i * ny + j] -= t->cover[(i - 1) * ny + j - 1];
+        }
+
+    for (i = 0; i < nx; ++i)
+        for (j = 0; j < ny; ++j) {
+            const int at = i * ny + j;
+            if (j == 0)
+                t->above[at] = 0;
+            else
+                t->above[at] = t->above[at - 1] +
+                    (gint64)t->cover[at - 1] * (t->ys[j] - t->ys[j - 1]);
+            if (i == 0) {
+                t->left[at] = 0;
+                t->area[at] = 0;
+            } else {
+                const int w = t->xs[i] - t->xs[i - 1];
+                t->left[at] = t->left[at - ny] +
+                    (gint64)t->cover[at - ny] * w;
+                t->area[at] = t->area[at - ny] + t->above[at - ny] * w;
+            }
+        }
+}
+
+static void overlap_table_clear(OverlapTable* t)
+{
+    g_free(t->xs);
+    g_free(t->ys);
+    g_free(t->cover);
+    g_free(t->area);
+    g_free(t->above);
+    g_free(t->left);
+}
+
+/* Returns the index of the last edge at or before the value, which must be
+   inside the edges. */
+static int grid_position_at_or_before(int search_value,
+                                      const int* edges,
+                                      int n_edges)
+{
+    BSEARCH_SETUP();
+    BSEARCH(int, edges, 0, n_edges, search_value);
+    return BSEARCH_AT();
+}
+
+static void table_coord(const int* edges,
+                        int n_edges,
+                        int value,
+                        TableCoord* coord)
+{
+    value = CLAMP(value, edges[0], edges[n_edges - 1]);
+    coord->at = grid_position_at_or_before(value, edges, n_edges);
+    coord->off = value - edges[coord->at];
+}
+
+/* The area covered by the windows left of x and above y. */
+static gint64 covered_area(const OverlapTable* t,
+                           const TableCoord* x,
+                           const TableCoord* y)
+{
+    const int at = x->at * t->ny + y->at;
+    return t->area[at] + x->off * t->above[at] + y->off * t->left[at] +
+        (gint64)x->off * y->off * t->cover[at];
+}
+
+static gint64 overlap_between(const OverlapTable* t,
+                              const TableCoord* x1,
+                              const TableCoord* y1,
+                              const TableCoord* x2,
+                              const TableCoord* y2)
+{
+    return covered_area(t, x2, y2) - covered_area(t, x1, y2) -
+        covered_area(t, x2, y1) + covered_area(t, x1, y1);
+}
+
+static gint64 total_overlap(const OverlapTable* table,
+                            const Rect* proposed_rect)
+{
+    TableCoord x1, y1, x2, y2;
+    table_coord(table->xs, table->nx, proposed_rect->x, &x1);
+    table_coord(table->ys, table->ny, proposed_rect->y, &y1);
+    table_coord(table->xs, table->nx,
+                proposed_rect->x + proposed_rect->width, &x2);
+    table_coord(table->ys, table->ny,
+                proposed_rect->y + proposed_rect->height, &y2);
+    return overlap_between(table, &x1, &y1, &x2, &y2);
+}
+
 static void expand_width(Rect* r, int by)
 {
     r->width += by;
@@ -210,8 +402,7 @@ typedef struct _ExpandInfo {
     int orig_width;
     int orig_height;
     const Rect* monitor;
-    const Rect* client_rects;
-    int n_client_rects;
+    const OverlapTable* table;
     int max_edges;
 } ExpandInfo;
 
@@ -230,8 +421,8 @@ static int expand_field(int orig_edge_index,
     while (edge_index < i->max_edges - 1) {
         int next_edge_index = edge_index + 1;
         (*expand_by)(&field, edges[next_edge_index] - edges[edge_index]);
-        int overlap = total_overlap(i->client_rects, i->n_client_rects, &field);
-        if (overlap != 0 || !RECT_CONTAINS_RECT(*(i->monitor), field))
+        if (!RECT_CONTAINS_RECT(*(i->monitor), field) ||
+            total_overlap(i->table, &field) != 0)
             break;
         edge_index = next_edge_index;
     }
@@ -251,8 +442,7 @@ static int expand_field(int orig_edge_index,
 static void center_in_field(Point* top_left,
                             const Size* req_size,
                             const Rect *monitor,
-                            const Rect* client_rects,
-                            int n_client_rects,
+                            const OverlapTable* table,
                             const int* x_edges,
                             const int* y_edges,
                             int max_edges)
@@ -269,8 +459,7 @@ static void center_in_field(Point* top_left,
         .orig_width = x_edges[orig_right_edge_index] - top_left->x,
         .orig_height = y_edges[orig_bottom_edge_index] - top_left->y,
         .monitor = monitor,
-        .client_rects = client_rects,
-        .n_client_rects = n_client_rects,
+        .table = table,
         .max_edges = max_edges};
     /* Try extending width. */
     int right_edge_index =
@@ -301,17 +490,18 @@ static void center_in_field(Point* top_left,
 
 #define NUM_DIRECTIONS 4
 
-static int best_direction(const Point* grid_point,
-                          const Rect* client_rects,
-                          int n_client_rects,
-                          const Rect* monitor,
-                          const Size* req_size,
-                          Point* best_top_left)
+static gint64 best_direction(const Point* grid_point,
+                             const OverlapTable* table,
+                             const TableCoord* x_coords,
+                             const TableCoord* y_coords,
+                             const Rect* monitor,
+                             const Size* req_size,
+                             Point* best_top_left)
 {
     static const Size directions[NUM_DIRECTIONS] = {
         {0, 0}, {0, -1}, {-1, 0}, {-1, -1}
     };
-    int overlap = G_MAXINT;
+    gint64 overlap = G_MAXINT64;
     int i;
     for (i = 0; i < NUM_DIRECTIONS; ++i) {
         Point pt = {
@@ -322,7 +512,13 @@ static int best_direction(const Point* grid_point,
         RECT_SET(r, pt.x, pt.y, req_size->width, req_size->height);
         if (!RECT_CONTAINS_RECT(*monitor, r))
             continue;
-        int this_overlap = total_overlap(client_rects, n_client_rects, &r);
+        /* x_coords and y_coords hold the edges a window size before, at
+           and after the grid point */
+        const int dx = directions[i].width + 1;
+        const int dy = directions[i].height + 1;
+        gint64 this_overlap =
+            overlap_between(table, &x_coords[dx], &y_coords[dy],
+                            &x_coords[dx + 1], &y_coords[dy + 1]);
         if (this_overlap < overlap) {
             overlap = this_overlap;
             *best_top_left = pt;
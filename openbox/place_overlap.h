@@ -18,8 +18,12 @@
 
 #include "geom.h"
 
+/* Finds the position for a window of size @req_size inside @bounds that
+   overlaps the least with @client_rects.  When @center is true and there is
+   room without any overlap, the window is centered in the free space. */
 void place_overlap_find_least_placement(const Rect* client_rects,
                                         int n_client_rects,
                                         const Rect* bounds,
                                         const Size* req_size,
+                                        gboolean center,
                                         Point* result);
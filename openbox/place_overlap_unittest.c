@@ -0,0 +1,194 @@
+#include "obt/unittest_base.h"
+
+#include "openbox/place_overlap.h"
+
+#include <glib.h>
+#include <stdlib.h>
+
+/* The placement engine used to find the overlap at every candidate by
+   looking at every window.  This is that algorithm, without the centering,
+   to check the engine against. */
+
+static int ref_compare_ints(const void* a, const void* b)
+{
+    return *(const int*)a - *(const int*)b;
+}
+
+static int ref_make_edges(const Rect* rects, int n_rects, const Rect* monitor,
+                          int* edges, gboolean x)
+{
+    int i, j, n = 0;
+    for (i = 0; i < n_rects; ++i) {
+        if (!RECT_INTERSECTS_RECT(rects[i], *monitor))
+            continue;
+        edges[n++] = x ? rects[i].x : rects[i].y;
+        edges[n++] = x ? rects[i].x + rects[i].width :
+            rects[i].y + rects[i].height;
+    }
+    edges[n++] = x ? monitor->x : monitor->y;
+    edges[n++] = x ? monitor->x + monitor->width :
+        monitor->y + monitor->height;
+    qsort(edges, n, sizeof(int), ref_compare_ints);
+    for (i = j = 1; i < n; ++i)
+        if (edges[i] != edges[j - 1])
+            edges[j++] = edges[i];
+    return j;
+}
+
+static gint64 ref_overlap(const Rect* rects, int n_rects, const Rect* r)
+{
+    gint64 overlap = 0;
+    int i;
+    for (i = 0; i < n_rects; ++i) {
+        if (!RECT_INTERSECTS_RECT(*r, rects[i]))
+            continue;
+        Rect rtemp;
+        RECT_SET_INTERSECTION(rtemp, *r, rects[i]);
+        overlap += RECT_AREA(rtemp);
+    }
+    return overlap;
+}
+
+static void ref_place(const Rect* rects, int n_rects, const Rect* monitor,
+                      const Size* size, Point* result)
+{
+    static const Size directions[4] = {{0, 0}, {0, -1}, {-1, 0}, {-1, -1}};
+    int x_edges[2 * (n_rects + 1)];
+    int y_edges[2 * (n_rects + 1)];
+    int nx = ref_make_edges(rects, n_rects, monitor, x_edges, TRUE);
+    int ny = ref_make_edges(rects, n_rects, monitor, y_edges, FALSE);
+    gint64 overlap = G_MAXINT64;
+    int i, j, d;
+
+    POINT_SET(*result, monitor->x, monitor->y);
+    for (i = 0; i < nx && overlap; ++i)
+        for (j = 0; j < ny && overlap; ++j)
+            for (d = 0; d < 4 && overlap; ++d) {
+                Rect r;
+                RECT_SET(r,
+                         x_edges[i] + size->width * directions[d].width,
+                         y_edges[j] + size->height * directions[d].height,
+                         size->width, size->height);
+                if (!RECT_CONTAINS_RECT(*monitor, r))
+                    continue;
+                gint64 o = ref_overlap(rects, n_rects, &r);
+                if (o < overlap) {
+                    overlap = o;
+                    POINT_SET(*result, r.x, r.y);
+                }
+            }
+}
+
+static void random_layout(GRand* rand, Rect* rects, int n_rects,
+                          const Rect* monitor)
+{
+    int i;
+    for (i = 0; i < n_rects; ++i) {
+        /* some windows hang off the monitor, and some are sized the same,
+           so that edges are shared */
+        int w = g_rand_int_range(rand, 1, 5) * 100 +
+            g_rand_int_range(rand, 0, 3) * g_rand_int_range(rand, 0, 100);
+        int h = g_rand_int_range(rand, 1, 5) * 80 +
+            g_rand_int_range(rand, 0, 3) * g_rand_int_range(rand, 0, 80);
+        RECT_SET(rects[i],
+                 monitor->x + g_rand_int_range(rand, -200, monitor->width),
+                 monitor->y + g_rand_int_range(rand, -200, monitor->height),
+                 w, h);
+    }
+}
+
+static void empty_monitor() {
+    TEST_START();
+
+    Rect monitor;
+    Size size = {.width = 300, .height = 200};
+    Point result;
+
+    RECT_SET(monitor, 100, 50, 1000, 800);
+    place_overlap_find_least_placement(NULL, 0, &monitor, &size, FALSE,
+                                       &result);
+    EXPECT_INT_EQ(100, result.x);
+    EXPECT_INT_EQ(50, result.y);
+
+    /* centered in the whole monitor */
+    place_overlap_find_least_placement(NULL, 0, &monitor, &size, TRUE,
+                                       &result);
+    EXPECT_INT_EQ(450, result.x);
+    EXPECT_INT_EQ(350, result.y);
+
+    TEST_END();
+}
+
+static void beside_window() {
+    TEST_START();
+
+    Rect monitor, rect;
+    Size size = {.width = 300, .height = 800};
+    Point result;
+
+    /* the only free space is right of the window */
+    RECT_SET(monitor, 0, 0, 1000, 800);
+    RECT_SET(rect, 0, 0, 600, 800);
+    place_overlap_find_least_placement(&rect, 1, &monitor, &size, FALSE,
+                                       &result);
+    EXPECT_INT_EQ(600, result.x);
+    EXPECT_INT_EQ(0, result.y);
+
+    place_overlap_find_least_placement(&rect, 1, &monitor, &size, TRUE,
+                                       &result);
+    EXPECT_INT_EQ(650, result.x);
+    EXPECT_INT_EQ(0, result.y);
+
+    TEST_END();
+}
+
+static void random_layouts() {
+    TEST_START();
+
+    GRand* rand = g_rand_new_with_seed(1);
+    Rect monitor;
+    int i;
+
+    RECT_SET(monitor, 0, 20, 1920, 1060);
+    for (i = 0; i < 400; ++i) {
+        int n_rects = g_rand_int_range(rand, 1, 60);
+        Rect rects[n_rects];
+        Size size = {
+            .width = g_rand_int_range(rand, 1, 1200),
+            .height = g_rand_int_range(rand, 1, 900)
+        };
+        Point want, got;
+        Rect r;
+
+        random_layout(rand, rects, n_rects, &monitor);
+        ref_place(rects, n_rects, &monitor, &size, &want);
+        place_overlap_find_least_placement(rects, n_rects, &monitor, &size,
+                                           FALSE, &got);
+        EXPECT_INT_EQ(want.x, got.x);
+        EXPECT_INT_EQ(want.y, got.y);
+
+        /* centering only moves the window inside space that is free */
+        place_overlap_find_least_placement(rects, n_rects, &monitor, &size,
+                                           TRUE, &got);
+        RECT_SET(r, want.x, want.y, size.width, size.height);
+        if (ref_overlap(rects, n_rects, &r) == 0) {
+            RECT_SET(r, got.x, got.y, size.width, size.height);
+            EXPECT_BOOL_EQ(TRUE, RECT_CONTAINS_RECT(monitor, r));
+            EXPECT_BOOL_EQ(TRUE, ref_overlap(rects, n_rects, &r) == 0);
+        }
+    }
+
+    g_rand_free(rand);
+
+    TEST_END();
+}
+
+void run_place_overlap_unittest() {
+    unittest_start_suite("place_overlap");
+
+    empty_monitor();
+    beside_window();
+    random_layouts();
+
+    unittest_end_suite();
+}
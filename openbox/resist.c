@@ -23,6 +23,7 @@
 #include "stacking.h"
 #include "screen.h"
 #include "dock.h"
+#include "spatial.h"
 #include "config.h"
 
 #include <glib.h>
@@ -101,20 +102,22 @@ static gboolean resist_move_window(Rect window,
 
 void resist_move_windows(ObClient *c, gint resist, gint *x, gint *y)
 {
-    GList *it;
-    Rect dock_area;
+    GSList *list, *it;
+    Rect dock_area, near;
 
     if (!resist) return;
 
     frame_client_gravity(c->frame, x, y);
 
+    /* only windows with an edge within the resistance of where the window is
+       or where it is going to can be snapped to */
+    RECT_SET(near, MIN(*x, c->frame->area.x), MIN(*y, c->frame->area.y),
+             c->frame->area.width + ABS(*x - c->frame->area.x),
+             c->frame->area.height + ABS(*y - c->frame->area.y));
+    list = spatial_clients_near(screen_desktop, &near, resist + 1);
 
-    for (it = stacking_list; it; it = g_list_next(it)) {
-        ObClient *target;
-
-        if (!WINDOW_IS_CLIENT(it->data))
-            continue;
-        target = it->data;
+    for (it = list; it; it = g_slist_next(it)) {
+        ObClient *target = it->data;
 
         /* don't snap to self or non-visibles */
         if (!target->frame->visible || target == c)
@@ -127,6 +130,7 @@ void resist_move_windows(ObClient *c, gint resist, gint *x, gint *y)
                                resist, x, y))
             break;
     }
+    g_slist_free(list);
     dock_get_area(&dock_area);
     resist_move_window(c->frame->area, dock_area, resist, x, y);
 
@@ -135,7 +139,7 @@ void resist_move_windows(ObClient *c, gint resist, gint *x, gint *y)
 
 void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
 {
-    Rect *area;
+    const Rect *area;
     const Rect *parea;
     guint i;
     gint l, t, r, b; /* requested edges */
@@ -200,8 +204,6 @@ void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
             *y = pt;
         else if (cb <= pb && b > pb && b < pb + resist)
             *y = pb - h + 1;
-
-        g_slice_free(Rect, area);
     }
 
     frame_frame_gravity(c->frame, x, y);
@@ -292,15 +294,18 @@ static gboolean resist_size_window(Rect window, Rect target, gint resist,
 void resist_size_windows(ObClient *c, gint resist, gint *w, gint *h,
                          ObDirection dir)
 {
-    GList *it;
+    GSList *list, *it;
     ObClient *target; /* target */
     Rect dock_area;
 
     if (!resist) return;
 
-    for (it = stacking_list; it; it = g_list_next(it)) {
-        if (!WINDOW_IS_CLIENT(it->data))
-            continue;
+    /* the edges being moved can't go further than the size is changing */
+    list = spatial_clients_near(screen_desktop, &c->frame->area,
+                                resist + 1 + ABS(*w - c->frame->area.width) +
+                                ABS(*h - c->frame->area.height));
+
+    for (it = list; it; it = g_slist_next(it)) {
         target = it->data;
 
         /* don't snap to invisibles or ourself */
@@ -314,6 +319,7 @@ void resist_size_windows(ObClient *c, gint resist, gint *w, gint *h,
                                resist, w, h, dir))
             break;
     }
+    g_slist_free(list);
     dock_get_area(&dock_area);
     resist_size_window(c->frame->area, dock_area,
                        resist, w, h, dir);
@@ -324,7 +330,7 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
 {
     gint l, t, r, b; /* my left, top, right and bottom sides */
     gint dlt, drb; /* my destination left/top and right/bottom sides */
-    Rect *area;
+    const Rect *area;
     const Rect *parea;
     gint al, at, ar, ab; /* screen boundaries */
     gint pl, pt, pr, pb; /* physical screen boundaries */
@@ -410,7 +416,5 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
                 *h = b - pt + 1;
             break;
         }
-
-        g_slice_free(Rect, area);
     }
 }
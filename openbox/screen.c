@@ -32,6 +32,7 @@
 #include "focus.h"
 #include "focus_cycle.h"
 #include "popup.h"
+#include "monitor_map.h"
 #include "version.h"
 #include "obrender/render.h"
 #include "gettext.h"
@@ -56,6 +57,7 @@ static gboolean screen_validate_layout(ObDesktopLayout *l);
 static gboolean replace_wm(void);
 static void     screen_tell_ksplash(void);
 static void     screen_fallback_focus(void);
+static void     update_monitor_map(void);
 
 guint                  screen_num_desktops;
 guint                  screen_num_monitors;
@@ -73,12 +75,32 @@ static gboolean screen_desktop_timeout = TRUE;
 static guint    screen_desktop_timer = 0;
 /*! An array of desktops, holding an array of areas per monitor */
 static Rect  *monitor_area = NULL;
+/*! Finds which monitor a rectangle is on, built from monitor_area */
+static ObMonitorMap *monitor_map = NULL;
 /*! An array of desktops, holding an array of struts */
 static GSList *struts_top = NULL;
 static GSList *struts_left = NULL;
 static GSList *struts_right = NULL;
 static GSList *struts_bottom = NULL;
 
+typedef struct {
+    Rect area;
+    gboolean valid;
+} ObScreenArea;
+
+/*! The work area of each desktop on each monitor, filled in as screen_area()
+  is asked for them and thrown away when the struts, monitors or desktops
+  change.  Indexed by desktop * (monitors + 1) + monitor, where the last
+  desktop is DESKTOP_ALL and the last monitor is SCREEN_AREA_ALL_MONITORS. */
+static ObScreenArea *area_cache = NULL;
+static guint area_cache_desktops = 0;
+static guint area_cache_monitors = 0;
+/*! The last area that screen_area() found for a search area */
+static ObScreenArea search_cache;
+static Rect search_cache_search;
+static guint search_cache_desktop;
+static guint search_cache_head;
+
 static ObPagerPopup *desktop_popup;
 static guint         desktop_popup_timer = 0;
 static gboolean      desktop_popup_perm;
@@ -371,6 +393,8 @@ void screen_startup(gboolean reconfig)
         pager_popup_text_width_to_strings(desktop_popup,
                                           screen_desktop_names,
                                           screen_num_desktops);
+        /* the primary monitor may have changed */
+        update_monitor_map();
         return;
     }
 
@@ -478,6 +502,11 @@ void screen_shutdown(gboolean reconfig)
 
     g_strfreev(screen_desktop_names);
     screen_desktop_names = NULL;
+
+    g_free(area_cache);
+    area_cache = NULL;
+    monitor_map_free(monitor_map);
+    monitor_map = NULL;
 }
 
 void screen_resize(void)
@@ -501,10 +530,12 @@ void screen_resize(void)
     /* this calls screen_update_areas(), which we need ! */
     dock_configure();
 
+    client_configure_begin();
     for (it = client_list; it; it = g_list_next(it)) {
         client_move_onscreen(it->data, FALSE);
         client_reconfigure(it->data, FALSE);
     }
+    client_configure_commit();
 }
 
 void screen_set_num_desktops(guint num)
@@ -697,6 +728,9 @@ void screen_set_desktop(guint num, gboolean dofocus)
     /* ignore enter events caused by the move */
     ignore_start = event_start_ignore_all_enters();
 
+    /* send all the windows' changes together */
+    client_configure_begin();
+
     if (moveresize_client)
         client_set_desktop(moveresize_client, num, TRUE, FALSE);
 
@@ -732,6 +766,8 @@ void screen_set_desktop(guint num, gboolean dofocus)
         }
     }
 
+    client_configure_commit();
+
     focus_cycle_addremove(NULL, TRUE);
 
     event_end_ignore_all_enters(ignore_start);
@@ -1244,6 +1280,8 @@ void screen_show_desktop(ObScreenShowDestopMode show_mode, ObClient *show_only)
         return;
     }
 
+    client_configure_begin();
+
     if (showing_after) {
         /* hide windows bottom to top */
         for (it = g_list_last(stacking_list); it; it = g_list_previous(it)) {
@@ -1268,6 +1306,8 @@ void screen_show_desktop(ObScreenShowDestopMode show_mode, ObClient *show_only)
         }
     }
 
+    client_configure_commit();
+
     if (showing_after) {
         /* focus the desktop */
         for (it = focus_order; it; it = g_list_next(it)) {
@@ -1357,6 +1397,13 @@ typedef struct {
     } \
 }
 
+static void update_monitor_map(void)
+{
+    monitor_map_free(monitor_map);
+    monitor_map = monitor_map_new(monitor_area, screen_num_monitors,
+                                  config_primary_monitor_index);
+}
+
 static void get_xinerama_screens(Rect **xin_areas, guint *nxin)
 {
     guint i;
@@ -1430,6 +1477,7 @@ void screen_update_areas(void)
 
     g_free(monitor_area);
     get_xinerama_screens(&monitor_area, &screen_num_monitors);
+    update_monitor_map();
 
     /* set up the user-specified margins */
     config_margins.top_start = RECT_LEFT(monitor_area[screen_num_monitors]);
@@ -1485,14 +1533,18 @@ void screen_update_areas(void)
     VALIDATE_STRUTS(struts_bottom, bottom,
                     monitor_area[screen_num_monitors].height / 2);
 
+    /* forget the work areas found with the old struts */
+    g_free(area_cache);
+    area_cache = NULL;
+    search_cache.valid = FALSE;
+
     dims = g_new(gulong, 4 * screen_num_desktops);
     for (i = 0; i < screen_num_desktops; ++i) {
-        Rect *area = screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL);
+        const Rect *area = screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL);
         dims[i*4+0] = area->x;
         dims[i*4+1] = area->y;
         dims[i*4+2] = area->width;
         dims[i*4+3] = area->height;
-        g_slice_free(Rect, area);
     }
 
     /* set the legacy workarea hint to the union of all the monitors */
@@ -1500,8 +1552,10 @@ void screen_update_areas(void)
                     dims, 4 * screen_num_desktops);
 
     /* the area has changed, adjust all the windows if they need it */
+    client_configure_begin();
     for (it = onscreen; it; it = g_list_next(it))
         client_reconfigure(it->data, FALSE);
+    client_configure_commit();
 
     g_free(dims);
 }
@@ -1559,19 +1613,14 @@ Rect* screen_area_all_monitors(guint desktop)
     (head == SCREEN_AREA_ALL_MONITORS && us && \
      RECT_BOTTOM(monitor_area[i]) - s->bottom < RECT_BOTTOM(*search))
 
-Rect* screen_area(guint desktop, guint head, Rect *search)
+static void screen_area_calc(guint desktop, guint head, const Rect *search,
+                             Rect *a)
 {
-    Rect *a;
     GSList *it;
     gint l, r, t, b;
     guint i, d;
     gboolean us = search != NULL; /* user provided search */
 
-    g_assert(desktop < screen_num_desktops || desktop == DESKTOP_ALL);
-    g_assert(head < screen_num_monitors || head == SCREEN_AREA_ONE_MONITOR ||
-             head == SCREEN_AREA_ALL_MONITORS);
-    g_assert(!(head == SCREEN_AREA_ONE_MONITOR && search == NULL));
-
     /* find any struts for this monitor
        which will be affecting the search area.
     */
@@ -1664,28 +1713,63 @@ Rect* screen_area(guint desktop, guint head, Rect *search)
         }
     }
 
-    a = g_slice_new(Rect);
     a->x = l;
     a->y = t;
     a->width = r - l + 1;
     a->height = b - t + 1;
-    return a;
 }
 
-typedef struct {
-    Rect r;
-    gboolean subtract;
-} RectArithmetic;
+const Rect* screen_area(guint desktop, guint head, const Rect *search)
+{
+    ObScreenArea *a;
+
+    g_assert(desktop < screen_num_desktops || desktop == DESKTOP_ALL);
+    g_assert(head < screen_num_monitors || head == SCREEN_AREA_ONE_MONITOR ||
+             head == SCREEN_AREA_ALL_MONITORS);
+    g_assert(!(head == SCREEN_AREA_ONE_MONITOR && search == NULL));
+
+    if (search) {
+        /* the same search is often repeated, such as for each monitor while
+           resisting at the edges, so remember the last one */
+        a = &search_cache;
+        if (a->valid && search_cache_desktop == desktop &&
+            search_cache_head == head &&
+            RECT_EQUAL(search_cache_search, *search))
+            return &a->area;
+
+        search_cache_desktop = desktop;
+        search_cache_head = head;
+        search_cache_search = *search;
+    }
+    else {
+        guint d, m;
+
+        /* the number of desktops can change before the areas are updated
+           for it, start over if it does */
+        if (!area_cache || area_cache_desktops != screen_num_desktops ||
+            area_cache_monitors != screen_num_monitors)
+        {
+            g_free(area_cache);
+            area_cache_desktops = screen_num_desktops;
+            area_cache_monitors = screen_num_monitors;
+            area_cache = g_new0(ObScreenArea, (area_cache_desktops + 1) *
+                                (area_cache_monitors + 1));
+        }
+
+        d = desktop == DESKTOP_ALL ? area_cache_desktops : desktop;
+        m = head == SCREEN_AREA_ALL_MONITORS ? area_cache_monitors : head;
+        a = &area_cache[d * (area_cache_monitors + 1) + m];
+        if (a->valid)
+            return &a->area;
+    }
+
+    screen_area_calc(desktop, head, search, &a->area);
+    a->valid = TRUE;
+    return &a->area;
+}
 
 guint screen_find_monitor(const Rect *search)
 {
-    guint i;
-    guint mostpx_index = screen_num_monitors;
-    glong mostpx = 0;
-    guint closest_distance_index = screen_num_monitors;
-    guint closest_distance = G_MAXUINT;
-    GSList *counted = NULL;
-
     /* we want to count the number of pixels search has on each monitor, but not
        double count.  so if a pixel is counted on monitor A then we should not
        count it again on monitor B. in the end we want to return the monitor
@@ -1695,130 +1779,11 @@ guint screen_find_monitor(const Rect *search)
        considered the search area's monitor.  we try the configured primary
        monitor first, so it gets the highest preference.
 
-       if we have counted an area A, then we want to subtract the intersection
-       of A with the area on future monitors.
-       but now consider if we count an area B that intersects A. we want to
-       subtract the area B from that counted on future monitors, but not
-       subtract the intersection of A and B twice! so we would add the
-       intersection of A and B back, to account for it being subtracted both
-       for A and B.
-
-       this is the idea behind the algorithm.  we always subtract the full area
-       for monitor M intersected with the search area. we'll call that AREA.
-       but then we go through the list |counted| and for each rectangle in
-       the list that is being subtracted from future monitors, we insert a
-       request to add back the intersection of the subtracted rect with AREA.
-       vice versa for a rect in |counted| that is getting added back.
+       the monitor map has the monitors already cut up into pieces that are
+       each counted for only one monitor, so this doesn't need to work out the
+       overlaps between them every time.
     */
-
-    if (config_primary_monitor_index < screen_num_monitors) {
-        const Rect *monitor;
-        Rect on_current_monitor;
-        glong area;
-
-        monitor = screen_physical_area_monitor(config_primary_monitor_index);
-
-        if (RECT_INTERSECTS_RECT(*monitor, *search)) {
-            RECT_SET_INTERSECTION(on_current_monitor, *monitor, *search);
-            area = RECT_AREA(on_current_monitor);
-
-            if (area > mostpx) {
-                mostpx = area;
-                mostpx_index = config_primary_monitor_index;
-            }
-
-            /* add the intersection rect on the current monitor to the
-               counted list. that's easy for the first one, we just mark it for
-               subtraction */
-            {
-                RectArithmetic *ra = g_slice_new(RectArithmetic);
-                ra->r = on_current_monitor;
-                ra->subtract = TRUE;
-                counted = g_slist_prepend(counted, ra);
-            }
-        }
-    }
-
-    for (i = 0; i < screen_num_monitors; ++i) {
-        const Rect *monitor;
-        Rect on_current_monitor;
-        glong area;
-        GSList *it;
-
-        monitor = screen_physical_area_monitor(i);
-
-        if (!RECT_INTERSECTS_RECT(*monitor, *search)) {
-            /* If we don't intersect then find the distance between the search
-               rect and the monitor. We'll use the closest monitor from this
-               metric if none of the monitors intersect. */
-            guint distance = rect_manhatten_distance(*monitor, *search);
-
-            if (distance < closest_distance) {
-                closest_distance = distance;
-                closest_distance_index = i;
-            }
-            continue;
-        }
-
-        if (i == config_primary_monitor_index)
-            continue;  /* already did this one */
-
-        RECT_SET_INTERSECTION(on_current_monitor, *monitor, *search);
-        area = RECT_AREA(on_current_monitor);
-
-        /* remove pixels we already counted on any previous monitors. */
-        for (it = counted; it; it = g_slist_next(it)) {
-            RectArithmetic *ra = it->data;
-            Rect intersection;
-
-            RECT_SET_INTERSECTION(intersection, ra->r, *search);
-            if (ra->subtract) area -= RECT_AREA(intersection);
-            else area += RECT_AREA(intersection);
-        }
-
-        if (area > mostpx) {
-            mostpx = area;
-            mostpx_index = i;
-        }
-
-        /* add the intersection rect on the current monitor I to the counted
-           list.
-           but now we need to compensate for every rectangle R already in the
-           counted list, and add a new rect R' that is the intersection of
-           R and I, but with the reverse subtraction/addition operation.
-        */
-        for (it = counted; it; it = g_slist_next(it)) {
-            RectArithmetic *saved = it->data;
-
-            if (!RECT_INTERSECTS_RECT(saved->r, on_current_monitor))
-                continue;
-            /* we are going to subtract our rect from future monitors, but
-               part of it may already be being subtracted/added, so compensate
-               to not double add/subtract. */
-            RectArithmetic *reverse = g_slice_new(RectArithmetic);
-            RECT_SET_INTERSECTION(reverse->r, saved->r, on_current_monitor);
-            reverse->subtract = !saved->subtract;
-            /* prepend so we can continue thru the list uninterupted */
-            counted = g_slist_prepend(counted, reverse);
-        }
-        {
-            RectArithmetic *ra = g_slice_new(RectArithmetic);
-            ra->r = on_current_monitor;
-            ra->subtract = TRUE;
-            counted = g_slist_prepend(counted, ra);
-        }
-    }
-
-    while (counted) {
-        g_slice_free(RectArithmetic, counted->data);
-        counted = g_slist_delete_link(counted, counted);
-    }
-
-    if (mostpx_index < screen_num_monitors)
-        return mostpx_index;
-
-    g_assert(closest_distance_index < screen_num_monitors);
-    return closest_distance_index;
+    return monitor_map_find(monitor_map, search);
 }
 
 const Rect* screen_physical_area_all_monitors(void)
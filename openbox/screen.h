@@ -148,9 +148,12 @@ const Rect* screen_physical_area_primary(gboolean fixed);
 /*! @param head is the number of the head or one of SCREEN_AREA_ALL_MONITORS,
            SCREEN_AREA_ONE_MONITOR
     @param search NULL or the whole monitor(s)
-    @return A Rect allocated with g_slice_new()
+    @return A Rect which is owned by the screen code and should not be freed.
+            It stays valid until the struts, monitors or desktops change, or
+            when @search is given, until screen_area() is next called with a
+            search area.
  */
-Rect* screen_area(guint desktop, guint head, Rect *search);
+const Rect* screen_area(guint desktop, guint head, const Rect *search);
 
 gboolean screen_physical_area_monitor_contains(guint head, Rect *search);
 
@@ -0,0 +1,334 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   spatial.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "spatial.h"
+#include "client.h"
+#include "frame.h"
+#include "stacking.h"
+#include "screen.h"
+#include "window.h"
+
+/* The index is a uniform grid of square cells, one grid per desktop and one
+   for windows on all desktops. Every cell that a frame touches holds an entry
+   for it. The grids are sparse, a hash table holds only the cells that have
+   something in them. */
+
+/*! The size of a cell in pixels, as a power of two */
+#define CELL_SHIFT 8
+/*! Cells are only made this far from the origin in each direction, windows
+  further out than that share the cells at the edge */
+#define CELL_LIMIT 64
+/*! How many bits of a cell's key are used for each coordinate */
+#define CELL_BITS 7
+/*! Desktop numbers are folded into this many bits of a cell's key */
+#define DESK_BITS (32 - 2 * CELL_BITS)
+#define DESK_ALL_KEY ((1u << DESK_BITS) - 1)
+
+typedef struct _ObSpatialEntry ObSpatialEntry;
+
+struct _ObSpatialEntry {
+    ObClient *client;
+    /*! The desktop and area the entry is filed under */
+    guint desktop;
+    Rect area;
+    /*! The client's position in the stacking order, 0 is the top. G_MAXUINT
+      if it is not in the stacking order. */
+    guint order;
+    /*! The last query that found this entry */
+    guint mark;
+};
+
+/*! Maps an ObClient to its ObSpatialEntry */
+static GHashTable *entries = NULL;
+/*! Maps a cell's key to a GSList of the ObSpatialEntry in it */
+static GHashTable *cells = NULL;
+/*! When the stacking order changed since the entries' order was set */
+static gboolean order_dirty = FALSE;
+static guint query_mark = 0;
+
+void spatial_startup(gboolean reconfig)
+{
+    if (reconfig) return;
+
+    entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+    cells = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+static void free_cell(gpointer key, gpointer list, gpointer data)
+{
+    g_slist_free(list);
+}
+
+static void free_entry(gpointer key, gpointer e, gpointer data)
+{
+    g_slice_free(ObSpatialEntry, e);
+}
+
+void spatial_shutdown(gboolean reconfig)
+{
+    if (reconfig) return;
+
+    g_hash_table_foreach(cells, free_cell, NULL);
+    g_hash_table_destroy(cells);
+    cells = NULL;
+    g_hash_table_foreach(entries, free_entry, NULL);
+    g_hash_table_destroy(entries);
+    entries = NULL;
+}
+
+/*! Returns the cell holding the coordinate */
+static gint cell_coord(gint v)
+{
+    /* round towards negative infinity */
+    gint c = v >= 0 ? v >> CELL_SHIFT : -((-(v + 1) >> CELL_SHIFT) + 1);
+    return CLAMP(c, -CELL_LIMIT, CELL_LIMIT - 1);
+}
+
+static guint desk_key(guint desktop)
+{
+    return desktop == DESKTOP_ALL ? DESK_ALL_KEY :
+        MIN(desktop, DESK_ALL_KEY - 1);
+}
+
+static gpointer cell_key(guint dkey, gint cx, gint cy)
+{
+    return GUINT_TO_POINTER((dkey << (2 * CELL_BITS)) |
+                            ((guint)(cx + CELL_LIMIT) << CELL_BITS) |
+                            (guint)(cy + CELL_LIMIT));
+}
+
+/*! Finds the range of cells that a rectangle touches */
+static void cell_range(const Rect *r, gint *x1, gint *y1, gint *x2, gint *y2)
+{
+    *x1 = cell_coord(r->x);
+    *y1 = cell_coord(r->y);
+    *x2 = cell_coord(r->x + MAX(r->width, 1) - 1);
+    *y2 = cell_coord(r->y + MAX(r->height, 1) - 1);
+}
+
+static void entry_file(ObSpatialEntry *e)
+{
+    gint x1, y1, x2, y2, x, y;
+    guint dkey = desk_key(e->desktop);
+
+    cell_range(&e->area, &x1, &y1, &x2, &y2);
+    for (y = y1; y <= y2; ++y)
+        for (x = x1; x <= x2; ++x) {
+            gpointer key = cell_key(dkey, x, y);
+            GSList *list = g_hash_table_lookup(cells, key);
+            g_hash_table_insert(cells, key, g_slist_prepend(list, e));
+        }
+}
+
+static void entry_unfile(ObSpatialEntry *e)
+{
+    gint x1, y1, x2, y2, x, y;
+    guint dkey = desk_key(e->desktop);
+
+    cell_range(&e->area, &x1, &y1, &x2, &y2);
+    for (y = y1; y <= y2; ++y)
+        for (x = x1; x <= x2; ++x) {
+            gpointer key = cell_key(dkey, x, y);
+            GSList *list = g_hash_table_lookup(cells, key);
+
+            list = g_slist_remove(list, e);
+            if (list)
+                g_hash_table_insert(cells, key, list);
+            else
+                g_hash_table_remove(cells, key);
+        }
+}
+
+void spatial_update(ObClient *c)
+{
+    ObSpatialEntry *e;
+
+    /* clients that are being pretend-managed or are on their way out don't
+       take part */
+    if (!entries || !c->managed || !c->frame) return;
+
+    e = g_hash_table_lookup(entries, c);
+    if (e) {
+        if (e->desktop == c->desktop && RECT_EQUAL(e->area, c->frame->area))
+            return;
+        entry_unfile(e);
+    }
+    else {
+        e = g_slice_new(ObSpatialEntry);
+        e->client = c;
+        e->mark = query_mark;
+        /* its place in the stacking order is not known yet */
+        e->order = G_MAXUINT;
+        order_dirty = TRUE;
+        g_hash_table_insert(entries, c, e);
+    }
+
+    e->desktop = c->desktop;
+    e->area = c->frame->area;
+    entry_file(e);
+}
+
+void spatial_remove(ObClient *c)
+{
+    ObSpatialEntry *e;
+
+    if (!entries) return;
+
+    if ((e = g_hash_table_lookup(entries, c))) {
+        entry_unfile(e);
+        g_hash_table_remove(entries, c);
+        g_slice_free(ObSpatialEntry, e);
+    }
+    /* removing something from the stacking order doesn't change the order
+       of the rest of it, so order_dirty can stay as it is */
+}
+
+void spatial_restacked(void)
+{
+    order_dirty = TRUE;
+}
+
+static void reset_order(gpointer key, gpointer e, gpointer data)
+{
+    ((ObSpatialEntry*)e)->order = G_MAXUINT;
+}
+
+/*! Number the entries by their place in the stacking order. This is only done
+  once after each restack, no matter how many queries follow it. */
+static void update_order(void)
+{
+    GList *it;
+    guint i;
+
+    if (!order_dirty) return;
+
+    g_hash_table_foreach(entries, reset_order, NULL);
+    for (i = 0, it = stacking_list; it; it = g_list_next(it))
+        if (WINDOW_IS_CLIENT(it->data)) {
+            ObSpatialEntry *e = g_hash_table_lookup(entries, it->data);
+            if (e) e->order = i++;
+        }
+    order_dirty = FALSE;
+}
+
+/*! Start a new query, after which each entry is only returned once */
+static void begin_query(void)
+{
+    if (++query_mark == 0) {
+        /* wrapped around, the old marks could be mistaken for new ones */
+        GHashTableIter it;
+        gpointer e;
+
+        g_hash_table_iter_init(&it, entries);
+        while (g_hash_table_iter_next(&it, NULL, &e))
+            ((ObSpatialEntry*)e)->mark = 0;
+        query_mark = 1;
+    }
+}
+
+ObClient* spatial_client_at(guint desktop, gint x, gint y,
+                            ObSpatialFilter filter, gpointer data)
+{
+    ObSpatialEntry *best = NULL;
+    guint dkeys[2];
+    guint i, n;
+    gint cx, cy;
+
+    if (!entries) return NULL;
+
+    update_order();
+
+    cx = cell_coord(x);
+    cy = cell_coord(y);
+
+    n = 0;
+    dkeys[n++] = DESK_ALL_KEY;
+    if (desktop != DESKTOP_ALL)
+        dkeys[n++] = desk_key(desktop);
+
+    /* a window is in every cell it touches, so the cell holding the point
+       has every window that can contain it, and each only once */
+    for (i = 0; i < n; ++i) {
+        GSList *it;
+
+        it = g_hash_table_lookup(cells, cell_key(dkeys[i], cx, cy));
+        for (; it; it = g_slist_next(it)) {
+            ObSpatialEntry *e = it->data;
+
+            if ((!best || e->order < best->order) &&
+                e->order != G_MAXUINT &&
+                RECT_CONTAINS(e->area, x, y) &&
+                (!filter || filter(e->client, data)))
+            {
+                best = e;
+            }
+        }
+    }
+    return best ? best->client : NULL;
+}
+
+static gint entry_cmp_order(gconstpointer a, gconstpointer b)
+{
+    const ObSpatialEntry *ea = a, *eb = b;
+    return ea->order < eb->order ? -1 : (ea->order > eb->order ? 1 : 0);
+}
+
+GSList* spatial_clients_near(guint desktop, const Rect *r, gint margin)
+{
+    GSList *found = NULL, *it;
+    Rect q;
+    guint dkeys[2];
+    guint i, n;
+    gint x1, y1, x2, y2, x, y;
+
+    if (!entries) return NULL;
+
+    update_order();
+    begin_query();
+
+    RECT_SET(q, r->x - margin, r->y - margin,
+             MAX(r->width, 1) + margin * 2, MAX(r->height, 1) + margin * 2);
+    cell_range(&q, &x1, &y1, &x2, &y2);
+
+    n = 0;
+    dkeys[n++] = DESK_ALL_KEY;
+    if (desktop != DESKTOP_ALL)
+        dkeys[n++] = desk_key(desktop);
+
+    for (i = 0; i < n; ++i)
+        for (y = y1; y <= y2; ++y)
+            for (x = x1; x <= x2; ++x) {
+                it = g_hash_table_lookup(cells, cell_key(dkeys[i], x, y));
+                for (; it; it = g_slist_next(it)) {
+                    ObSpatialEntry *e = it->data;
+
+                    if (e->mark != query_mark &&
+                        RECT_INTERSECTS_RECT(e->area, q))
+                    {
+                        e->mark = query_mark;
+                        found = g_slist_prepend(found, e);
+                    }
+                }
+            }
+
+    found = g_slist_sort(found, entry_cmp_order);
+    /* hand back the clients instead of the entries */
+    for (it = found; it; it = g_slist_next(it))
+        it->data = ((ObSpatialEntry*)it->data)->client;
+    return found;
+}
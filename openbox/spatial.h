@@ -0,0 +1,55 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   spatial.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef ob__spatial_h
+#define ob__spatial_h
+
+#include "geom.h"
+
+#include <glib.h>
+
+struct _ObClient;
+
+/*! An index of where the managed clients' frames are on each desktop, so that
+  finding the windows at a point or near a rectangle doesn't need to look at
+  every window */
+
+typedef gboolean (*ObSpatialFilter)(struct _ObClient *c, gpointer data);
+
+void spatial_startup(gboolean reconfig);
+void spatial_shutdown(gboolean reconfig);
+
+/*! Bring the client's entry up to date with its frame's area and its
+  desktop. Clients which are not managed are not indexed. */
+void spatial_update(struct _ObClient *c);
+/*! Drop the client from the index */
+void spatial_remove(struct _ObClient *c);
+/*! Tell the index that the stacking order has changed */
+void spatial_restacked(void);
+
+/*! Returns the highest client in the stacking order whose frame contains the
+  point, that is on the desktop (or on all desktops), and for which the
+  filter returns TRUE. The filter may be NULL. */
+struct _ObClient* spatial_client_at(guint desktop, gint x, gint y,
+                                    ObSpatialFilter filter, gpointer data);
+/*! Returns the clients on the desktop (or on all desktops) whose frames come
+  within @margin pixels of the rectangle, ordered from the top of the
+  stacking order to the bottom. The list must be freed with g_slist_free. */
+GSList* spatial_clients_near(guint desktop, const Rect *r, gint margin);
+
+#endif
@@ -28,40 +28,160 @@
 #include "debug.h"
 #include "dock.h"
 #include "config.h"
+#include "spatial.h"
 #include "obt/prop.h"
 
+#include <string.h>
+
 GList  *stacking_list = NULL;
 GList  *stacking_list_tail = NULL;
 /*! When true, stacking changes will not be reflected on the screen.  This is
   to freeze the on-screen stacking order while a window is being temporarily
   raised during focus cycling */
 static gboolean pause_changes = FALSE;
+/*! When true, the stacking list has changed during a client_configure
+  transaction and the windows have not been restacked on the screen yet */
+static gboolean restack_pending = FALSE;
+/*! The highest window of each layer in the stacking_list, or NULL if there
+  are no windows in the layer.  A layer ends where the next non-empty layer
+  below it begins */
+static GList *layer_top[OB_NUM_STACKING_LAYERS];
+/*! The client windows, from bottom to top, as they were last set in the
+  _NET_CLIENT_LIST_STACKING property */
+static GArray *client_stacking = NULL;
+/*! Where the next _NET_CLIENT_LIST_STACKING is built, to be compared with the
+  last one */
+static GArray *client_stacking_next = NULL;
+/*! When true, a client window has moved in the stacking_list since the
+  _NET_CLIENT_LIST_STACKING property was last set */
+static gboolean client_stacking_changed = TRUE;
+
+#define LINK_LAYER(it) (((ObWindow*)(it)->data)->stacking_layer)
+
+/*! Returns the highest window below all the windows in the layer, or NULL
+  if there are no windows in lower layers */
+static GList* layer_end(ObStackingLayer layer)
+{
+    gint i;
+
+    for (i = layer - 1; i > OB_STACKING_LAYER_INVALID; --i)
+        if (layer_top[i]) return layer_top[i];
+    return NULL;
+}
+
+/*! Returns the window to put a window in the layer above, to raise it to the
+  top of the layer */
+static GList* layer_begin(ObStackingLayer layer)
+{
+    return layer_top[layer] ? layer_top[layer] : layer_end(layer);
+}
+
+/*! Puts a window into the stacking_list above the @before node, or at the
+  bottom of the list if @before is NULL.  @before must be in the window's
+  layer, or be the end of it. */
+static void stack_insert(ObWindow *win, GList *before)
+{
+    ObStackingLayer l = window_layer(win);
+
+    g_assert(win->stacking_link == NULL);
+
+    if (before) {
+        stacking_list = g_list_insert_before(stacking_list, before, win);
+        win->stacking_link = g_list_previous(before);
+    }
+    else if (stacking_list_tail) {
+        /* append after the tail instead of walking the list to find it */
+        stacking_list_tail = win->stacking_link =
+            g_list_next(g_list_append(stacking_list_tail, win));
+    }
+    else
+        stacking_list = stacking_list_tail = win->stacking_link =
+            g_list_append(NULL, win);
+
+    win->stacking_layer = l;
+    if (!layer_top[l] || layer_top[l] == before)
+        layer_top[l] = win->stacking_link;
+
+    if (WINDOW_IS_CLIENT(win))
+        client_stacking_changed = TRUE;
+}
+
+/*! Takes a window out of the stacking_list */
+static void stack_remove(ObWindow *win)
+{
+    GList *link = win->stacking_link;
+    ObStackingLayer l = win->stacking_layer;
+
+    g_assert(link != NULL);
+
+    if (layer_top[l] == link) {
+        GList *next = g_list_next(link);
+        layer_top[l] = (next && LINK_LAYER(next) == l) ? next : NULL;
+    }
+    if (stacking_list_tail == link)
+        stacking_list_tail = g_list_previous(link);
+    stacking_list = g_list_delete_link(stacking_list, link);
+    win->stacking_link = NULL;
+
+    if (WINDOW_IS_CLIENT(win))
+        client_stacking_changed = TRUE;
+}
+
+void stacking_remove(ObWindow *win)
+{
+    if (win->stacking_link)
+        stack_remove(win);
+}
+
+GList* stacking_layer_top(ObStackingLayer layer)
+{
+    return layer_top[layer];
+}
 
 void stacking_set_list(void)
 {
-    Window *windows = NULL;
     GList *it;
-    guint i = 0;
+    GArray *t;
+
+    spatial_restacked();
 
     /* on shutdown, don't update the properties, so that we can read it back
        in on startup and re-stack the windows as they were before we shut down
     */
     if (ob_state() == OB_STATE_EXITING) return;
 
+    /* only internal windows moved, the clients are still in the same order */
+    if (!client_stacking_changed) return;
+    client_stacking_changed = FALSE;
+
+    if (!client_stacking) {
+        client_stacking = g_array_new(FALSE, TRUE, sizeof(Window));
+        client_stacking_next = g_array_new(FALSE, TRUE, sizeof(Window));
+        /* make sure the first list is always set */
+        g_array_set_size(client_stacking, 1);
+    }
+    g_array_set_size(client_stacking_next, 0);
+
     /* create an array of the window ids (from bottom to top,
        reverse order!) */
-    if (stacking_list) {
-        windows = g_new(Window, g_list_length(stacking_list));
-        for (it = g_list_last(stacking_list); it; it = g_list_previous(it)) {
-            if (WINDOW_IS_CLIENT(it->data))
-                windows[i++] = WINDOW_AS_CLIENT(it->data)->window;
-        }
-    }
+    for (it = stacking_list_tail; it; it = g_list_previous(it))
+        if (WINDOW_IS_CLIENT(it->data))
+            g_array_append_val(client_stacking_next,
+                               WINDOW_AS_CLIENT(it->data)->window);
+
+    /* a window can be restacked right back where it was */
+    if (client_stacking_next->len == client_stacking->len &&
+        !memcmp(client_stacking_next->data, client_stacking->data,
+                client_stacking->len * sizeof(Window)))
+        return;
 
     OBT_PROP_SETA32(obt_root(ob_screen), NET_CLIENT_LIST_STACKING, WINDOW,
-                    (gulong*)windows, i);
+                    (gulong*)client_stacking_next->data,
+                    client_stacking_next->len);
 
-    g_free(windows);
+    t = client_stacking;
+    client_stacking = client_stacking_next;
+    client_stacking_next = t;
 }
 
 static void do_restack(GList *wins, GList *before)
@@ -81,7 +201,7 @@ static void do_restack(GList *wins, GList *before)
         g_assert (window_layer(it->data) == window_layer(next->data));
     }
     if (before)
-        g_assert(window_layer(it->data) >= window_layer(before->data));
+        g_assert(window_layer(it->data) >= LINK_LAYER(before));
 #endif
 
     win = g_new(Window, g_list_length(wins) + 1);
@@ -89,7 +209,7 @@ static void do_restack(GList *wins, GList *before)
     if (before == stacking_list)
         win[0] = screen_support_win;
     else if (!before)
-        win[0] = window_top(g_list_last(stacking_list)->data);
+        win[0] = window_top(stacking_list_tail->data);
     else
         win[0] = window_top(g_list_previous(before)->data);
 
@@ -97,7 +217,7 @@ static void do_restack(GList *wins, GList *before)
         win[i] = window_top(it->data);
         g_assert(win[i] != None); /* better not call stacking shit before
                                      setting your top level window value */
-        stacking_list = g_list_insert_before(stacking_list, before, it->data);
+        stack_insert(it->data, before);
     }
 
 #ifdef DEBUG
@@ -105,15 +225,23 @@ static void do_restack(GList *wins, GList *before)
     for (it = stacking_list; ; it = next) {
         next = g_list_next(it);
         if (!next) break;
-        g_assert(window_layer(it->data) >= window_layer(next->data));
+        g_assert(LINK_LAYER(it) >= LINK_LAYER(next));
+        g_assert(LINK_LAYER(it) == LINK_LAYER(next) ||
+                 layer_top[LINK_LAYER(next)] == next);
     }
 #endif
 
-    if (!pause_changes)
-        XRestackWindows(obt_display, win, i);
+    if (client_configure_batching()) {
+        /* the whole list is restacked once when the transaction commits */
+        restack_pending = TRUE;
+        spatial_restacked();
+    }
+    else {
+        if (!pause_changes)
+            XRestackWindows(obt_display, win, i);
+        stacking_set_list();
+    }
     g_free(win);
-
-    stacking_set_list();
 }
 
 void stacking_temp_raise(ObWindow *window)
@@ -143,7 +271,7 @@ void stacking_temp_raise(ObWindow *window)
     pause_changes = TRUE;
 }
 
-void stacking_restore(void)
+static void restack_all(void)
 {
     Window *win;
     GList *it;
@@ -158,10 +286,24 @@ void stacking_restore(void)
     XRestackWindows(obt_display, win, i);
     event_end_ignore_all_enters(start);
     g_free(win);
+}
 
+void stacking_restore(void)
+{
+    restack_all();
     pause_changes = FALSE;
 }
 
+void stacking_commit(void)
+{
+    if (!restack_pending) return;
+    restack_pending = FALSE;
+
+    if (!pause_changes)
+        restack_all();
+    stacking_set_list();
+}
+
 static void do_raise(GList *wins)
 {
     GList *it;
@@ -175,15 +317,10 @@ static void do_raise(GList *wins)
         layer[l] = g_list_append(layer[l], it->data);
     }
 
-    it = stacking_list;
     for (i = OB_NUM_STACKING_LAYERS - 1; i >= 0; --i) {
         if (layer[i]) {
-            for (; it; it = g_list_next(it)) {
-                /* look for the top of the layer */
-                if (window_layer(it->data) <= (ObStackingLayer) i)
-                    break;
-            }
-            do_restack(layer[i], it);
+            /* put them above the top of the layer */
+            do_restack(layer[i], layer_begin(i));
             g_list_free(layer[i]);
         }
     }
@@ -202,15 +339,10 @@ static void do_lower(GList *wins)
         layer[l] = g_list_append(layer[l], it->data);
     }
 
-    it = stacking_list;
     for (i = OB_NUM_STACKING_LAYERS - 1; i >= 0; --i) {
         if (layer[i]) {
-            for (; it; it = g_list_next(it)) {
-                /* look for the top of the next layer down */
-                if (window_layer(it->data) < (ObStackingLayer) i)
-                    break;
-            }
-            do_restack(layer[i], it);
+            /* put them above the top of the next layer down */
+            do_restack(layer[i], layer_end(i));
             g_list_free(layer[i]);
         }
     }
@@ -218,7 +350,7 @@ static void do_lower(GList *wins)
 
 static void restack_windows(ObClient *selected, gboolean raise)
 {
-    GList *it, *last, *below, *above, *next;
+    GList *it, *below, *above, *next;
     GList *wins = NULL;
 
     GList *group_helpers = NULL;
@@ -237,14 +369,16 @@ static void restack_windows(ObClient *selected, gboolean raise)
     }
 
     /* remove first so we can't run into ourself */
-    it = g_list_find(stacking_list, selected);
-    g_assert(it);
-    stacking_list = g_list_delete_link(stacking_list, it);
-
-    /* go from the bottom of the stacking list up. don't move any other windows
-       when lowering, we call this for each window independently */
-    if (raise) {
-        for (it = g_list_last(stacking_list); it; it = next) {
+    stacking_remove(CLIENT_AS_WINDOW(selected));
+
+    /* go from the bottom of the selected window's layer up, only windows in
+       the same layer are moved. don't move any other windows when lowering,
+       we call this for each window independently. without transients there
+       is nothing to look for */
+    if (raise && selected->transients) {
+        it = layer_end(selected->layer);
+        it = it ? g_list_previous(it) : stacking_list_tail;
+        for (; it && LINK_LAYER(it) == selected->layer; it = next) {
             next = g_list_previous(it);
 
             if (WINDOW_IS_CLIENT(it->data)) {
@@ -275,7 +409,7 @@ static void restack_windows(ObClient *selected, gboolean raise)
                         else
                             group_trans = g_list_prepend(group_trans, ch);
                     }
-                    stacking_list = g_list_delete_link(stacking_list, it);
+                    stack_remove(it->data);
                 }
             }
         }
@@ -301,35 +435,16 @@ static void restack_windows(ObClient *selected, gboolean raise)
         group_trans = NULL;
     }
 
-    /* find where to put the selected window, start from bottom of list,
-       this is the window below everything we are re-adding to the list */
-    last = NULL;
-    for (it = g_list_last(stacking_list); it; it = g_list_previous(it))
-    {
-        if (window_layer(it->data) < selected->layer) {
-            last = it;
-            continue;
-        }
-        /* if lowering, stop at the beginning of the layer */
-        if (!raise)
-            break;
-        /* if raising, stop at the end of the layer */
-        if (window_layer(it->data) > selected->layer)
-            break;
-
-        last = it;
-    }
-
-    /* save this position in the stacking list */
-    below = last;
+    /* find where to put the selected window, this is the window below
+       everything we are re-adding to the list. if raising, it is the top of
+       the layer, and if lowering, the end of it */
+    below = raise ? layer_begin(selected->layer) : layer_end(selected->layer);
 
-    /* find where to put the group transients, start from the top of list */
-    for (it = stacking_list; it; it = g_list_next(it)) {
-        /* skip past higher layers */
-        if (window_layer(it->data) > selected->layer)
-            continue;
-        /* if we reach the end of the layer (how?) then don't go further */
-        if (window_layer(it->data) < selected->layer)
+    /* find where to put the group transients, start from the top of the
+       layer */
+    for (it = layer_begin(selected->layer); it; it = g_list_next(it)) {
+        /* if we reach the end of the layer then don't go further */
+        if (LINK_LAYER(it) < selected->layer)
             break;
         /* stop when we reach the first window in the group */
         if (WINDOW_IS_CLIENT(it->data)) {
@@ -350,17 +465,17 @@ static void restack_windows(ObClient *selected, gboolean raise)
        we actually want to save 1 position _above_ that, for for loops to work
        nicely, so move back one position in the list while saving it
     */
-    above = it ? g_list_previous(it) : g_list_last(stacking_list);
+    above = it ? g_list_previous(it) : stacking_list_tail;
 
     /* put the windows inside the gap to the other windows we're stacking
        into the restacking list, go from the bottom up so that we can use
        g_list_prepend */
     if (below) it = g_list_previous(below);
-    else       it = g_list_last(stacking_list);
+    else       it = stacking_list_tail;
     for (; it != above; it = next) {
         next = g_list_previous(it);
         wins = g_list_prepend(wins, it->data);
-        stacking_list = g_list_delete_link(stacking_list, it);
+        stack_remove(it->data);
     }
 
     /* group transients go above the rest of the stuff acquired to now */
@@ -379,7 +494,7 @@ static void restack_windows(ObClient *selected, gboolean raise)
         parents_copy = g_slist_copy(selected->parents);
 
         /* go thru stacking list backwards so we can use g_slist_prepend */
-        for (it = g_list_last(stacking_list); it && parents_copy;
+        for (it = stacking_list_tail; it && parents_copy;
              it = g_list_previous(it))
             if ((sit = g_slist_find(parents_copy, it->data))) {
                 reorder = g_slist_prepend(reorder, sit->data);
@@ -402,11 +517,10 @@ void stacking_raise(ObWindow *window)
     } else {
         GList *wins;
         wins = g_list_append(NULL, window);
-        stacking_list = g_list_remove(stacking_list, window);
+        stacking_remove(window);
         do_raise(wins);
         g_list_free(wins);
     }
-    stacking_list_tail = g_list_last(stacking_list);
 }
 
 void stacking_lower(ObWindow *window)
@@ -418,26 +532,24 @@ void stacking_lower(ObWindow *window)
     } else {
         GList *wins;
         wins = g_list_append(NULL, window);
-        stacking_list = g_list_remove(stacking_list, window);
+        stacking_remove(window);
         do_lower(wins);
         g_list_free(wins);
     }
-    stacking_list_tail = g_list_last(stacking_list);
 }
 
 void stacking_below(ObWindow *window, ObWindow *below)
 {
     GList *wins, *before;
 
-    if (window_layer(window) != window_layer(below))
+    if (window_layer(window) != window_layer(below) || !below->stacking_link)
         return;
 
     wins = g_list_append(NULL, window);
-    stacking_list = g_list_remove(stacking_list, window);
-    before = g_list_next(g_list_find(stacking_list, below));
+    stacking_remove(window);
+    before = g_list_next(below->stacking_link);
     do_restack(wins, before);
     g_list_free(wins);
-    stacking_list_tail = g_list_last(stacking_list);
 }
 
 void stacking_add(ObWindow *win)
@@ -447,10 +559,8 @@ void stacking_add(ObWindow *win)
     /* don't add windows that are being unmanaged ! */
     if (WINDOW_IS_CLIENT(win)) g_assert(WINDOW_AS_CLIENT(win)->managed);
 
-    stacking_list = g_list_append(stacking_list, win);
-
+    /* the window is put into the stacking list at the top of its layer */
     stacking_raise(win);
-    /* stacking_list_tail set by stacking_raise() */
 }
 
 static GList *find_highest_relative(ObClient *client)
@@ -459,13 +569,16 @@ static GList *find_highest_relative(ObClient *client)
 
     if (client->parents) {
         GList *it;
-        GSList *top;
+        const GSList *top;
 
         /* get all top level relatives of this client */
         top = client_search_all_top_parents_layer(client);
 
-        /* go from the top of the stacking order down */
-        for (it = stacking_list; !ret && it; it = g_list_next(it)) {
+        /* go from the top of the client's layer down */
+        for (it = layer_top[client->layer];
+             !ret && it && LINK_LAYER(it) == client->layer;
+             it = g_list_next(it))
+        {
             if (WINDOW_IS_CLIENT(it->data)) {
                 ObClient *c = it->data;
                 /* only look at windows in the same layer and that are
@@ -476,7 +589,7 @@ static GList *find_highest_relative(ObClient *client)
                      c->desktop == DESKTOP_ALL ||
                      client->desktop == DESKTOP_ALL))
                 {
-                    GSList *sit;
+                    const GSList *sit;
 
                     /* go through each top level parent and see it this window
                        is related to them */
@@ -498,7 +611,6 @@ void stacking_add_nonintrusive(ObWindow *win)
 {
     ObClient *client;
     GList *it_below = NULL; /* this client will be below us */
-    GList *it_above;
     GList *wins;
 
     if (!WINDOW_IS_CLIENT(win)) {
@@ -520,7 +632,7 @@ void stacking_add_nonintrusive(ObWindow *win)
         if (focus_client && client != focus_client &&
             focus_client->layer == client->layer)
         {
-            it_below = g_list_find(stacking_list, focus_client);
+            it_below = CLIENT_AS_WINDOW(focus_client)->stacking_link;
             /* this can give NULL, but it means the focused window is on the
                bottom of the stacking order, so go to the bottom in that case,
                below it */
@@ -545,25 +657,18 @@ void stacking_add_nonintrusive(ObWindow *win)
     }
 
     /* make sure it's not in the wrong layer though ! */
-    for (; it_below; it_below = g_list_next(it_below)) {
-        /* stop when the window is not in a higher layer than the window
-           it is going above (it_below) */
-        if (client->layer >= window_layer(it_below->data))
-            break;
-    }
-    for (; it_below != stacking_list; it_below = it_above) {
-        /* stop when the window is not in a lower layer than the
-           window it is going under (it_above) */
-        it_above = it_below ?
-            g_list_previous(it_below) : g_list_last(stacking_list);
-        if (client->layer <= window_layer(it_above->data))
-            break;
-    }
+    if (it_below && LINK_LAYER(it_below) > client->layer)
+        /* it would be going under a window in a higher layer, so put it at
+           the top of its own layer instead */
+        it_below = layer_begin(client->layer);
+    else if (!it_below || LINK_LAYER(it_below) < client->layer)
+        /* it would be going above a window in a lower layer, so put it at
+           the bottom of its own layer instead */
+        it_below = layer_end(client->layer);
 
     wins = g_list_append(NULL, win);
     do_restack(wins, it_below);
     g_list_free(wins);
-    stacking_list_tail = g_list_last(stacking_list);
 }
 
 /*! Returns TRUE if client is occluded by the sibling. If sibling is NULL it
@@ -582,7 +687,7 @@ static gboolean stacking_occluded(ObClient *client, ObWindow *sibling_win)
     if (sibling && client->layer != sibling->layer)
         return FALSE;
 
-    for (it = g_list_previous(g_list_find(stacking_list, client)); it;
+    for (it = g_list_previous(CLIENT_AS_WINDOW(client)->stacking_link); it;
          it = g_list_previous(it))
         if (WINDOW_IS_CLIENT(it->data)) {
             ObClient *c = it->data;
@@ -642,7 +747,7 @@ static gboolean stacking_occludes(ObClient *client, ObWindow *sibling_win)
     if (sibling && client->layer != sibling->layer)
         return FALSE;
 
-    for (it = g_list_next(g_list_find(stacking_list, client));
+    for (it = g_list_next(CLIENT_AS_WINDOW(client)->stacking_link);
          it; it = g_list_next(it))
         if (WINDOW_IS_CLIENT(it->data)) {
             ObClient *c = it->data;
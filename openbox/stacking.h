@@ -38,7 +38,9 @@ typedef enum {
     OB_NUM_STACKING_LAYERS
 } ObStackingLayer;
 
-/* list of ObWindow*s in stacking order from highest to lowest */
+/* list of ObWindow*s in stacking order from highest to lowest.  the windows
+   in each layer are kept together, and each window holds its own node in the
+   list, so they should only be moved with the functions below */
 extern GList *stacking_list;
 /* list of ObWindow*s in stacking order from lowest to highest */
 extern GList *stacking_list_tail;
@@ -49,7 +51,13 @@ void stacking_set_list(void);
 
 void stacking_add(struct _ObWindow *win);
 void stacking_add_nonintrusive(struct _ObWindow *win);
-#define stacking_remove(win) stacking_list = g_list_remove(stacking_list, win);
+/*! Removes a window from the stacking list, if it is in it */
+void stacking_remove(struct _ObWindow *win);
+
+/*! Returns the highest window in the layer, in the stacking_list, or NULL if
+  the layer is empty.  The windows below it in the layer follow it in the
+  list */
+GList* stacking_layer_top(ObStackingLayer layer);
 
 /*! Raises a window above all others in its stacking layer */
 void stacking_raise(struct _ObWindow *window);
@@ -60,6 +68,10 @@ void stacking_temp_raise(struct _ObWindow *window);
 /*! Restores any temporarily raised windows to their correct place */
 void stacking_restore(void);
 
+/*! Restacks the windows on the screen if the stacking list was changed
+  during a client_configure transaction */
+void stacking_commit(void);
+
 /*! Lowers a window below all others in its stacking layer */
 void stacking_lower(struct _ObWindow *window);
 
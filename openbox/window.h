@@ -39,6 +39,11 @@ typedef enum {
    struct */
 struct _ObWindow {
     ObWindowClass type;
+    /*! The window's node in the stacking_list, or NULL when it is not in the
+      list */
+    GList *stacking_link;
+    /*! The layer the window was in when it was put in the stacking_list */
+    ObStackingLayer stacking_layer;
 };
 
 #define WINDOW_IS_MENUFRAME(win) \
@@ -82,7 +87,7 @@ void      window_remove(Window xwin);
 
 /* Internal openbox-owned windows like the alt-tab popup */
 struct _ObInternalWindow {
-    ObWindowClass type;
+    ObWindow obwin;
     Window window;
 };
 